@@ -360,14 +360,22 @@ biquad_filter_reset (BseModule *module)
   gsl_biquad_filter_config (&fmod->biquad, &fmod->config, TRUE);
 }
 
+typedef struct {
+  FilterModule *fmod;
+  const gfloat *audio_in;
+  const gfloat *gain_in;        /* NULL without gain modulation */
+  gfloat       *sig_out;        /* holds frequency signal if sig_out_as_freq */
+  gboolean      sig_out_as_freq;
+  gfloat        last_freq, last_gain, inv_nyquist;
+} FilterLane;
+
 static void
-biquad_filter_process (BseModule *module,
-		       guint      n_values)
+biquad_filter_lane_setup (FilterLane *lane,
+                          BseModule  *module,
+                          guint       n_values)
 {
   FilterModule *fmod = (FilterModule*) module->user_data;
-  const gfloat *audio_in = BSE_MODULE_IBUFFER (module, BSE_BIQUAD_FILTER_ICHANNEL_AUDIO);
   gfloat *sig_out = BSE_MODULE_OBUFFER (module, BSE_BIQUAD_FILTER_OCHANNEL_AUDIO);
-  gfloat *bound = sig_out + n_values;
   gboolean sig_out_as_freq = TRUE;
 
   if (BSE_MODULE_ISTREAM (module, BSE_BIQUAD_FILTER_ICHANNEL_FREQ).connected &&
@@ -392,87 +400,92 @@ biquad_filter_process (BseModule *module,
   else
     sig_out_as_freq = FALSE;
 
-  if (BSE_MODULE_ISTREAM (module, BSE_BIQUAD_FILTER_ICHANNEL_GAIN_MOD).connected && sig_out_as_freq)
+  lane->fmod = fmod;
+  lane->audio_in = BSE_MODULE_IBUFFER (module, BSE_BIQUAD_FILTER_ICHANNEL_AUDIO);
+  lane->sig_out = sig_out;
+  lane->sig_out_as_freq = sig_out_as_freq;
+  lane->gain_in = NULL;
+  if (BSE_MODULE_ISTREAM (module, BSE_BIQUAD_FILTER_ICHANNEL_GAIN_MOD).connected)
     {
-      const gfloat *gain_in = BSE_MODULE_IBUFFER (module, BSE_BIQUAD_FILTER_ICHANNEL_GAIN_MOD);
-      gfloat freq, nyquist = 0.5 * bse_engine_sample_freq ();
-      gfloat last_gain = fmod->config.gain / fmod->gain_strength;
-      gfloat last_freq = BSE_SIGNAL_FROM_FREQ (fmod->config.f_fn * nyquist);
-      nyquist = 1.0 / nyquist;
-      do
-	{
-	  guint n = MIN (bound - sig_out, bse_engine_control_raster ());
-
-	  if (UNLIKELY (BSE_SIGNAL_FREQ_CHANGED (*sig_out, last_freq)))
-	    {
-	      last_freq = *sig_out;
-	      freq = BSE_SIGNAL_TO_FREQ (last_freq) * nyquist;
-	      gsl_biquad_config_approx_freq (&fmod->config, CLAMP (freq, 0.0, 1.0));
-	      if (BSE_SIGNAL_GAIN_CHANGED (*gain_in, last_gain))
-		{
-		  last_gain = *gain_in;
-		  gsl_biquad_config_approx_gain (&fmod->config, fmod->gain * (1.0 + last_gain * fmod->gain_strength));
-		}
-	      gsl_biquad_filter_config (&fmod->biquad, &fmod->config, FALSE);
-	    }
-	  else if (UNLIKELY (BSE_SIGNAL_GAIN_CHANGED (*gain_in, last_gain)))
-	    {
-	      last_gain = *gain_in;
-	      gsl_biquad_config_approx_gain (&fmod->config, fmod->gain * (1.0 + last_gain * fmod->gain_strength));
-	      gsl_biquad_filter_config (&fmod->biquad, &fmod->config, FALSE);
-	    }
-	  gain_in += n;
-	  gsl_biquad_filter_eval (&fmod->biquad, n, audio_in, sig_out);
-	  audio_in += n;
-	  sig_out += n;
-	}
-      while (sig_out < bound);
+      lane->gain_in = BSE_MODULE_IBUFFER (module, BSE_BIQUAD_FILTER_ICHANNEL_GAIN_MOD);
+      lane->last_gain = fmod->config.gain / fmod->gain_strength;
     }
-  else if (sig_out_as_freq)
+  if (sig_out_as_freq)
     {
-      gfloat freq, nyquist = 0.5 * bse_engine_sample_freq ();
-      gfloat last_freq = BSE_SIGNAL_FROM_FREQ (fmod->config.f_fn * nyquist);
-      nyquist = 1.0 / nyquist;
-      do
-	{
-          guint n = MIN (bound - sig_out, bse_engine_control_raster ());
-
-          if (UNLIKELY (BSE_SIGNAL_FREQ_CHANGED (*sig_out, last_freq)))
-	    {
-	      last_freq = *sig_out;
-	      freq = BSE_SIGNAL_TO_FREQ (last_freq) * nyquist;
-	      gsl_biquad_config_approx_freq (&fmod->config, CLAMP (freq, 0.0, 1.0));
-	      gsl_biquad_filter_config (&fmod->biquad, &fmod->config, FALSE);
-	    }
-	  gsl_biquad_filter_eval (&fmod->biquad, n, audio_in, sig_out);
-	  audio_in += n;
-	  sig_out += n;
-	}
-      while (sig_out < bound);
+      gfloat nyquist = 0.5 * bse_engine_sample_freq ();
+      lane->last_freq = BSE_SIGNAL_FROM_FREQ (fmod->config.f_fn * nyquist);
+      lane->inv_nyquist = 1.0 / nyquist;
     }
-  else if (BSE_MODULE_ISTREAM (module, BSE_BIQUAD_FILTER_ICHANNEL_GAIN_MOD).connected)
+}
+
+/* reconfigure filter from the modulation signals at the start of a control raster chunk */
+static void
+biquad_filter_lane_update (FilterLane *lane,
+                           guint       offset)
+{
+  FilterModule *fmod = lane->fmod;
+  gboolean changed = FALSE;
+
+  if (lane->sig_out_as_freq && UNLIKELY (BSE_SIGNAL_FREQ_CHANGED (lane->sig_out[offset], lane->last_freq)))
     {
-      const gfloat *gain_in = BSE_MODULE_IBUFFER (module, BSE_BIQUAD_FILTER_ICHANNEL_GAIN_MOD);
-      gfloat last_gain = fmod->config.gain / fmod->gain_strength;
-      do
-	{
-          guint n = MIN (bound - sig_out, bse_engine_control_raster ());
-
-	  if (UNLIKELY (BSE_SIGNAL_GAIN_CHANGED (*gain_in, last_gain)))
-	    {
-	      last_gain = *gain_in;
-              gsl_biquad_config_approx_gain (&fmod->config, fmod->gain * (1.0 + last_gain * fmod->gain_strength));
-	      gsl_biquad_filter_config (&fmod->biquad, &fmod->config, FALSE);
-	    }
-	  gain_in += n;
-	  gsl_biquad_filter_eval (&fmod->biquad, n, audio_in, sig_out);
-	  audio_in += n;
-	  sig_out += n;
-	}
-      while (sig_out < bound);
+      lane->last_freq = lane->sig_out[offset];
+      gfloat freq = BSE_SIGNAL_TO_FREQ (lane->last_freq) * lane->inv_nyquist;
+      gsl_biquad_config_approx_freq (&fmod->config, CLAMP (freq, 0.0, 1.0));
+      changed = TRUE;
     }
-  else
-    gsl_biquad_filter_eval (&fmod->biquad, n_values, audio_in, sig_out);
+  if (lane->gain_in && UNLIKELY (BSE_SIGNAL_GAIN_CHANGED (lane->gain_in[offset], lane->last_gain)))
+    {
+      lane->last_gain = lane->gain_in[offset];
+      gsl_biquad_config_approx_gain (&fmod->config, fmod->gain * (1.0 + lane->last_gain * fmod->gain_strength));
+      changed = TRUE;
+    }
+  if (changed)
+    gsl_biquad_filter_config (&fmod->biquad, &fmod->config, FALSE);
+}
+
+static void
+biquad_filter_process_lanes (BseModule **modules,
+                             guint       n_modules,
+                             guint       n_values)
+{
+  FilterLane lanes[BSE_ENGINE_MAX_LANES];
+  GslBiquadFilter *filters[BSE_ENGINE_MAX_LANES];
+  const gfloat *audio_in[BSE_ENGINE_MAX_LANES];
+  gfloat *sig_out[BSE_ENGINE_MAX_LANES];
+  gboolean modulated = FALSE;
+  guint l, offset;
+
+  assert_return (n_modules <= BSE_ENGINE_MAX_LANES);
+  for (l = 0; l < n_modules; l++)
+    {
+      biquad_filter_lane_setup (&lanes[l], modules[l], n_values);
+      filters[l] = &lanes[l].fmod->biquad;
+      modulated |= lanes[l].sig_out_as_freq || lanes[l].gain_in;
+    }
+  /* modulated filters are reconfigured once per control raster */
+  const guint raster = modulated ? bse_engine_control_raster () : n_values;
+  for (offset = 0; offset < n_values; offset += raster)
+    {
+      const guint n = MIN (n_values - offset, raster);
+      for (l = 0; l < n_modules; l++)
+        {
+          if (modulated)
+            biquad_filter_lane_update (&lanes[l], offset);
+          audio_in[l] = lanes[l].audio_in + offset;
+          sig_out[l] = lanes[l].sig_out + offset;
+        }
+      if (n_modules > 1)
+        gsl_biquad_filter_eval_lanes (n_modules, filters, n, audio_in, sig_out);
+      else
+        gsl_biquad_filter_eval (filters[0], n, audio_in[0], sig_out[0]);
+    }
+}
+
+static void
+biquad_filter_process (BseModule *module,
+		       guint      n_values)
+{
+  biquad_filter_process_lanes (&module, 1, n_values);
 }
 
 static void
@@ -489,6 +502,7 @@ bse_biquad_filter_context_create (BseSource *source,
     biquad_filter_reset,		/* reset */
     (BseModuleFreeFunc) g_free,		/* free */
     Bse::ModuleFlag::NORMAL,			/* flags */
+    biquad_filter_process_lanes,	/* process_lanes */
   };
   BseBiquadFilter *self = BSE_BIQUAD_FILTER (source);
   FilterModule *fmod = g_new0 (FilterModule, 1);
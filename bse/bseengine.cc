@@ -6,6 +6,7 @@
 #include "bseenginemaster.hh"
 #include "bseengineprivate.hh"
 #include "bsestartup.hh"        // for TaskRegistry
+#include "enginecapture.hh"
 #include "bse/internal.hh"
 #include <fcntl.h>
 #include <errno.h>
@@ -28,7 +29,7 @@ namespace Bse {
 Module::Module (const BseModuleClass &_klass) :
   klass (_klass), n_istreams (_klass.n_istreams), n_jstreams (_klass.n_jstreams), n_ostreams (_klass.n_ostreams),
   integrated (false), is_consumer (0), update_suspend (0), in_suspend_call (0), needs_reset (0),
-  cleared_ostreams (0), sched_tag (0), sched_recurse_tag (0)
+  cleared_ostreams (0), sched_tag (0), sched_recurse_tag (0), lane_leader (0)
 {
   this->istreams = BSE_MODULE_N_ISTREAMS (this) ? sfi_new_struct0 (Bse::IStream, BSE_MODULE_N_ISTREAMS (this)) : NULL;
   this->jstreams = BSE_MODULE_N_JSTREAMS (this) ? sfi_new_struct0 (Bse::JStream, BSE_MODULE_N_JSTREAMS (this)) : NULL;
@@ -1015,6 +1016,19 @@ bse_trans_commit (BseTrans *trans)
   assert_return (trans->comitted == FALSE, 0);
 
   guint64 exec_tick_stamp = 0;
+  if (trans->jobs_head && Bse::EngineCapture::active())
+    {
+      Bse::EngineCapture::Record rec;
+      rec.kind = Bse::EngineCapture::Kind::TRANS;
+      rec.channel = uint8 (Bse::EngineCapture::origin());
+      rec.stamp = Bse::TickStamp::current();
+      for (BseJob *job = trans->jobs_head; job; job = job->next)
+        {
+          rec.id16 += 1;
+          rec.key |= uint64 (1) << job->job_id;
+        }
+      Bse::EngineCapture::record (rec);
+    }
   if (trans->jobs_head)
     {
       trans->comitted = TRUE;
@@ -1160,6 +1174,33 @@ virtual_module_free (gpointer        data,
   g_free (vclass);
 }
 
+static BseModule*
+module_new_virtual (guint n_iostreams, gpointer user_data, BseFreeFunc free_data, Bse::ModuleFlag mflags)
+{
+  VirtualModuleClass virtual_module_class = {
+    {
+      0,			/* n_istreams */
+      0,			/* n_jstreams */
+      0,			/* n_ostreams */
+      virtual_module_process,	/* process */
+      NULL,			/* process_defer */
+      NULL,			/* reset */
+      virtual_module_free,	/* free */
+      Bse::ModuleFlag (size_t (Bse::ModuleFlag::CHEAP) | size_t (Bse::ModuleFlag::VIRTUAL_) | size_t (mflags))
+    },
+    NULL,			/* free_data */
+  };
+  VirtualModuleClass *vclass;
+  BseModule *module;
+  assert_return (n_iostreams > 0, NULL);
+  vclass = (VirtualModuleClass*) g_memdup (&virtual_module_class, sizeof (virtual_module_class));
+  vclass->klass.n_istreams = n_iostreams;
+  vclass->klass.n_ostreams = n_iostreams;
+  vclass->free_data = free_data;
+  module = bse_module_new (&vclass->klass, user_data);
+  return module;
+}
+
 /**
  * @param n_iostreams	number of input and output streams
  * @param user_data	user data, stored in module->user_data
@@ -1194,28 +1235,26 @@ bse_module_new_virtual (guint       n_iostreams,
 			gpointer    user_data,
 			BseFreeFunc free_data)
 {
-  VirtualModuleClass virtual_module_class = {
-    {
-      0,			/* n_istreams */
-      0,			/* n_jstreams */
-      0,			/* n_ostreams */
-      virtual_module_process,	/* process */
-      NULL,			/* process_defer */
-      NULL,			/* reset */
-      virtual_module_free,	/* free */
-      Bse::ModuleFlag (size_t (Bse::ModuleFlag::CHEAP) | size_t (Bse::ModuleFlag::VIRTUAL_))
-    },
-    NULL,			/* free_data */
-  };
-  VirtualModuleClass *vclass;
-  BseModule *module;
-  assert_return (n_iostreams > 0, NULL);
-  vclass = (VirtualModuleClass*) g_memdup (&virtual_module_class, sizeof (virtual_module_class));
-  vclass->klass.n_istreams = n_iostreams;
-  vclass->klass.n_ostreams = n_iostreams;
-  vclass->free_data = free_data;
-  module = bse_module_new (&vclass->klass, user_data);
-  return module;
+  return module_new_virtual (n_iostreams, user_data, free_data, Bse::ModuleFlag::NORMAL);
+}
+
+/**
+ * @param n_iostreams	number of input and output streams
+ * @return		a newly created module
+ *
+ * Create a new virtual module that stands in for the input or
+ * output port of a synthesis network.
+ * Port modules are resolved like virtual modules during scheduling,
+ * so nested networks end up as direct connections between real
+ * processing modules. Unlike other virtual modules, ports always
+ * yield connected input streams, even if nothing feeds into the
+ * port, in which case the consumer receives silence.
+ * This function is MT-safe and may be called from any thread.
+ */
+BseModule*
+bse_module_new_port (guint n_iostreams)
+{
+  return module_new_virtual (n_iostreams, NULL, NULL, Bse::ModuleFlag::PORT_);
 }
 
 /* --- setup & trigger --- */
@@ -6,6 +6,7 @@
 
 /* --- constants --- */
 #define BSE_ENGINE_MAX_BLOCK_SIZE               (128)
+#define BSE_ENGINE_MAX_LANES                    (8)     /* modules per process_lanes() call */
 #define BSE_MODULE_N_OSTREAMS(module)           ((module)->n_ostreams)
 #define BSE_MODULE_N_ISTREAMS(module)           ((module)->n_istreams)
 #define BSE_MODULE_N_JSTREAMS(module)           ((module)->n_jstreams)
@@ -43,6 +44,9 @@ typedef void     (*BseProcessFunc)      (BseModule     *module,
 typedef guint    (*BseProcessDeferFunc) (BseModule     *module,
                                          guint          n_ivalues,
                                          guint          n_ovalues);
+typedef void     (*BseProcessLanesFunc) (BseModule    **modules,
+                                         guint          n_modules,
+                                         guint          n_values);
 typedef void     (*BseModuleResetFunc)  (BseModule     *module);
 typedef void     (*BseModuleFreeFunc)   (gpointer        data,
                                          const BseModuleClass *klass);
@@ -53,9 +57,18 @@ enum class ModuleFlag {
   NORMAL        = 0,      ///< Nutral flag
   CHEAP         = 1 << 0, ///< Very short or NOP as process() function
   EXPENSIVE     = 1 << 1, ///< Indicate lengthy process() functio
+  SHEDDABLE     = 1 << 2, ///< Processing may be skipped when the DSP budget is exceeded
+  PORT_         = 1 << 6, ///< Flag used internally
   VIRTUAL_      = 1 << 7, ///< Flag used internally
 };
 
+/// Priority classes for graceful degradation when the DSP budget is exceeded.
+enum class DspPriority {
+  ESSENTIAL     = 0,      ///< Always processed at full quality
+  REDUCIBLE     = 1,      ///< May lower quality under load, e.g. oversampling or unison voices
+  SHEDDABLE     = 2,      ///< May be skipped under load, e.g. meters, scopes, analyzers and signal probes
+};
+
 // streams, constructed by engine
 struct JStream {
   const float **values;
@@ -84,6 +97,8 @@ struct BseModuleClass {
   BseModuleResetFunc  reset;            // EngineThread
   BseModuleFreeFunc   free;             // UserThread
   Bse::ModuleFlag     mflags;
+  BseProcessLanesFunc process_lanes;    // EngineThread, optional, processes modules of this class in SIMD lanes,
+                                        // pays off for per sample recursions like filters and oscillators
 };
 
 /* --- interface (UserThread functions) --- */
@@ -92,6 +107,7 @@ BseModule* bse_module_new               (const BseModuleClass *klass,
 BseModule* bse_module_new_virtual       (guint                 n_iostreams,
                                          gpointer              user_data,
                                          BseFreeFunc           free_data);
+BseModule* bse_module_new_port          (guint                 n_iostreams);
 guint64    bse_module_tick_stamp        (BseModule            *module);
 gboolean   bse_module_has_source        (BseModule            *module,
                                          guint                 istream);
@@ -188,6 +204,25 @@ void       bse_engine_update_block_size       (uint new_block_size);
 #define    bse_engine_control_raster()        (32) // legacy value
 #define    BSE_CONTROL_CHECK(index)           ((bse_engine_control_mask() & (index)) == 0)
 
+/* --- DSP budget --- */
+struct BseEngineBudget {
+  double  load = 0;             /* average fraction of block time spent processing */
+  double  peak_load = 0;        /* decaying peak of the block load */
+  double  voice_fraction = 1;   /* fraction of configured voices allocators may use */
+  guint64 reductions = 0;       /* number of times the voice caps were lowered */
+  guint64 raises = 0;           /* number of times the voice caps were raised */
+  guint64 stolen_voices = 0;    /* voices stolen to enforce lowered caps */
+  guint   degradation = 0;      /* 0: full processing, 1: sheddable work skipped, 2: reducible work reduced */
+  guint64 degraded_blocks = 0;  /* number of blocks processed with degradation */
+};
+void            bse_engine_set_dsp_budget     (double        max_load);        /* MT-Safe */
+void            bse_engine_set_dsp_shedding   (double        shed_load,
+                                               double        reduce_load);     /* MT-Safe */
+bool            bse_engine_dsp_degraded       (Bse::DspPriority priority);     /* MT-Safe */
+guint           bse_engine_voice_cap          (guint         n_voices);        /* MT-Safe */
+void            bse_engine_budget_stolen      (guint         n_voices);        /* MT-Safe */
+BseEngineBudget bse_engine_budget_stats       (void);                          /* MT-Safe */
+
 /* --- thread handling --- */
 struct BseEngineLoop {
   glong         timeout;
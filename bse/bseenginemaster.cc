@@ -8,6 +8,7 @@
 #include "bseengineschedule.hh"
 #include "bseieee754.hh"
 #include "bsestartup.hh"        // for TaskRegistry
+#include "enginecapture.hh"
 #include "bse/internal.hh"
 #include <string.h>
 #include <unistd.h>
@@ -766,13 +767,78 @@ master_update_node_state (Bse::Module *node,
   return node_peek_flow_job_stamp (node);
 }
 
+static void master_process_locked_node (Bse::Module *node, guint n_values);
+
+/* skip SHEDDABLE modules while the DSP budget is exceeded */
+static inline bool
+master_shed_node (Bse::Module *node)
+{
+  return UNLIKELY (size_t (node->klass.mflags) & size_t (Bse::ModuleFlag::SHEDDABLE)) &&
+         bse_engine_dsp_degraded (Bse::DspPriority::SHEDDABLE);
+}
+
+static inline void
+master_fetch_locked_inputs (Bse::Module *node,
+                            guint64      final_counter,
+                            guint        diff)
+{
+  guint i, j;
+  /* ensure all istream inputs have n_values available */
+  for (i = 0; i < BSE_MODULE_N_ISTREAMS (node); i++)
+    {
+      Bse::Module *inode = node->inputs[i].real_node;
+
+      if (inode)
+        {
+          inode->lock();
+          if (inode->counter < final_counter)
+            master_process_locked_node (inode, final_counter - node->counter);
+          node->istreams[i].values = inode->outputs[node->inputs[i].real_stream].buffer;
+          node->istreams[i].values += diff;
+          inode->unlock();
+        }
+      else
+        node->istreams[i].values = bse_engine_const_zeros (BSE_ENGINE_MAX_BLOCK_SIZE);
+    }
+  /* ensure all jstream inputs have n_values available */
+  for (j = 0; j < BSE_MODULE_N_JSTREAMS (node); j++)
+    for (i = 0; i < node->jstreams[j].n_connections; i++) /* assumes scheduled node */
+      {
+        Bse::Module *inode = node->jinputs[j][i].real_node;
+
+        inode->lock();
+        if (inode->counter < final_counter)
+          master_process_locked_node (inode, final_counter - node->counter);
+        node->jstreams[j].values[i] = inode->outputs[node->jinputs[j][i].real_stream].buffer;
+        node->jstreams[j].values[i] += diff;
+        inode->unlock();
+      }
+  /* update obuffer pointer (FIXME: need this before flow job callbacks?) */
+  for (i = 0; i < BSE_MODULE_N_OSTREAMS (node); i++)
+    node->ostreams[i].values = node->outputs[i].buffer + diff;
+}
+
+static inline void
+master_catch_obuffers (Bse::Module *node,
+                       guint        n_values,
+                       guint        diff)
+{
+  for (guint i = 0; i < BSE_MODULE_N_OSTREAMS (node); i++)
+    {
+      /* FIXME: this takes the worst possible performance hit to support obuffer pointer virtualization */
+      if (node->ostreams[i].connected &&
+          node->ostreams[i].values != node->outputs[i].buffer + diff)
+        bse_block_copy_float (n_values, node->outputs[i].buffer + diff, node->ostreams[i].values);
+    }
+}
+
 static void
 master_process_locked_node (Bse::Module *node,
 			    guint       n_values)
 {
   const guint64 current_stamp = Bse::TickStamp::current();
   guint64 next_counter, new_counter, final_counter = current_stamp + n_values;
-  guint i, j, diff;
+  guint i, diff;
   bool needs_probe_reset = node->probe_jobs != NULL;
 
   assert_return (node->integrated && node->sched_tag);
@@ -787,47 +853,15 @@ master_process_locked_node (Bse::Module *node,
       if (node->next_active > node->counter)
         new_counter = MIN (node->next_active, new_counter);
       diff = node->counter - current_stamp;
-      /* ensure all istream inputs have n_values available */
-      for (i = 0; i < BSE_MODULE_N_ISTREAMS (node); i++)
-	{
-	  Bse::Module *inode = node->inputs[i].real_node;
-
-	  if (inode)
-	    {
-	      inode->lock();
-	      if (inode->counter < final_counter)
-		master_process_locked_node (inode, final_counter - node->counter);
-	      node->istreams[i].values = inode->outputs[node->inputs[i].real_stream].buffer;
-	      node->istreams[i].values += diff;
-	      inode->unlock();
-	    }
-	  else
-	    node->istreams[i].values = bse_engine_const_zeros (BSE_ENGINE_MAX_BLOCK_SIZE);
-	}
-      /* ensure all jstream inputs have n_values available */
-      for (j = 0; j < BSE_MODULE_N_JSTREAMS (node); j++)
-	for (i = 0; i < node->jstreams[j].n_connections; i++) /* assumes scheduled node */
-	  {
-	    Bse::Module *inode = node->jinputs[j][i].real_node;
-
-	    inode->lock();
-	    if (inode->counter < final_counter)
-	      master_process_locked_node (inode, final_counter - node->counter);
-	    node->jstreams[j].values[i] = inode->outputs[node->jinputs[j][i].real_stream].buffer;
-	    node->jstreams[j].values[i] += diff;
-	    inode->unlock();
-	  }
-      /* update obuffer pointer (FIXME: need this before flow job callbacks?) */
-      for (i = 0; i < BSE_MODULE_N_OSTREAMS (node); i++)
-        node->ostreams[i].values = node->outputs[i].buffer + diff;
+      master_fetch_locked_inputs (node, final_counter, diff);
       if (diff && needs_probe_reset)
         for (i = 0; i < BSE_MODULE_N_OSTREAMS (node); i++)
           bse_block_fill_float (diff, node->outputs[i].buffer, 0.0);
       needs_probe_reset = false;
       /* process() node */
-      if (UNLIKELY (BSE_MODULE_IS_SUSPENDED (node, node->counter)))
+      if (UNLIKELY (BSE_MODULE_IS_SUSPENDED (node, node->counter)) || master_shed_node (node))
 	{
-	  /* suspended node processing behaviour */
+	  /* suspended (or shed) node processing behaviour */
 	  for (i = 0; i < BSE_MODULE_N_OSTREAMS (node); i++)
 	    if (node->ostreams[i].connected)
 	      node->ostreams[i].values = bse_engine_const_zeros (BSE_ENGINE_MAX_BLOCK_SIZE);
@@ -836,18 +870,58 @@ master_process_locked_node (Bse::Module *node,
       else
         node->process (new_counter - node->counter);
       /* catch obuffer pointer changes */
-      for (i = 0; i < BSE_MODULE_N_OSTREAMS (node); i++)
-	{
-	  /* FIXME: this takes the worst possible performance hit to support obuffer pointer virtualization */
-	  if (node->ostreams[i].connected &&
-              node->ostreams[i].values != node->outputs[i].buffer + diff)
-            bse_block_copy_float (new_counter - node->counter, node->outputs[i].buffer + diff, node->ostreams[i].values);
-	}
+      master_catch_obuffers (node, new_counter - node->counter, diff);
       /* update node counter */
       node->counter = new_counter;
     }
 }
 
+/* process a lane group in one process_lanes() call, modules that need partial blocks or
+ * are busy in other threads are processed individually
+ */
+static void
+master_process_locked_lanes (Bse::Module *leader,
+                             guint        n_values)
+{
+  const guint64 current_stamp = Bse::TickStamp::current();
+  const guint64 final_counter = current_stamp + n_values;
+  Bse::Module *lanes[BSE_ENGINE_MAX_LANES];
+  guint n_lanes = 0;
+
+  for (Bse::Module *node = leader; node && n_lanes < BSE_ENGINE_MAX_LANES; node = node->lane_next)
+    {
+      if (node != leader && !node->try_lock())
+        continue;               /* pulled in as input elsewhere */
+      bool whole_block = node->counter == current_stamp && !node->probe_jobs;
+      if (whole_block)
+        whole_block = master_update_node_state (node, node->counter) >= final_counter &&
+                      !BSE_MODULE_IS_SUSPENDED (node, node->counter) && !master_shed_node (node);
+      if (whole_block)
+        {
+          master_fetch_locked_inputs (node, final_counter, 0);
+          lanes[n_lanes++] = node;
+        }
+      else
+        {
+          master_process_locked_node (node, n_values);
+          if (node != leader)
+            node->unlock();
+        }
+    }
+  if (n_lanes > 1)
+    leader->klass.process_lanes (lanes, n_lanes, n_values);
+  else if (n_lanes)
+    lanes[0]->process (n_values);
+  for (guint l = 0; l < n_lanes; l++)
+    {
+      Bse::Module *node = lanes[l];
+      master_catch_obuffers (node, n_values, 0);
+      node->counter = final_counter;
+      if (node != leader)
+        node->unlock();
+    }
+}
+
 static bool bse_profile_modules = 0;	/* set to 1 in gdb to get profile output */
 
 struct ProfileData {
@@ -866,7 +940,10 @@ thread_process_nodes (const uint n_values, ProfileData *profile)
       if (UNLIKELY (profile))
         toyprof_stamp (profile_stamp1);
 
-      master_process_locked_node (node, n_values);
+      if (node->lane_leader)
+        master_process_locked_lanes (node, n_values);
+      else
+        master_process_locked_node (node, n_values);
 
       if (UNLIKELY (profile))
         {
@@ -981,8 +1058,8 @@ master_process_flow (void)
       /* nothing new to process, wait for slaves */
       _engine_wait_on_unprocessed ();
 
-      /* take remaining probes */
-      SfiRing *ring = probe_node_list;
+      /* take remaining probes, signal monitoring is postponed while sheddable work is skipped */
+      SfiRing *ring = bse_engine_dsp_degraded (Bse::DspPriority::SHEDDABLE) ? NULL : probe_node_list;
       while (ring)
         {
           node = (Bse::Module*) ring->data; /* current ring may be removed during master_take_probes() */
@@ -1163,6 +1240,173 @@ _engine_master_dispatch_jobs (void)
     while (master_new_boundary_jobs);   /* new boundary jobs arrived */
 }
 
+/* --- DSP budget --- */
+#define BUDGET_MIN_VOICE_FRACTION       (1.0 / 16)
+#define BUDGET_REDUCE_FACTOR            (0.75)
+#define BUDGET_HOLDOFF_BLOCKS           (32)    /* blocks to wait for steals to take effect */
+#define BUDGET_RAISE_BLOCKS             (128)   /* blocks of low load before caps are raised */
+#define BUDGET_RAISE_LOAD               (0.6)   /* fraction of max_load considered low */
+static std::atomic<double>  budget_max_load { 0 };
+static std::atomic<double>  budget_load { 0 };
+static std::atomic<double>  budget_peak_load { 0 };
+static std::atomic<double>  budget_voice_fraction { 1 };
+static std::atomic<guint64> budget_reductions { 0 };
+static std::atomic<guint64> budget_raises { 0 };
+static std::atomic<guint64> budget_stolen_voices { 0 };
+static std::atomic<double>  budget_shed_load { 0 };
+static std::atomic<double>  budget_reduce_load { 0 };
+static std::atomic<guint>   budget_degradation { 0 };
+static std::atomic<guint64> budget_degraded_blocks { 0 };
+
+/// Set the block load above which voice allocators are asked to reduce polyphony, 0 disables limiting.
+void
+bse_engine_set_dsp_budget (double max_load)
+{
+  budget_max_load = CLAMP (max_load, 0, 1);
+}
+
+/// Set the block loads above which SHEDDABLE work is skipped and REDUCIBLE work lowers its quality, 0 disables.
+void
+bse_engine_set_dsp_shedding (double shed_load, double reduce_load)
+{
+  budget_shed_load = CLAMP (shed_load, 0, 1);
+  budget_reduce_load = CLAMP (reduce_load, 0, 1);
+}
+
+/// Check if work of `priority` should currently be skipped (SHEDDABLE) or reduced in quality (REDUCIBLE).
+bool
+bse_engine_dsp_degraded (Bse::DspPriority priority)
+{
+  const guint degradation = budget_degradation.load (std::memory_order_relaxed);
+  switch (priority)
+    {
+    case Bse::DspPriority::SHEDDABLE:   return degradation >= 1;
+    case Bse::DspPriority::REDUCIBLE:   return degradation >= 2;
+    case Bse::DspPriority::ESSENTIAL:   return false;
+    }
+  return false;
+}
+
+static guint
+budget_voice_cap (guint  n_voices,
+                  double fraction)
+{
+  if (fraction >= 1.0 || n_voices <= 1)
+    return n_voices;
+  return CLAMP (guint (n_voices * fraction + 0.5), 1, n_voices);
+}
+
+/// Reduce `n_voices` according to the current DSP budget, allocators should steal their quietest voices beyond this.
+guint
+bse_engine_voice_cap (guint n_voices)
+{
+  return budget_voice_cap (n_voices, budget_voice_fraction.load (std::memory_order_relaxed));
+}
+
+/// Account for `n_voices` stolen by an allocator to stay within bse_engine_voice_cap().
+void
+bse_engine_budget_stolen (guint n_voices)
+{
+  budget_stolen_voices += n_voices;
+}
+
+/// Retrieve the current engine load and the DSP budget decisions taken so far.
+BseEngineBudget
+bse_engine_budget_stats (void)
+{
+  BseEngineBudget budget;
+  budget.load = budget_load;
+  budget.peak_load = budget_peak_load;
+  budget.voice_fraction = budget_voice_fraction;
+  budget.reductions = budget_reductions;
+  budget.raises = budget_raises;
+  budget.stolen_voices = budget_stolen_voices;
+  budget.degradation = budget_degradation;
+  budget.degraded_blocks = budget_degraded_blocks;
+  return budget;
+}
+
+/* voice fraction and degradation with hysteresis, fed with the smoothed block load */
+struct BudgetControl {
+  double  fraction = 1;
+  guint   degradation = 0;
+  guint   holdoff = 0, relaxed = 0, degrade_relaxed = 0;
+  guint64 reductions = 0, raises = 0;
+  void
+  update (double load, double max_load, double shed_load, double reduce_load)
+  {
+    if (holdoff)
+      holdoff--;
+    if (max_load <= 0)                                          /* limiting disabled */
+      {
+        fraction = 1;
+        relaxed = 0;
+      }
+    else if (load > max_load)
+      {
+        relaxed = 0;
+        if (!holdoff && fraction > BUDGET_MIN_VOICE_FRACTION)
+          {
+            fraction = MAX (fraction * BUDGET_REDUCE_FACTOR, BUDGET_MIN_VOICE_FRACTION);
+            reductions++;
+            holdoff = BUDGET_HOLDOFF_BLOCKS;
+            JOB_DEBUG ("budget: load=%.3f > %.3f, voice fraction lowered to %.3f", load, max_load, fraction);
+          }
+      }
+    else if (load < max_load * BUDGET_RAISE_LOAD && fraction < 1)
+      {
+        if (++relaxed >= BUDGET_RAISE_BLOCKS)
+          {
+            fraction = MIN (fraction / BUDGET_REDUCE_FACTOR, 1.0);
+            raises++;
+            relaxed = 0;
+            JOB_DEBUG ("budget: load=%.3f, voice fraction raised to %.3f", load, fraction);
+          }
+      }
+    else
+      relaxed = 0;
+    /* degrade by priority class, sheddable work goes first, then reducible work lowers its quality */
+    const guint wanted = reduce_load > 0 && load > reduce_load ? 2 : shed_load > 0 && load > shed_load ? 1 : 0;
+    if (wanted >= degradation)
+      {
+        if (wanted > degradation)
+          JOB_DEBUG ("budget: load=%.3f, degradation raised to %u", load, wanted);
+        degradation = wanted;
+        degrade_relaxed = 0;
+      }
+    else
+      {
+        const double threshold = degradation >= 2 ? reduce_load : shed_load;
+        if (load >= threshold * BUDGET_RAISE_LOAD)
+          degrade_relaxed = 0;
+        else if (threshold <= 0 || ++degrade_relaxed >= BUDGET_RAISE_BLOCKS)
+          {
+            degradation--;
+            degrade_relaxed = 0;
+            JOB_DEBUG ("budget: load=%.3f, degradation lowered to %u", load, degradation);
+          }
+      }
+  }
+};
+
+static void
+master_budget_update (guint64 elapsed_ns)
+{
+  static BudgetControl control;
+  const double block_ns = bse_engine_block_size() * 1000000000.0 / bse_engine_sample_freq();
+  const double block_load = elapsed_ns / block_ns;
+  const double load = budget_load * 0.9 + block_load * 0.1;
+  budget_load = load;
+  budget_peak_load = MAX (block_load, budget_peak_load * 0.995);
+  control.update (load, budget_max_load, budget_shed_load, budget_reduce_load);
+  budget_voice_fraction = control.fraction;
+  budget_reductions = control.reductions;
+  budget_raises = control.raises;
+  if (control.degradation)
+    budget_degraded_blocks++;
+  budget_degradation = control.degradation;
+}
+
 void
 _engine_master_dispatch (void)
 {
@@ -1176,7 +1420,23 @@ _engine_master_dispatch (void)
   if (master_need_reflow)
     master_reschedule_flow ();
   if (master_need_process)
-    master_process_flow ();
+    {
+      const guint64 stamp = Bse::TickStamp::current();
+      const guint64 start = Bse::timestamp_benchmark();
+      master_process_flow ();
+      const guint64 elapsed = Bse::timestamp_benchmark() - start;
+      master_budget_update (elapsed);
+      if (Bse::EngineCapture::active())
+        {
+          Bse::EngineCapture::Record rec;
+          rec.kind = Bse::EngineCapture::Kind::BLOCK;
+          rec.id16 = budget_degradation;
+          rec.id32 = bse_engine_block_size();
+          rec.stamp = stamp;
+          rec.value = elapsed;
+          Bse::EngineCapture::record (rec);
+        }
+    }
 }
 
 namespace Bse {
@@ -1280,3 +1540,69 @@ MasterThread::wakeup ()
 }
 
 } // Bse
+
+// == Testing ==
+#include "testing.hh"
+
+namespace { // Anon
+
+BSE_INTEGRITY_TEST (bse_engine_voice_cap_hysteresis);
+static void
+bse_engine_voice_cap_hysteresis ()
+{
+  BudgetControl control;
+  const double max_load = 0.8;
+  auto feed = [&] (double load, guint n_blocks) {
+    for (guint i = 0; i < n_blocks; i++)
+      control.update (load, max_load, 0, 0);
+  };
+  TCMP (budget_voice_cap (32, control.fraction), ==, 32);
+  // overload lowers the cap once per holdoff period
+  feed (0.9, 1);
+  TCMP (control.fraction, ==, BUDGET_REDUCE_FACTOR);
+  TCMP (budget_voice_cap (32, control.fraction), ==, 24);
+  feed (0.9, BUDGET_HOLDOFF_BLOCKS - 1);
+  TCMP (control.reductions, ==, 1);                     // steals need time to take effect
+  feed (0.9, 1);
+  TCMP (control.reductions, ==, 2);
+  TCMP (budget_voice_cap (32, control.fraction), ==, 18);
+  // loads between the raise threshold and max_load keep the cap
+  feed (max_load * BUDGET_RAISE_LOAD + 0.01, 4 * BUDGET_RAISE_BLOCKS);
+  TCMP (control.reductions, ==, 2);
+  TCMP (control.raises, ==, 0);
+  // low load raises the cap only after BUDGET_RAISE_BLOCKS consecutive blocks
+  feed (0.1, BUDGET_RAISE_BLOCKS - 1);
+  feed (0.7, 1);                                        // interrupts relaxation
+  feed (0.1, BUDGET_RAISE_BLOCKS - 1);
+  TCMP (control.raises, ==, 0);
+  feed (0.1, 1);
+  TCMP (control.raises, ==, 1);
+  TCMP (budget_voice_cap (32, control.fraction), ==, 24);
+  feed (0.1, BUDGET_RAISE_BLOCKS);
+  TCMP (control.fraction, ==, 1.0);
+  TCMP (budget_voice_cap (32, control.fraction), ==, 32);
+  feed (0.1, 4 * BUDGET_RAISE_BLOCKS);
+  TCMP (control.raises, ==, 2);                         // never above all voices
+  // sustained overload bottoms out at the minimum fraction, keeping at least one voice
+  feed (2.0, 64 * BUDGET_HOLDOFF_BLOCKS);
+  TCMP (control.fraction, ==, BUDGET_MIN_VOICE_FRACTION);
+  TCMP (budget_voice_cap (32, control.fraction), ==, 2);
+  TCMP (budget_voice_cap (4, control.fraction), ==, 1);
+  TCMP (budget_voice_cap (1, control.fraction), ==, 1);
+  // disabling the budget restores all voices immediately
+  control.update (2.0, 0, 0, 0);
+  TCMP (control.fraction, ==, 1.0);
+  // degradation steps down one class per BUDGET_RAISE_BLOCKS of low load
+  control.update (0.95, 0, 0.7, 0.9);
+  TCMP (control.degradation, ==, 2);
+  for (guint i = 0; i < BUDGET_RAISE_BLOCKS - 1; i++)
+    control.update (0.3, 0, 0.7, 0.9);
+  TCMP (control.degradation, ==, 2);
+  control.update (0.3, 0, 0.7, 0.9);
+  TCMP (control.degradation, ==, 1);
+  for (guint i = 0; i < BUDGET_RAISE_BLOCKS; i++)
+    control.update (0.3, 0, 0.7, 0.9);
+  TCMP (control.degradation, ==, 0);
+}
+
+} // Anon
@@ -22,6 +22,7 @@ public:
   explicit              Module  (const BseModuleClass &klass);
   virtual              ~Module  ();
   inline void           lock    ()      { rec_mutex_.lock(); }
+  inline bool           try_lock ()     { return rec_mutex_.try_lock(); }
   inline void           unlock  ()      { rec_mutex_.unlock(); }
   virtual void          process (uint n_values) = 0;
   virtual void          reset   () = 0;
@@ -39,6 +40,7 @@ public:
   uint                   cleared_ostreams : 1;          // whether ostream[].connected was cleared already
   uint                   sched_tag : 1;                 // whether this node is contained in the schedule
   uint                   sched_recurse_tag : 1;         // recursion flag used during scheduling
+  uint                   lane_leader : 1;               // whether lane_next starts a lane group, see process_lanes
   gpointer               user_data = NULL;
   BseIStream            *istreams = NULL;       // input streams
   BseJStream            *jstreams = NULL;       // joint (multiconnect) input streams
@@ -60,6 +62,7 @@ public:
   guint                  sched_leaf_level = 0;
   guint64                local_active = 0;              // local suspend state stamp
   Module                *toplevel_next = NULL;          // master-consumer-list, FIXME: overkill, using a SfiRing is good enough
+  Module                *lane_next = NULL;              // next module of the same class and leaf level for process_lanes
   SfiRing               *output_nodes = NULL;           // EngineNode* ring of nodes in ->outputs[]
 };
 } // Bse
@@ -10,6 +10,7 @@
 #define	BSE_MODULE_IS_CONSUMER(module)	((module)->is_consumer && (module)->output_nodes == NULL)
 #define	BSE_MODULE_IS_SCHEDULED(module)	((module)->sched_tag)
 #define	BSE_MODULE_IS_VIRTUAL(module)   (0 != (size_t ((module)->klass.mflags) & size_t (Bse::ModuleFlag::VIRTUAL_)))
+#define	BSE_MODULE_IS_PORT(module)      (0 != (size_t ((module)->klass.mflags) & size_t (Bse::ModuleFlag::PORT_)))
 
 /* --- transactions --- */
 typedef enum /*< skip >*/
@@ -129,8 +130,9 @@ struct EngineInput {
   Module *src_node;
   uint    src_stream;	/* ostream of src_node */
   /* valid if istream[].connected, setup by scheduler */
-  Module *real_node;	/* set to NULL if !connected */
+  Module *real_node;	/* NULL if !connected or for dead ends behind ports */
   uint    real_stream;	/* ostream of real_node */
+  bool    via_port;	/* virtual input chain passes a port, setup by scheduler */
 };
 struct EngineJInput {
   Module *src_node;
@@ -58,6 +58,8 @@ unschedule_node (EngineSchedule *sched, Bse::Module *node)
   sched->nodes[leaf_level] = sfi_ring_remove (sched->nodes[leaf_level], node);
   node->sched_leaf_level = 0;
   node->sched_tag = FALSE;
+  node->lane_leader = FALSE;
+  node->lane_next = NULL;
   if (node->flow_jobs)
     _engine_mnl_node_changed (node);
   sched->n_items--;
@@ -203,6 +205,7 @@ schedule_virtual (EngineSchedule *sched,
     {
       vnode->inputs[i].real_node = NULL;
       vnode->inputs[i].real_stream = 0;
+      vnode->inputs[i].via_port = false;
       /* _used_ virtual inputs are filled later on */
     }
 }
@@ -270,11 +273,45 @@ _engine_schedule_restart (EngineSchedule *sched)
       sched->cur_cycle = sched->cycles[0];
     }
 }
+/* group modules of the same class per leaf level, so their process_lanes() can handle them at once */
+static void
+schedule_group_lanes (EngineSchedule *sched)
+{
+  struct LaneGroup { Bse::Module *leader, *tail; uint n_lanes; };
+  std::vector<LaneGroup> groups;
+  for (uint leaf_level = 0; leaf_level < sched->leaf_levels; leaf_level++)
+    {
+      groups.clear();
+      for (SfiRing *ring = sched->nodes[leaf_level]; ring; ring = sfi_ring_walk (ring, sched->nodes[leaf_level]))
+        {
+          Bse::Module *node = (Bse::Module*) ring->data;
+          if (!node->klass.process_lanes)
+            continue;
+          size_t i;
+          for (i = 0; i < groups.size(); i++)
+            if (&groups[i].leader->klass == &node->klass)
+              break;
+          if (i >= groups.size())
+            {
+              groups.push_back (LaneGroup { node, node, 1 });
+              continue;
+            }
+          LaneGroup &group = groups[i];
+          group.leader->lane_leader = TRUE;
+          group.tail->lane_next = node;
+          group.tail = node;
+          if (++group.n_lanes >= BSE_ENGINE_MAX_LANES)
+            groups.erase (groups.begin() + i);
+        }
+    }
+}
+
 void
 _engine_schedule_secure (EngineSchedule *sched)
 {
   assert_return (sched != NULL);
   assert_return (sched->secured == FALSE);
+  schedule_group_lanes (sched);
   sched->secured = TRUE;
   sched->cur_leaf_level = sched->leaf_levels;
   if (CHECK_DEBUG())
@@ -597,21 +634,25 @@ subschedule_trace_virtual_input (EngineSchedule *schedule, Bse::Module *node, ui
       Bse::EngineInput *src_input = input->src_node->inputs + input->src_stream;
       input->real_node = src_input->real_node;
       input->real_stream = src_input->real_stream;
+      input->via_port = src_input->via_port || BSE_MODULE_IS_PORT (input->src_node);
     }
   else
     {
       input->real_node = input->src_node;
       input->real_stream = input->src_stream;
+      input->via_port = false;
     }
 }
 
 static inline Bse::Module*
-subschedule_skip_virtuals (EngineSchedule *schedule, Bse::Module *node, uint *ostream_p)
+subschedule_skip_virtuals (EngineSchedule *schedule, Bse::Module *node, uint *ostream_p, bool *via_port_p = NULL)
 {
   if (node && BSE_MODULE_IS_VIRTUAL (node))
     {
       subschedule_trace_virtual_input (schedule, node, *ostream_p);
       Bse::EngineInput *input = node->inputs + *ostream_p;
+      if (via_port_p)
+        *via_port_p = input->via_port || BSE_MODULE_IS_PORT (node);
       *ostream_p = input->real_stream;
       node = input->real_node;
     }
@@ -682,10 +723,12 @@ subschedule_query_node (EngineSchedule *schedule,
     {
       Bse::Module *child = node->inputs[i].src_node;
       guint child_ostream = node->inputs[i].src_stream;
-      child = subschedule_skip_virtuals (schedule, child, &child_ostream);
+      bool via_port = false;
+      child = subschedule_skip_virtuals (schedule, child, &child_ostream, &via_port);
       if (!child)
 	{
-	  node->istreams[i].connected = FALSE;
+	  /* dead ends behind ports stay connected and read silence, like the pass-through port modules did */
+	  node->istreams[i].connected = via_port;
 	  node->inputs[i].real_node = NULL;
 	}
       else
@@ -24,12 +24,16 @@ typedef guint16 Word;
 #define	DWORD_FROM_BE	GUINT32_FROM_BE
 #define	DWORD_FROM_LE	GUINT32_FROM_LE
 #define	WORD_FROM_LE	GUINT16_FROM_LE
+#define	QWORD_FROM_LE	GUINT64_FROM_LE
+#define RIFF_TOKEN      ('R' << 24 | 'I' << 16 | 'F' << 8 | 'F')
+#define RF64_TOKEN      ('R' << 24 | 'F' << 16 | '6' << 8 | '4')        /* RIFF with 64 bit sizes in 'ds64' */
+#define FORMAT_IS_FLOAT(f)      ((f) == 0x0003) /* IEEE float */
 
 /* --- functions --- */
 typedef struct
 {
-  DWord main_chunk;     /* 'RIFF', big endian as int */
-  DWord file_length;	/* file length */
+  DWord main_chunk;     /* 'RIFF' or 'RF64', big endian as int */
+  DWord file_length;	/* file length, 0xffffffff for 'RF64' */
   DWord chunk_type;     /* 'WAVE', big endian as int */
 } WavHeader;
 static Bse::Error
@@ -55,9 +59,9 @@ wav_read_header (int        fd,
   header->chunk_type = DWORD_FROM_BE (header->chunk_type);
 
   /* validation */
-  if (header->main_chunk != ('R' << 24 | 'I' << 16 | 'F' << 8 | 'F'))
+  if (header->main_chunk != RIFF_TOKEN && header->main_chunk != RF64_TOKEN)
     {
-      LDEBUG ("unmatched token 'RIFF'");
+      LDEBUG ("unmatched token 'RIFF' or 'RF64'");
       return Bse::Error::FORMAT_INVALID;
     }
   if (header->file_length < 36)
@@ -74,11 +78,64 @@ wav_read_header (int        fd,
   return Bse::Error::NONE;
 }
 
+typedef struct
+{
+  DWord   ds64_chunk;           /* 'ds64', big endian as int */
+  DWord   length;               /* sub chunk length, at least 28 */
+  guint64 riff_size;
+  guint64 data_size;            /* replaces the 'data' length of 0xffffffff */
+  guint64 sample_count;
+} Ds64Header;
+static Bse::Error
+wav_read_ds64_header (int         fd,
+                      Ds64Header *header)
+{
+  uint n_bytes;
+
+  memset (header, 0, sizeof (*header));
+
+  /* read header contents */
+  n_bytes = 4 + 4 + 8 + 8 + 8;
+  assert_return (n_bytes == sizeof (*header), Bse::Error::INTERNAL);
+  if (read (fd, header, n_bytes) != n_bytes)
+    {
+      LDEBUG ("failed to read Ds64Header");
+      return gsl_error_from_errno (errno, Bse::Error::IO);
+    }
+
+  /* endianess corrections */
+  header->ds64_chunk = DWORD_FROM_BE (header->ds64_chunk);
+  header->length = DWORD_FROM_LE (header->length);
+  header->riff_size = QWORD_FROM_LE (header->riff_size);
+  header->data_size = QWORD_FROM_LE (header->data_size);
+  header->sample_count = QWORD_FROM_LE (header->sample_count);
+
+  /* validation */
+  if (header->ds64_chunk != ('d' << 24 | 's' << 16 | '6' << 8 | '4'))
+    {
+      LDEBUG ("unmatched token 'ds64'");
+      return Bse::Error::FORMAT_INVALID;
+    }
+  if (header->length < 28)
+    {
+      LDEBUG ("ds64 header too short (%u)", header->length);
+      return Bse::Error::FORMAT_INVALID;
+    }
+  /* skip table_length and chunk size table */
+  if (lseek (fd, header->length - 24, SEEK_CUR) < 0)
+    {
+      LDEBUG ("failed to seek past ds64 header");
+      return gsl_error_from_errno (errno, Bse::Error::IO);
+    }
+
+  return Bse::Error::NONE;
+}
+
 typedef struct
 {
   DWord sub_chunk;              /* 'fmt ', big endian as int */
   DWord length;                 /* sub chunk length, must be 16 */
-  Word  format;                 /* 1 for PCM */
+  Word  format;                 /* 1 for PCM, 3 for IEEE float */
   Word  n_channels;             /* 1 = Mono, 2 = Stereo */
   DWord sample_freq;
   DWord byte_per_second;
@@ -119,12 +176,18 @@ wav_read_fmt_header (int        fd,
       return Bse::Error::FORMAT_UNKNOWN;
     }
   if (header->format != 1 /* PCM */ &&
+      !FORMAT_IS_FLOAT (header->format) &&
       !FORMAT_IS_ALAW (header->format) &&
       !FORMAT_IS_ULAW (header->format))
     {
       LDEBUG ("unknown format (%u)", header->format);
       return Bse::Error::FORMAT_UNKNOWN;
     }
+  if (FORMAT_IS_FLOAT (header->format) && header->bit_per_sample != 32)
+    {
+      LDEBUG ("unsupported float width (%u)", header->bit_per_sample);
+      return Bse::Error::FORMAT_UNKNOWN;
+    }
   if (header->n_channels > 2 || header->n_channels < 1)
     {
       LDEBUG ("invalid number of channels (%u)", header->n_channels);
@@ -189,7 +252,9 @@ typedef struct
 static Bse::Error
 wav_read_data_header (int         fd,
 		      DataHeader *header,
-		      uint        byte_alignment)
+		      uint        byte_alignment,
+                      guint64     ds64_data_size,
+                      guint64    *data_length)
 {
   uint n_bytes;
 
@@ -229,12 +294,13 @@ wav_read_data_header (int         fd,
 	  LDEBUG ("failed to seek while skipping sub-chunk");
 	  return gsl_error_from_errno (errno, Bse::Error::IO);
 	}
-      return wav_read_data_header (fd, header, byte_alignment);
+      return wav_read_data_header (fd, header, byte_alignment, ds64_data_size, data_length);
     }
-  if (header->data_length < 1 || header->data_length % byte_alignment != 0)
+  *data_length = header->data_length == 0xffffffff && ds64_data_size ? ds64_data_size : header->data_length;
+  if (*data_length < 1 || *data_length % byte_alignment != 0)
     {
       LDEBUG ("invalid data length (%u) or alignment (%u)",
-              header->data_length, header->data_length % byte_alignment);
+              *data_length, *data_length % byte_alignment);
       return Bse::Error::FORMAT_INVALID;
     }
 
@@ -245,6 +311,7 @@ typedef struct
 {
   BseWaveFileInfo wfi;
   int             fd;
+  bool            rf64;
 } FileInfo;
 
 static BseWaveFileInfo*
@@ -276,6 +343,7 @@ wav_load_file_info (void         *data,
   const char *dsep = strrchr (file_name, G_DIR_SEPARATOR);
   fi->wfi.waves[0].name = g_strdup (dsep ? dsep + 1 : file_name);
   fi->fd = fd;
+  fi->rf64 = wav_header.main_chunk == RF64_TOKEN;
 
   return &fi->wfi;
 }
@@ -312,6 +380,8 @@ wav_load_wave_dsc (void            *data,
   WaveDsc *dsc;
   GslWaveFormatType format;
   GslLong data_offset, data_width;
+  guint64 data_length = 0;
+  Ds64Header ds64_header = { 0, };
   assert_return (nth_wave == 0, NULL);
   if (lseek (fi->fd, sizeof (WavHeader), SEEK_SET) != sizeof (WavHeader))
     {
@@ -319,11 +389,18 @@ wav_load_wave_dsc (void            *data,
       *error_p = gsl_error_from_errno (errno, Bse::Error::IO);
       return NULL;
     }
+  if (fi->rf64)
+    {
+      *error_p = wav_read_ds64_header (fi->fd, &ds64_header);
+      if (*error_p != 0)
+        return NULL;
+    }
   *error_p = wav_read_fmt_header (fi->fd, &fmt_header);
   if (*error_p != 0)
     return NULL;
   data_width = (fmt_header.bit_per_sample + 7) / 8;
-  *error_p = wav_read_data_header (fi->fd, &data_header, data_width * fmt_header.n_channels);
+  *error_p = wav_read_data_header (fi->fd, &data_header, data_width * fmt_header.n_channels,
+                                   ds64_header.data_size, &data_length);
   data_offset = lseek (fi->fd, 0, SEEK_CUR);
   if (data_offset < ssize_t (sizeof (WavHeader)) && 0 == *error_p)
     {
@@ -337,6 +414,8 @@ wav_load_wave_dsc (void            *data,
     format = GSL_WAVE_FORMAT_ALAW;
   else if (fmt_header.bit_per_sample == 8 && FORMAT_IS_ULAW (fmt_header.format))
     format = GSL_WAVE_FORMAT_ULAW;
+  else if (FORMAT_IS_FLOAT (fmt_header.format))
+    format = GSL_WAVE_FORMAT_FLOAT;
   else switch (fmt_header.bit_per_sample)
     {
     case 8:	format = GSL_WAVE_FORMAT_UNSIGNED_8;	break;
@@ -370,7 +449,7 @@ wav_load_wave_dsc (void            *data,
   dsc->wdsc.chunks[0].mix_freq = fmt_header.sample_freq;
   dsc->wdsc.chunks[0].osc_freq = 440.0;	/* FIXME */
   dsc->data_offset = data_offset;
-  dsc->n_values = data_header.data_length / data_width;
+  dsc->n_values = data_length / data_width;
   dsc->format = format;
 
   return &dsc->wdsc;
@@ -423,6 +502,15 @@ _gsl_init_loader_wav (void)
      "16 lelong  >15\n"		/* expect valid sub chunk length */
      "20 leshort =1\n"		/* Microsoft PCM */
      ),
+    (
+     "0  string  RIFF\n" "8  string  WAVE\n" "12 string  fmt\\s\n" "16 lelong  >15\n"
+     "20 leshort =3\n"		/* IEEE float */
+     ),
+    (
+     "0  string  RF64\n"        /* RIFF with 64 bit sizes */
+     "8  string  WAVE\n"
+     "12 string  ds64\n"        /* 'ds64' precedes 'fmt ' */
+     ),
     (
      "0  string  RIFF\n" "8  string  WAVE\n" "12 string  fmt\\s\n" "16 lelong  >15\n"
      "20 leshort =0x0006\n"	/* Microsoft A-LAW */
@@ -442,7 +530,7 @@ _gsl_init_loader_wav (void)
     NULL,
   };
   static BseLoader loader = {
-    "RIFF, WAVE audio, PCM",
+    "RIFF, WAVE audio, PCM or float",
     file_exts,
     mime_types,
     BseLoaderFlags (0),	/* flags */
@@ -462,3 +550,76 @@ _gsl_init_loader_wav (void)
 
   bse_loader_register (&loader);
 }
+
+// == Testing ==
+#include "sndfiles.hh"
+#include "testing.hh"
+
+namespace { // Anon
+using namespace Bse;
+
+static void
+wav_test_load (const String &filename, GslWaveFormatType format, const float *values, uint n_values)
+{
+  Bse::Error error = Bse::Error::NONE;
+  BseWaveFileInfo *wfi = bse_wave_file_info_load (filename.c_str(), &error);
+  TASSERT (wfi && error == Bse::Error::NONE);
+  BseWaveDsc *wdsc = bse_wave_dsc_load (wfi, 0, false, &error);
+  TASSERT (wdsc && error == Bse::Error::NONE);
+  TCMP (wdsc->n_channels, ==, 2);
+  TASSERT (((WaveDsc*) wdsc)->format == format);
+  GslDataHandle *dhandle = bse_wave_handle_create (wdsc, 0, &error);
+  TASSERT (dhandle && gsl_data_handle_open (dhandle) == Bse::Error::NONE);
+  TCMP (gsl_data_handle_n_values (dhandle), ==, n_values);
+  std::vector<float> fvalues (n_values);
+  for (int64 l, n = 0; n < n_values; n += l)
+    {
+      l = gsl_data_handle_read (dhandle, n, n_values - n, &fvalues[n]);
+      TASSERT (l > 0);
+    }
+  TASSERT (memcmp (fvalues.data(), values, n_values * sizeof (float)) == 0);
+  gsl_data_handle_close (dhandle);
+  gsl_data_handle_unref (dhandle);
+  bse_wave_dsc_free (wdsc);
+  bse_wave_file_info_unref (wfi);
+}
+
+BSE_INTEGRITY_TEST (bse_loader_wav_float_rf64);
+static void
+bse_loader_wav_float_rf64 ()
+{
+  const String dir = Path::join (Path::cache_home(), "bse-tests");
+  Path::mkdirs (dir);
+  float floats[2 * 500];
+  for (uint i = 0; i < 500; i++)
+    floats[2 * i] = floats[2 * i + 1] = sin (i * 0.01) * 0.5;
+  // IEEE float RIFF/WAVE with reserved 'JUNK' space, as written by Snd::WavWriter
+  const String wavname = Path::join (dir, string_format ("loader-float-%u.wav", getpid()));
+  Snd::WavWriter wav (wavname, 2, 32, 48000);
+  TASSERT (wav.isopen());
+  TCMP (wav.write (floats, 1000), ==, 0);
+  TCMP (wav.close(), ==, 0);
+  wav_test_load (wavname, GSL_WAVE_FORMAT_FLOAT, floats, 1000);
+  // RF64 with 'ds64' before 'fmt ' and the data size only in 'ds64', like WavWriter uses beyond 4GB
+  auto l16 = [] (uint16 v) { return String ({ char (v), char (v >> 8) }); };
+  auto l32 = [&] (uint32 v) { return l16 (v) + l16 (v >> 16); };
+  auto l64 = [&] (uint64 v) { return l32 (v) + l32 (v >> 32); };
+  const uint n_data_bytes = sizeof (floats);
+  String s = "RF64" + l32 (0xffffffff) + "WAVE";
+  s += "ds64" + l32 (28) + l64 (4 + 8 + 28 + 8 + 16 + 8 + n_data_bytes) + l64 (n_data_bytes) + l64 (500) + l32 (0);
+  s += "fmt " + l32 (16) + l16 (3) + l16 (2) + l32 (48000) + l32 (48000 * 8) + l16 (8) + l16 (32);
+  s += "data" + l32 (0xffffffff);
+  for (uint i = 0; i < 1000; i++)
+    {
+      uint32 u;
+      memcpy (&u, &floats[i], 4);
+      s += l32 (u);
+    }
+  const String rf64name = Path::join (dir, string_format ("loader-rf64-%u.wav", getpid()));
+  TASSERT (Path::stringwrite (rf64name, s));
+  wav_test_load (rf64name, GSL_WAVE_FORMAT_FLOAT, floats, 1000);
+  unlink (wavname.c_str());
+  unlink (rf64name.c_str());
+}
+
+} // Anon
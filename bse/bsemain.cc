@@ -59,6 +59,9 @@ engine_prepare (GSource *source, gint *timeout_p)
 	}
     }
   *timeout_p = psource->loop.timeout;
+  const int ipc_timeout = BSE_SERVER.engine_ipc_timeout(); // coalesced notifications become due
+  if (ipc_timeout >= 0 && (*timeout_p < 0 || ipc_timeout < *timeout_p))
+    *timeout_p = ipc_timeout;
   BSE_THREADS_LEAVE ();
   return need_dispatch || BSE_SERVER.engine_ipc_pending();
 }
@@ -468,8 +471,13 @@ GlobalPreferences::defaults ()
   // static defaults
   prefs.pcm_driver = config_string ("pcm-driver", "auto");
   prefs.synth_latency = 22;
+  prefs.synth_latency_max = 0;
   prefs.synth_mixing_freq = 48000;
   prefs.synth_control_freq = 1500;
+  prefs.dsp_budget = 85;
+  prefs.dsp_shed_load = 70;
+  prefs.dsp_reduce_load = 80;
+  prefs.input_monitor = 0;
   prefs.midi_driver = config_string ("midi-driver", "auto");
   prefs.invert_sustain = false;
   prefs.license_default = "Creative Commons Attribution-ShareAlike 4.0 (https://creativecommons.org/licenses/by-sa/4.0/)";
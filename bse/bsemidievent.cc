@@ -5,6 +5,8 @@
 #include "bsecxxplugin.hh"
 #include "bse/internal.hh"
 #include <errno.h>
+#include <atomic>
+#include <mutex>
 
 
 /* --- functions --- */
@@ -52,11 +54,121 @@ bse_midi_signal_name (Bse::MidiSignal signal)
 }
 
 
+/* --- event pool --- */
+namespace {
+/// Lock-free freelist for BseMidiEvent structures, carved from slabs that are never released.
+class MidiEventPool {
+  struct Node {
+    uint32              index;          // position in slabs_, or HEAP_INDEX
+    std::atomic<uint32> next;           // index + 1 of the next free node, 0 terminates
+    std::atomic<uint32> ref_count;
+    BseMidiEvent        event;
+  };
+  static constexpr uint32 SLAB_EVENTS = 512;
+  static constexpr uint32 MAX_SLABS = 8192;
+  static constexpr uint32 HEAP_INDEX = ~uint32 (0);
+  std::atomic<Node*>  slabs_[MAX_SLABS] = {};
+  std::atomic<uint32> n_slabs_ { 0 };
+  std::atomic<uint64> head_ { 0 };      // ABA tag << 32 | (index + 1)
+  std::mutex          grow_mutex_;
+  std::atomic<uint64> n_allocations_ { 0 };
+  static Node*
+  event_node (BseMidiEvent *event)
+  {
+    return (Node*) (((char*) event) - offsetof (Node, event));
+  }
+  Node*
+  node (uint32 index)
+  {
+    return &slabs_[index / SLAB_EVENTS].load (std::memory_order_acquire)[index % SLAB_EVENTS];
+  }
+  void
+  push (Node *n)
+  {
+    uint64 head = head_.load (std::memory_order_relaxed);
+    do
+      n->next.store (head & 0xffffffff, std::memory_order_relaxed);
+    while (!head_.compare_exchange_weak (head, ((head >> 32) + 1) << 32 | (n->index + 1),
+                                         std::memory_order_release, std::memory_order_relaxed));
+  }
+  bool
+  grow()
+  {
+    std::lock_guard<std::mutex> locker (grow_mutex_);
+    if (head_.load (std::memory_order_acquire) & 0xffffffff)
+      return true;      // refilled concurrently
+    const uint32 nth = n_slabs_.load (std::memory_order_relaxed);
+    return_unless (nth < MAX_SLABS, false);
+    Node *slab = new Node[SLAB_EVENTS];
+    slabs_[nth].store (slab, std::memory_order_release);
+    n_slabs_.store (nth + 1, std::memory_order_relaxed);
+    for (uint32 i = SLAB_EVENTS; i > 0; i--)
+      {
+        slab[i - 1].index = nth * SLAB_EVENTS + i - 1;
+        push (&slab[i - 1]);
+      }
+    return true;
+  }
+public:
+  BseMidiEvent*
+  alloc()
+  {
+    n_allocations_.fetch_add (1, std::memory_order_relaxed);
+    do
+      {
+        uint64 head = head_.load (std::memory_order_acquire);
+        while (head & 0xffffffff)
+          {
+            Node *n = node ((head & 0xffffffff) - 1);
+            const uint64 next = ((head >> 32) + 1) << 32 | n->next.load (std::memory_order_relaxed);
+            if (head_.compare_exchange_weak (head, next, std::memory_order_acquire, std::memory_order_acquire))
+              {
+                memset (&n->event, 0, sizeof (n->event));
+                n->ref_count.store (1, std::memory_order_relaxed);
+                return &n->event;
+              }
+          }
+      }
+    while (grow());
+    // pool exhausted, fall back to the heap
+    Node *n = new Node();
+    n->index = HEAP_INDEX;
+    n->ref_count.store (1, std::memory_order_relaxed);
+    return &n->event;
+  }
+  uint64
+  n_allocations() const
+  {
+    return n_allocations_.load (std::memory_order_relaxed);
+  }
+  static void
+  ref (BseMidiEvent *event)
+  {
+    event_node (event)->ref_count.fetch_add (1, std::memory_order_relaxed);
+  }
+  static bool
+  unref (BseMidiEvent *event)
+  {
+    return event_node (event)->ref_count.fetch_sub (1, std::memory_order_acq_rel) == 1;
+  }
+  void
+  release (BseMidiEvent *event)
+  {
+    Node *n = event_node (event);
+    if (n->index == HEAP_INDEX)
+      delete n;
+    else
+      push (n);
+  }
+};
+static MidiEventPool midi_event_pool;
+} // Anon
+
 /* --- BseMidiEvents --- */
 /**
  * @param event BseMidiEvent structure
  *
- * Free the @a event and all data associated with it.
+ * Drop a reference from @a event, freeing it and all data associated with it with the last reference.
  * This function is MT-safe and may be called from any thread.
  */
 void
@@ -65,6 +177,9 @@ bse_midi_free_event (BseMidiEvent *event)
   assert_return (event != NULL);
   assert_return (event->status != 0);
 
+  if (!MidiEventPool::unref (event))
+    return;
+
   switch (event->status)
     {
     case BSE_MIDI_MULTI_SYS_EX_START:
@@ -92,7 +207,28 @@ bse_midi_free_event (BseMidiEvent *event)
       break;
     default: ;
     }
-  sfi_delete_struct (BseMidiEvent, event);
+  midi_event_pool.release (event);
+}
+
+/**
+ * @param event BseMidiEvent structure
+ *
+ * Add a reference to @a event, which needs to be treated as immutable while shared.
+ * This function is MT-safe and may be called from any thread.
+ */
+BseMidiEvent*
+bse_midi_ref_event (BseMidiEvent *event)
+{
+  assert_return (event != NULL, NULL);
+  MidiEventPool::ref (event);
+  return event;
+}
+
+/// Count of all event allocations so far, useful to measure allocations per MIDI input event.
+uint64
+bse_midi_event_allocations (void)
+{
+  return midi_event_pool.n_allocations();
 }
 
 BseMidiEvent*
@@ -109,10 +245,14 @@ bse_midi_copy_event (const BseMidiEvent *src)
   return event;
 }
 
+/**
+ * Allocate a zero initialized BseMidiEvent from a lock-free event pool.
+ * This function is MT-safe and may be called from any thread.
+ */
 BseMidiEvent*
 bse_midi_alloc_event (void)
 {
-  return sfi_new_struct0 (BseMidiEvent, 1);
+  return midi_event_pool.alloc();
 }
 
 BseMidiEvent*
@@ -190,7 +330,7 @@ bse_midi_event_signal (uint              midi_channel,
     case Bse::MidiSignal::CONSTANT_NEGATIVE_CENTER:
     case Bse::MidiSignal::CONSTANT_NEGATIVE_HIGH:
       /* these are special signals that don't map to MIDI events */
-      sfi_delete_struct (BseMidiEvent, event);
+      midi_event_pool.release (event); // status is still 0, bse_midi_free_event() would refuse it
       return NULL;
     default:
       if (signal_int >= 128)   /* literal controls */
@@ -235,3 +375,36 @@ bse_midi_event_get_type (void)
     type = g_boxed_type_register_static ("BseMidiEvent", boxed_copy_midi_event, boxed_free_midi_event);
   return type;
 }
+
+#include "testing.hh"
+
+BSE_INTEGRITY_TEST (bse_midi_event_pool);
+static void
+bse_midi_event_pool ()
+{
+  std::vector<BseMidiEvent*> events;
+  for (uint i = 0; i < 1500; i++)
+    events.push_back (bse_midi_event_note_on (1, i, 440, 0.5));
+  for (uint i = 0; i < events.size(); i++)
+    TASSERT (events[i]->delta_time == i && events[i]->status == BSE_MIDI_NOTE_ON);
+  for (BseMidiEvent *event : events)
+    bse_midi_free_event (event);
+  BseMidiEvent *event = bse_midi_alloc_event(); // recycled from the pool
+  TASSERT (event->status == 0 && event->delta_time == 0 && event->data.note.frequency == 0);
+  bse_midi_free_event (bse_midi_event_note_off (2, 7, 880));
+  event->status = BSE_MIDI_NOTE_OFF;
+  bse_midi_free_event (event);
+  // special signals without MIDI events return their event to the pool
+  event = bse_midi_alloc_event();
+  event->status = BSE_MIDI_NOTE_ON;
+  bse_midi_free_event (event);
+  TASSERT (bse_midi_event_signal (1, 0, Bse::MidiSignal::VELOCITY, 0.5) == NULL);
+  TASSERT (bse_midi_event_signal (1, 0, Bse::MidiSignal::CONSTANT_HIGH, 1) == NULL);
+  BseMidiEvent *recycled = bse_midi_alloc_event();
+  TASSERT (recycled == event && recycled->status == 0);
+  BseMidiEvent *cc = bse_midi_event_signal (1, 0, Bse::MidiSignal (128 + 7), 0.5);
+  TASSERT (cc && cc->status == BSE_MIDI_CONTROL_CHANGE && cc->data.control.control == 7);
+  bse_midi_free_event (cc);
+  recycled->status = BSE_MIDI_NOTE_ON;
+  bse_midi_free_event (recycled);
+}
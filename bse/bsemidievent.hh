@@ -122,6 +122,8 @@ typedef struct
 GType         bse_midi_event_get_type (void); /* boxed */
 BseMidiEvent* bse_midi_alloc_event    (void);
 BseMidiEvent* bse_midi_copy_event     (const BseMidiEvent *src);
+BseMidiEvent* bse_midi_ref_event      (BseMidiEvent       *event);
+Bse::uint64   bse_midi_event_allocations (void);
 void          bse_midi_free_event     (BseMidiEvent       *event);
 BseMidiEvent* bse_midi_event_note_on  (uint                midi_channel,
                                        Bse::uint64         delta_time,
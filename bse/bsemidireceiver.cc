@@ -5,6 +5,7 @@
 #include "bseengine.hh"
 #include "bsemathsignal.hh"
 #include "bsecxxutils.hh"
+#include "enginecapture.hh"
 #include "bse/internal.hh"
 #include <string.h>
 #include <bse/gbsearcharray.hh>
@@ -19,9 +20,10 @@ using namespace std;
 #define VDUMP(...)      Bse::debug ("midi-voice", __VA_ARGS__)
 
 /* --- variables --- */
-static std::mutex global_midi_mutex;
-#define	BSE_MIDI_RECEIVER_LOCK()        global_midi_mutex.lock()
-#define	BSE_MIDI_RECEIVER_UNLOCK()      global_midi_mutex.unlock()
+typedef std::shared_ptr<std::mutex> MidiMutexP;
+static std::mutex farm_mutex;           // guards farm_residents
+#define	BSE_MIDI_RECEIVER_LOCK(self)    (self)->mutex->lock()
+#define	BSE_MIDI_RECEIVER_UNLOCK(self)  (self)->mutex->unlock()
 
 /********************************************************************************
  *
@@ -276,10 +278,12 @@ struct MidiChannel {
   guint           n_voices;
   VoiceSwitch   **voices;
   VoiceInputTable voice_input_table;
+  Bse::VoiceStealing voice_stealing;
   std::vector<EventHandler> event_handlers;
   MidiChannel (guint mc) :
     midi_channel (mc),
-    poly_enabled (0)
+    poly_enabled (0),
+    voice_stealing (Bse::VoiceStealing::NONE)
   {
     vinput = NULL;
     n_voices = 0;
@@ -324,6 +328,10 @@ struct MidiChannel {
                          gfloat          freq,
                          gfloat          velocity,
                          BseTrans       *trans);
+  VoiceSwitch* steal_voice (guint64       tick_stamp,
+                         gfloat          freq_val,
+                         Bse::VoiceStealing policy,
+                         BseTrans       *trans);
   void  adjust_note     (guint64          tick_stamp,
                          gfloat           freq,
                          BseMidiEventType etype,
@@ -356,8 +364,19 @@ struct MidiReceiver
   uint	           n_cmodules;
   BseModule      **cmodules;            // control signals
   Channels         midi_channels;
-  SfiRing         *events;              // contains BseMidiEvent*
+  struct QueuedEvent {
+    BseMidiEvent *event;
+    uint64        seqno;                // preserves insertion order for equal stamps
+    static bool
+    later (const QueuedEvent &a, const QueuedEvent &b)
+    {
+      return a.event->delta_time > b.event->delta_time || (a.event->delta_time == b.event->delta_time && a.seqno > b.seqno);
+    }
+  };
+  std::vector<QueuedEvent> events;      // binary min-heap ordered by delta_time
+  uint64           events_seqno;
   uint		   ref_count;
+  MidiMutexP       mutex;               // guards receiver, channel and voice state
   BseMidiNotifier *notifier;
   SfiRing	  *notifier_events;
 public:
@@ -365,8 +384,9 @@ public:
   {
     n_cmodules = 0;
     cmodules = NULL;
-    events = NULL;
+    events_seqno = 0;
     ref_count = 1;
+    mutex = std::make_shared<std::mutex>();
     notifier = NULL;
     notifier_events = NULL;
   }
@@ -375,11 +395,8 @@ public:
     assert_return (ref_count == 0);
     for (Channels::iterator it = midi_channels.begin(); it != midi_channels.end(); it++)
       delete *it;
-    while (events)
-      {
-        BseMidiEvent *event = (BseMidiEvent*) sfi_ring_pop_head (&events);
-        bse_midi_free_event (event);
-      }
+    for (const QueuedEvent &qevent : events)
+      bse_midi_free_event (qevent.event);
     while (notifier_events)
       {
         BseMidiEvent *event = (BseMidiEvent*) sfi_ring_pop_head (&notifier_events);
@@ -391,6 +408,26 @@ public:
       Bse::warning ("destroying MIDI receiver (%p) with active control modules (%u)", this, n_cmodules);
     g_free (cmodules);
   }
+  void
+  push_event (BseMidiEvent *event)
+  {
+    events.push_back (QueuedEvent { event, events_seqno++ });
+    std::push_heap (events.begin(), events.end(), QueuedEvent::later);
+  }
+  BseMidiEvent*
+  peek_event ()
+  {
+    return events.empty() ? NULL : events.front().event;
+  }
+  BseMidiEvent*
+  pop_event ()
+  {
+    return_unless (!events.empty(), NULL);
+    std::pop_heap (events.begin(), events.end(), QueuedEvent::later);
+    BseMidiEvent *event = events.back().event;
+    events.pop_back();
+    return event;
+  }
   MidiChannel*
   peek_channel (guint midi_channel)
   {
@@ -628,6 +665,8 @@ match_midi_control_module_L (BseModule         *cmodule,
 
 
 /* --- VoiceInput module --- */
+#define VOICE_STEAL_FADE_MS     (5)     /* fade out time of stolen voices before restart, and fade in after it */
+
 typedef enum {
   VOICE_ON = 1,
   VOICE_PRESSURE,
@@ -681,9 +720,12 @@ struct VoiceInput
   BseModule       *fmodule;	        /* freq module */
   guint64          tick_stamp;           /* time of last event change */
   VoiceState       queue_state;          /* vstate according to jobs queued so far */
+  guint64          steal_stamp;          /* restart time after the voice got stolen */
+  volatile guint64 state_stamp;          /* module time of the last sustain/idle transition */
   VoiceInputTable *table;
   VoiceInput      *next;
   VoiceInputTable::iterator iter;
+  MidiMutexP       mutex;                /* receiver lock, outlives the receiver for pending callbacks */
 };
 
 static void
@@ -745,20 +787,26 @@ static void
 voice_input_enter_sustain_U (gpointer data)     /* UserThread */
 {
   VoiceInput *vinput = (VoiceInput*) data;
-  BSE_MIDI_RECEIVER_LOCK ();
-  voice_input_remove_from_table_L (vinput);
-  vinput->queue_state = VSTATE_SUSTAINED;
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_LOCK (vinput);
+  if (vinput->state_stamp >= vinput->steal_stamp)       /* ignore transitions preceeding a steal */
+    {
+      voice_input_remove_from_table_L (vinput);
+      vinput->queue_state = VSTATE_SUSTAINED;
+    }
+  BSE_MIDI_RECEIVER_UNLOCK (vinput);
 }
 
 static void
 voice_input_enter_idle_U (gpointer data)        /* UserThread */
 {
   VoiceInput *vinput = (VoiceInput*) data;
-  BSE_MIDI_RECEIVER_LOCK ();
-  voice_input_remove_from_table_L (vinput);
-  vinput->queue_state = VSTATE_IDLE;
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_LOCK (vinput);
+  if (vinput->state_stamp >= vinput->steal_stamp)       /* ignore transitions preceeding a steal */
+    {
+      voice_input_remove_from_table_L (vinput);
+      vinput->queue_state = VSTATE_IDLE;
+    }
+  BSE_MIDI_RECEIVER_UNLOCK (vinput);
 }
 static void
 voice_input_module_access_U (BseModule *module,
@@ -791,6 +839,7 @@ voice_input_module_access_U (BseModule *module,
           BSE_SIGNAL_FREQ_EQUALS (vinput->freq_value, mdata->freq_value))
         {
           vinput->vstate = VSTATE_SUSTAINED;
+          vinput->state_stamp = bse_module_tick_stamp (module);
           bse_engine_add_user_callback (vinput, voice_input_enter_sustain_U);
         }
       break;
@@ -807,6 +856,7 @@ voice_input_module_access_U (BseModule *module,
     kill_voice:
       vinput->vstate = VSTATE_IDLE;
       vinput->gate = 0.0;
+      vinput->state_stamp = bse_module_tick_stamp (module);
       bse_engine_add_user_callback (vinput, voice_input_enter_idle_U);
       break;
     }
@@ -882,6 +932,7 @@ voice_input_module_free_U (gpointer        data,
 static VoiceInput*
 create_voice_input_L (VoiceInputTable *table,
                       gboolean         ismono,
+                      MidiMutexP       mutex,
                       BseTrans        *trans)
 {
   static const BseModuleClass mono_synth_module_class = {
@@ -905,9 +956,12 @@ create_voice_input_L (VoiceInputTable *table,
   vinput->ref_count = 1;
   vinput->tick_stamp = 0;
   vinput->queue_state = VSTATE_IDLE;
+  vinput->steal_stamp = 0;
+  vinput->state_stamp = 0;
   vinput->table = ismono ? NULL : table;
   vinput->next = NULL;
   vinput->iter = table->end();
+  vinput->mutex = mutex;
   bse_trans_add (trans, bse_job_integrate (vinput->fmodule));
 
   return vinput;
@@ -926,25 +980,65 @@ destroy_voice_input_L (VoiceInput      *vinput,
 
 
 /* --- VoiceSwitch module --- */
+/* gain ramp for stolen voices, fades out until the restart and back in after it */
+struct VoiceStealFade
+{
+  guint64 start = 0, restart = 0;       /* module time of the steal and of the restart */
+  gfloat  gain = 1;
+  gfloat  step = 1;                     /* fade in increment per sample */
+  void
+  setup (guint64 steal_stamp, guint64 restart_stamp)
+  {
+    start = steal_stamp;
+    restart = MAX (steal_stamp + 1, restart_stamp);
+    step = 1.0 / (restart - start);
+  }
+  bool
+  passthrough (guint64 stamp, guint n_values) const
+  {
+    return gain >= 1.0 && (stamp + n_values <= start || stamp >= restart);
+  }
+  void
+  apply (guint64 stamp, const gfloat *ileft, const gfloat *iright, gfloat *oleft, gfloat *oright, guint n_values)
+  {
+    for (guint i = 0; i < n_values; i++)
+      {
+        const guint64 t = stamp + i;
+        if (t >= restart)
+          gain = MIN (1.0, gain + step);
+        else if (t >= start)
+          gain -= gain / (restart - t);         /* linear from any gain, reaches 0 at restart - 1 */
+        oleft[i] = ileft[i] * gain;
+        oright[i] = iright[i] * gain;
+      }
+  }
+};
+
 struct VoiceSwitch
 {
   /* module state: */
   volatile gboolean disconnected;       /* a hint towards module currently being idle */
+  volatile gfloat   energy;             /* mean square output of the last block */
+  VoiceStealFade    fade;
+  volatile guint64  done_stamp;         /* module time of the last Done=1 */
+  guint64           steal_stamp;        /* restart time after the voice got stolen */
   /* switchable midi voice */
   guint             n_vinputs;
   VoiceInput      **vinputs;
   guint             ref_count;
   BseModule        *smodule;            /* input module (switches and suspends) */
   BseModule        *vmodule;            /* output module (virtual) */
+  MidiMutexP        mutex;              /* receiver lock, outlives the receiver for pending callbacks */
 };
 
 static void
 voice_switch_module_reuse_U (gpointer data)     /* UserThread */
 {
   VoiceSwitch *vswitch = (VoiceSwitch*) data;
-  BSE_MIDI_RECEIVER_LOCK ();
-  vswitch->disconnected = TRUE;         /* reuse possible */
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_LOCK (vswitch);
+  if (vswitch->done_stamp >= vswitch->steal_stamp)      /* stolen voices stay connected */
+    vswitch->disconnected = TRUE;       /* reuse possible */
+  BSE_MIDI_RECEIVER_UNLOCK (vswitch);
 }
 
 static void
@@ -954,23 +1048,38 @@ voice_switch_module_process_U (BseModule *module,
   VoiceSwitch *vswitch = (VoiceSwitch*) module->user_data;
   guint i;
 
-  /* dumb pass-through task */
-  for (i = 0; i < BSE_MODULE_N_OSTREAMS (module); i++)
+  /* pass-through task, stolen voices are faded around their restart */
+  const guint64 stamp = bse_module_tick_stamp (module);
+  const gboolean fading = !vswitch->fade.passthrough (stamp, n_values);
+  if (fading)
+    vswitch->fade.apply (stamp, BSE_MODULE_IBUFFER (module, 0), BSE_MODULE_IBUFFER (module, 1),
+                         BSE_MODULE_OBUFFER (module, 0), BSE_MODULE_OBUFFER (module, 1), n_values);
+  for (i = fading ? 2 : 0; i < BSE_MODULE_N_OSTREAMS (module); i++)
     if (BSE_MODULE_OSTREAM (module, i).connected)
       BSE_MODULE_OSTREAM (module, i).values = (gfloat*) BSE_MODULE_IBUFFER (module, i);
 
+  /* measure output level for voice stealing */
+  const gfloat *left = BSE_MODULE_IBUFFER (module, 0), *right = BSE_MODULE_IBUFFER (module, 1);
+  gfloat energy = 0;
+  for (i = 0; i < n_values; i++)
+    energy += left[i] * left[i] + right[i] * right[i];
+  vswitch->energy = energy / n_values;
+
   /* check Done state on last stream */
   if (BSE_MODULE_IBUFFER (module, BSE_MODULE_N_ISTREAMS (module) - 1)[n_values - 1] >= 1.0)
     {
+      Bse::EngineCapture::PlaybackScope playback;
       BseTrans *trans = bse_trans_open ();
       /* disconnect all inputs */
       bse_trans_add (trans, bse_job_suspend_now (module));
       bse_trans_add (trans, bse_job_kill_inputs (vswitch->vmodule));
       bse_trans_commit (trans);
+      vswitch->done_stamp = bse_module_tick_stamp (module);
       for (i = 0; i < vswitch->n_vinputs; i++)
         if (vswitch->vinputs[i]->vstate == VSTATE_BUSY)
           {
             vswitch->vinputs[i]->vstate = VSTATE_IDLE;
+            vswitch->vinputs[i]->state_stamp = vswitch->done_stamp;
             bse_engine_add_user_callback (vswitch->vinputs[i], voice_input_enter_idle_U);
           }
       bse_engine_add_user_callback (vswitch, voice_switch_module_reuse_U);
@@ -985,21 +1094,23 @@ voice_switch_module_boundary_check_U (BseModule *module,
   if (vswitch->ref_count &&     /* don't queue jobs post-discard */
       !bse_module_has_source (vswitch->vmodule, 0))
     {
+      Bse::EngineCapture::PlaybackScope playback;
       BseTrans *trans = bse_trans_open ();
       guint i;
       for (i = 0; i < BSE_MODULE_N_ISTREAMS (vswitch->vmodule); i++)
         bse_trans_add (trans, bse_job_connect (vswitch->smodule, i, vswitch->vmodule, i));
+      /* a stolen voice may have signalled Done=1 after its restart was queued */
+      bse_trans_add (trans, bse_job_resume_at (vswitch->smodule, bse_module_tick_stamp (module)));
       bse_trans_commit (trans);
       vswitch->disconnected = FALSE;      /* reset hint */
     }
 }
 
 static void
-activate_voice_switch_L (VoiceSwitch *vswitch,
-                         guint64      tick_stamp,
-                         BseTrans    *trans)
+reactivate_voice_switch_L (VoiceSwitch *vswitch,
+                           guint64      tick_stamp,
+                           BseTrans    *trans)
 {
-  assert_return (vswitch->disconnected == TRUE);
   /* make sure the module is connected before tick_stamp */
   bse_trans_add (trans, bse_job_boundary_access (vswitch->smodule, tick_stamp, voice_switch_module_boundary_check_U, NULL, NULL));
   /* make sure the module is not suspended at tick_stamp */
@@ -1007,17 +1118,27 @@ activate_voice_switch_L (VoiceSwitch *vswitch,
   vswitch->disconnected = FALSE;        /* reset hint ahead of time */
 }
 
+static void
+activate_voice_switch_L (VoiceSwitch *vswitch,
+                         guint64      tick_stamp,
+                         BseTrans    *trans)
+{
+  assert_return (vswitch->disconnected == TRUE);
+  reactivate_voice_switch_L (vswitch, tick_stamp, trans);
+}
+
 static void
 voice_switch_module_free_U (gpointer        data,
                             const BseModuleClass *klass)
 {
   VoiceSwitch *vswitch = (VoiceSwitch*) data;
   g_free (vswitch->vinputs);
-  g_free (vswitch);
+  delete vswitch;
 }
 
 static VoiceSwitch*
-create_voice_switch_module_L (BseTrans *trans)
+create_voice_switch_module_L (MidiMutexP mutex,
+                              BseTrans  *trans)
 {
   static const BseModuleClass switch_module_class = {
     BSE_MIDI_VOICE_N_CHANNELS,          /* n_istreams */
@@ -1029,10 +1150,11 @@ create_voice_switch_module_L (BseTrans *trans)
     voice_switch_module_free_U,         /* free */
     Bse::ModuleFlag::CHEAP
   };
-  VoiceSwitch *vswitch = g_new0 (VoiceSwitch, 1);
+  VoiceSwitch *vswitch = new VoiceSwitch();
 
   vswitch->disconnected = TRUE;
   vswitch->ref_count = 1;
+  vswitch->mutex = mutex;
   vswitch->smodule = bse_module_new (&switch_module_class, vswitch);
   vswitch->vmodule = bse_module_new_virtual (BSE_MIDI_VOICE_N_CHANNELS, NULL, NULL);
   bse_trans_add (trans, bse_job_integrate (vswitch->smodule));
@@ -1053,6 +1175,7 @@ voice_switch_module_commit_accessor_U (BseModule *module,
                                        gpointer   data)
 {
   BseTrans *trans = (BseTrans*) data;
+  Bse::EngineCapture::PlaybackScope playback;
   bse_trans_commit (trans);
 }
 
@@ -1145,6 +1268,100 @@ MidiChannel::call_event_handlers (BseMidiEvent *event,
   return success;
 }
 
+/* victim selection for steal_voice(), candidates are considered in voice order */
+struct VoiceStealPicker {
+  int     oldest = -1, released = -1, quietest = -1, same_note = -1;
+  guint64 oldest_stamp = G_MAXUINT64, released_stamp = G_MAXUINT64;
+  double  quietest_energy = 0;
+  void
+  consider (int index, guint64 last_stamp, bool busy, bool plays_freq, double energy)
+  {
+    if (plays_freq && same_note < 0)
+      same_note = index;
+    if (last_stamp < oldest_stamp)
+      {
+        oldest = index;
+        oldest_stamp = last_stamp;
+      }
+    if (!busy && last_stamp < released_stamp)
+      {
+        released = index;
+        released_stamp = last_stamp;
+      }
+    if (quietest < 0 || energy < quietest_energy)
+      {
+        quietest = index;
+        quietest_energy = energy;
+      }
+  }
+  int
+  victim (Bse::VoiceStealing policy) const
+  {
+    switch (policy)
+      {
+      case Bse::VoiceStealing::NONE:            return -1;
+      case Bse::VoiceStealing::OLDEST:          return oldest;
+      case Bse::VoiceStealing::QUIETEST:        return quietest;
+      case Bse::VoiceStealing::SAME_NOTE:       return same_note >= 0 ? same_note : oldest;
+      case Bse::VoiceStealing::RELEASED_FIRST:  return released >= 0 ? released : oldest;
+      }
+    return -1;
+  }
+};
+
+VoiceSwitch*
+MidiChannel::steal_voice (guint64         tick_stamp,
+                          gfloat          freq_val,
+                          Bse::VoiceStealing policy,
+                          BseTrans       *trans)
+{
+  MidiChannel *mchannel = this;
+  VoiceStealPicker picker;
+  guint i, j;
+
+  /* find candidates, skipping voices that are already restarting for other notes */
+  for (i = 0; i < mchannel->n_voices; i++)
+    {
+      VoiceSwitch *vswitch = mchannel->voices[i];
+      if (!vswitch || !vswitch->n_vinputs || vswitch->steal_stamp > tick_stamp)
+        continue;
+      guint64 last_stamp = 0;
+      bool busy = false, same_note = false;
+      for (j = 0; j < vswitch->n_vinputs; j++)
+        {
+          VoiceInput *vinput = vswitch->vinputs[j];
+          last_stamp = MAX (last_stamp, vinput->tick_stamp);
+          busy = busy || vinput->queue_state == VSTATE_BUSY;
+          same_note = same_note || (vinput->table && vinput->iter != vinput->table->end() &&
+                                    BSE_SIGNAL_FREQ_EQUALS (vinput->iter->first, freq_val));
+        }
+      picker.consider (i, last_stamp, busy, same_note, vswitch->energy);
+    }
+  /* apply policy */
+  const int vindex = picker.victim (policy);
+  VoiceSwitch *victim = vindex >= 0 ? mchannel->voices[vindex] : NULL;
+  if (!victim)
+    return NULL;
+  /* release the victim and restart it once its output is faded out, to avoid clicks */
+  const guint64 restart_stamp = tick_stamp + MAX (1, bse_engine_sample_freq() * VOICE_STEAL_FADE_MS / 1000);
+  bse_trans_add (trans, bse_job_access (victim->smodule, [victim, tick_stamp, restart_stamp] () {
+        victim->fade.setup (tick_stamp, restart_stamp);
+      }));
+  for (j = 0; j < victim->n_vinputs; j++)
+    {
+      VoiceInput *vinput = victim->vinputs[j];
+      if (vinput->queue_state != VSTATE_IDLE)
+        change_voice_input_L (vinput, tick_stamp, VOICE_KILL, 0, 0, trans);
+      voice_input_remove_from_table_L (vinput);
+      vinput->steal_stamp = restart_stamp;
+    }
+  victim->steal_stamp = restart_stamp;
+  reactivate_voice_switch_L (victim, restart_stamp, trans);
+  VDUMP ("MidiChannel(%u): stealing voice %p at %08llx for %.2fHz",
+         mchannel->midi_channel, victim, restart_stamp, BSE_FREQ_FROM_VALUE (freq_val));
+  return victim;
+}
+
 void
 MidiChannel::start_note (guint64         tick_stamp,
                          gfloat          freq,
@@ -1153,7 +1370,8 @@ MidiChannel::start_note (guint64         tick_stamp,
 {
   MidiChannel *mchannel = this;
   gfloat freq_val = BSE_VALUE_FROM_FREQ (freq);
-  VoiceSwitch *vswitch, *override_candidate = NULL;
+  VoiceSwitch *vswitch;
+  bool stolen = false;
   guint i;
 
   assert_return (freq > 0);
@@ -1167,21 +1385,43 @@ MidiChannel::start_note (guint64         tick_stamp,
 
   /* figure voice from event */
   vswitch = NULL; // voice numbers on events not currently supported
-  /* find free poly voice */
-  if (!vswitch)
+  /* find free poly voice, unless the DSP budget caps polyphony below the busy voices */
+  const guint voice_cap = bse_engine_voice_cap (mchannel->n_voices);
+  guint n_busy = 0;
+  if (voice_cap < mchannel->n_voices)
     for (i = 0; i < mchannel->n_voices; i++)
-      if (mchannel->voices[i] && mchannel->voices[i]->n_vinputs)
+      if (mchannel->voices[i] && mchannel->voices[i]->n_vinputs &&
+          !check_voice_switch_available_L (mchannel->voices[i]))
+        n_busy++;
+  if (!vswitch && n_busy < voice_cap)
+    for (i = 0; i < mchannel->n_voices; i++)
+      if (mchannel->voices[i] && mchannel->voices[i]->n_vinputs &&
+          check_voice_switch_available_L (mchannel->voices[i]))
         {
-          override_candidate = mchannel->voices[i];
-          if (check_voice_switch_available_L (mchannel->voices[i]))
-            {
-              vswitch = mchannel->voices[i];
-              break;
-            }
+          vswitch = mchannel->voices[i];
+          break;
         }
+  /* enforce the DSP budget by stealing the quietest voice */
+  if (!vswitch && n_busy >= voice_cap && voice_cap < mchannel->n_voices)
+    {
+      vswitch = steal_voice (tick_stamp, freq_val, Bse::VoiceStealing::QUIETEST, trans);
+      if (vswitch)
+        {
+          tick_stamp = vswitch->steal_stamp;
+          stolen = true;
+          bse_engine_budget_stolen (1);
+        }
+    }
   /* grab voice to override */
-  if (!vswitch)
-    (void) override_candidate; // FIXME: voice = override_candidate;
+  if (!vswitch && mchannel->voice_stealing != Bse::VoiceStealing::NONE)
+    {
+      vswitch = steal_voice (tick_stamp, freq_val, mchannel->voice_stealing, trans);
+      if (vswitch)
+        {
+          tick_stamp = vswitch->steal_stamp;
+          stolen = true;
+        }
+    }
 
   if (vswitch && vswitch->n_vinputs)
     {
@@ -1192,7 +1432,8 @@ MidiChannel::start_note (guint64         tick_stamp,
         if (check_voice_input_improvement_L (vswitch->vinputs[i], vinput))
           vinput = vswitch->vinputs[i];
       /* setup voice */
-      activate_voice_switch_L (vswitch, tick_stamp, trans);
+      if (!stolen)
+        activate_voice_switch_L (vswitch, tick_stamp, trans);
       change_voice_input_L (vinput, tick_stamp, VOICE_ON, freq_val, velocity, trans);
     }
   else
@@ -1229,7 +1470,7 @@ MidiChannel::adjust_note (guint64         tick_stamp,
   /* adjust note */
   if (vinput)
     change_voice_input_L (vinput, tick_stamp, vctype, freq_val, velocity, trans);
-  else
+  else if (mchannel->voice_stealing == Bse::VoiceStealing::NONE)        /* stolen notes have no voice left */
     no_poly_voice (false, etype == BSE_MIDI_NOTE_OFF ? "note-off" : "velocity", freq);
 }
 
@@ -1294,26 +1535,54 @@ static gint	midi_receiver_process_event_L  (BseMidiReceiver        *self,
 static vector<BseMidiReceiver*> farm_residents;
 
 /* --- function --- */
-static gint
-events_cmp (gconstpointer a,
-            gconstpointer b,
-            gpointer      data)
-{
-  const BseMidiEvent *e1 = (const BseMidiEvent *) a;
-  const BseMidiEvent *e2 = (const BseMidiEvent *) b;
-
-  return e1->delta_time < e2->delta_time ? -1 : e1->delta_time != e2->delta_time;
-}
-
 void
 bse_midi_receiver_enter_farm (BseMidiReceiver *self)
 {
   assert_return (self != NULL);
-  assert_return (find (farm_residents.begin(), farm_residents.end(), self) == farm_residents.end());
 
-  BSE_MIDI_RECEIVER_LOCK ();
-  farm_residents.push_back (self);
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  farm_mutex.lock();
+  const bool is_resident = find (farm_residents.begin(), farm_residents.end(), self) != farm_residents.end();
+  if (!is_resident)
+    farm_residents.push_back (self);
+  farm_mutex.unlock();
+  assert_return (is_resident == false);
+}
+
+/* record MIDI input for replay, see bsetool replay */
+static void
+midi_receiver_capture_event (const BseMidiEvent *event)
+{
+  Bse::EngineCapture::Record rec;
+  rec.kind = Bse::EngineCapture::Kind::MIDI;
+  rec.id16 = event->status;
+  rec.channel = event->channel;
+  rec.stamp = event->delta_time;
+  switch (event->status)
+    {
+    case BSE_MIDI_NOTE_ON:
+    case BSE_MIDI_NOTE_OFF:
+    case BSE_MIDI_KEY_PRESSURE:
+      rec.value = event->data.note.frequency;
+      rec.value2 = event->data.note.velocity;
+      break;
+    case BSE_MIDI_CONTROL_CHANGE:
+    case BSE_MIDI_X_CONTINUOUS_CHANGE:
+      rec.id32 = event->data.control.control;
+      rec.value = event->data.control.value;
+      break;
+    case BSE_MIDI_PROGRAM_CHANGE:
+      rec.id32 = event->data.program;
+      break;
+    case BSE_MIDI_CHANNEL_PRESSURE:
+      rec.value = event->data.intensity;
+      break;
+    case BSE_MIDI_PITCH_BEND:
+      rec.value = event->data.pitch_bend;
+      break;
+    default:
+      return;   // system and meta events are not replayed
+    }
+  Bse::EngineCapture::record (rec);
 }
 
 void
@@ -1321,10 +1590,18 @@ bse_midi_receiver_farm_distribute_event (BseMidiEvent *event)
 {
   assert_return (event != NULL);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  if (Bse::EngineCapture::active())
+    midi_receiver_capture_event (event);
+
+  farm_mutex.lock();
   for (vector<BseMidiReceiver*>::iterator it = farm_residents.begin(); it != farm_residents.end(); it++)
-    (*it)->events = sfi_ring_insert_sorted ((*it)->events, bse_midi_copy_event (event), events_cmp, NULL);
-  BSE_MIDI_RECEIVER_UNLOCK ();
+    {
+      BseMidiReceiver *self = *it;
+      BSE_MIDI_RECEIVER_LOCK (self);
+      self->push_event (bse_midi_ref_event (event));     // shared, immutable
+      BSE_MIDI_RECEIVER_UNLOCK (self);
+    }
+  farm_mutex.unlock();
 }
 
 void
@@ -1334,10 +1611,15 @@ bse_midi_receiver_farm_process_events (guint64 max_tick_stamp)
   do
     {
       seen_event = FALSE;
-      BSE_MIDI_RECEIVER_LOCK ();
+      farm_mutex.lock();
       for (vector<BseMidiReceiver*>::iterator it = farm_residents.begin(); it != farm_residents.end(); it++)
-        seen_event |= midi_receiver_process_event_L (*it, max_tick_stamp);
-      BSE_MIDI_RECEIVER_UNLOCK ();
+        {
+          BseMidiReceiver *self = *it;
+          BSE_MIDI_RECEIVER_LOCK (self);
+          seen_event |= midi_receiver_process_event_L (self, max_tick_stamp);
+          BSE_MIDI_RECEIVER_UNLOCK (self);
+        }
+      farm_mutex.unlock();
     }
   while (seen_event);
 }
@@ -1346,11 +1628,13 @@ void
 bse_midi_receiver_leave_farm (BseMidiReceiver *self)
 {
   assert_return (self != NULL);
-  assert_return (find (farm_residents.begin(), farm_residents.end(), self) != farm_residents.end());
 
-  BSE_MIDI_RECEIVER_LOCK ();
-  farm_residents.erase (find (farm_residents.begin(), farm_residents.end(), self));
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  farm_mutex.lock();
+  auto it = find (farm_residents.begin(), farm_residents.end(), self);
+  if (it != farm_residents.end())
+    farm_residents.erase (it);
+  farm_mutex.unlock();
+  assert_return (it != farm_residents.end());
 }
 
 void
@@ -1360,9 +1644,9 @@ bse_midi_receiver_push_event (BseMidiReceiver *self,
   assert_return (self != NULL);
   assert_return (event != NULL);
 
-  BSE_MIDI_RECEIVER_LOCK ();
-  self->events = sfi_ring_insert_sorted (self->events, event, events_cmp, NULL);
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
+  self->push_event (event);
+  BSE_MIDI_RECEIVER_UNLOCK (self);
 }
 
 void
@@ -1375,9 +1659,9 @@ bse_midi_receiver_process_events (BseMidiReceiver *self,
 
   do
     {
-      BSE_MIDI_RECEIVER_LOCK ();
+      BSE_MIDI_RECEIVER_LOCK (self);
       seen_event = midi_receiver_process_event_L (self, max_tick_stamp);
-      BSE_MIDI_RECEIVER_UNLOCK ();
+      BSE_MIDI_RECEIVER_UNLOCK (self);
     }
   while (seen_event);
 }
@@ -1399,9 +1683,9 @@ bse_midi_receiver_ref (BseMidiReceiver *self)
   assert_return (self != NULL, NULL);
   assert_return (self->ref_count > 0, NULL);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   self->ref_count++;
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
 
   return self;
 }
@@ -1409,17 +1693,21 @@ bse_midi_receiver_ref (BseMidiReceiver *self)
 void
 bse_midi_receiver_unref (BseMidiReceiver *self)
 {
-  gboolean need_destroy, leave_farm;
+  gboolean need_destroy, leave_farm = FALSE;
 
   assert_return (self != NULL);
   assert_return (self->ref_count > 0);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   self->ref_count--;
   need_destroy = self->ref_count == 0;
-  leave_farm = need_destroy && find (farm_residents.begin(),
-                                     farm_residents.end(), self) != farm_residents.end();
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
+  if (need_destroy)
+    {
+      farm_mutex.lock();
+      leave_farm = find (farm_residents.begin(), farm_residents.end(), self) != farm_residents.end();
+      farm_mutex.unlock();
+    }
 
   if (need_destroy)
     {
@@ -1437,7 +1725,7 @@ bse_midi_receiver_set_notifier (BseMidiReceiver *self,
 
   assert_return (self != NULL);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   old_notifier = self->notifier;
   self->notifier = notifier;
   if (self->notifier)
@@ -1450,7 +1738,7 @@ bse_midi_receiver_set_notifier (BseMidiReceiver *self,
 	BseMidiEvent *event = (BseMidiEvent *) sfi_ring_pop_head (&self->notifier_events);
 	bse_midi_free_event (event);
       }
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
 }
 
 gboolean
@@ -1467,10 +1755,10 @@ bse_midi_receiver_fetch_notify_events (BseMidiReceiver *self)
 
   assert_return (self != NULL, NULL);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   ring = self->notifier_events;
   self->notifier_events = NULL;
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
 
   return ring;
 }
@@ -1488,7 +1776,7 @@ bse_midi_receiver_retrieve_control_module (BseMidiReceiver  *self,
   assert_return (midi_channel > 0, NULL);
   assert_return (signals != NULL, NULL);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   for (i = 0; i < self->n_cmodules; i++)
     {
       cmodule = self->cmodules[i];
@@ -1496,7 +1784,7 @@ bse_midi_receiver_retrieve_control_module (BseMidiReceiver  *self,
         {
           MidiCModuleData *cdata = (MidiCModuleData *) cmodule->user_data;
           cdata->ref_count++;
-	  BSE_MIDI_RECEIVER_UNLOCK ();
+	  BSE_MIDI_RECEIVER_UNLOCK (self);
           return cmodule;
         }
     }
@@ -1512,7 +1800,7 @@ bse_midi_receiver_retrieve_control_module (BseMidiReceiver  *self,
     self->add_control (midi_channel, signals[2], cmodule);
   if (signals[3] != signals[2] && signals[3] != signals[1] && signals[3] != signals[0])
     self->add_control (midi_channel, signals[3], cmodule);
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
   return cmodule;
 }
 
@@ -1526,7 +1814,7 @@ bse_midi_receiver_discard_control_module (BseMidiReceiver *self,
   assert_return (self != NULL);
   assert_return (module != NULL);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   for (i = 0; i < self->n_cmodules; i++)
     {
       BseModule *cmodule = self->cmodules[i];
@@ -1550,11 +1838,11 @@ bse_midi_receiver_discard_control_module (BseMidiReceiver *self,
 	      if (signals[3] != signals[2] && signals[3] != signals[1] && signals[3] != signals[0])
 		self->remove_control (midi_channel, signals[3], cmodule);
 	    }
-	  BSE_MIDI_RECEIVER_UNLOCK ();
+	  BSE_MIDI_RECEIVER_UNLOCK (self);
           return;
         }
     }
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
   Bse::warning ("no such control module: %p", module);
 }
 
@@ -1571,9 +1859,9 @@ bse_midi_receiver_add_control_handler (BseMidiReceiver      *self,
   assert_return (handler_func != NULL, FALSE);
   assert_return (module != NULL, FALSE);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   gboolean has_data = self->add_control_handler (midi_channel, signal_type, handler_func, handler_data, module);
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
   return has_data;
 }
 
@@ -1590,9 +1878,9 @@ bse_midi_receiver_set_control_handler_data (BseMidiReceiver      *self,
   assert_return (midi_channel > 0);
   assert_return (handler_func != NULL);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   self->set_control_handler_data (midi_channel, signal_type, handler_func, handler_data, extra_data, extra_free);
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
 }
 
 void
@@ -1608,9 +1896,9 @@ bse_midi_receiver_remove_control_handler (BseMidiReceiver      *self,
   assert_return (handler_func != NULL);
   assert_return (module != NULL);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   self->remove_control_handler (midi_channel, signal_type, handler_func, handler_data, module);
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
 }
 
 void
@@ -1625,9 +1913,9 @@ bse_midi_receiver_add_event_handler (BseMidiReceiver   *self,
   assert_return (handler_func != NULL);
   assert_return (module != NULL);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   self->add_event_handler (midi_channel, handler_func, handler_data, module);
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
 }
 
 void
@@ -1642,9 +1930,9 @@ bse_midi_receiver_remove_event_handler (BseMidiReceiver   *self,
   assert_return (handler_func != NULL);
   assert_return (module != NULL);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   self->remove_event_handler (midi_channel, handler_func, handler_data, module);
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
 }
 
 void
@@ -1654,10 +1942,10 @@ bse_midi_receiver_channel_enable_poly (BseMidiReceiver *self,
   assert_return (self != NULL);
   assert_return (midi_channel > 0);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   MidiChannel *mchannel = self->get_channel (midi_channel);
   mchannel->enable_poly();
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
 }
 
 void
@@ -1667,10 +1955,25 @@ bse_midi_receiver_channel_disable_poly (BseMidiReceiver *self,
   assert_return (self != NULL);
   assert_return (midi_channel > 0);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   MidiChannel *mchannel = self->get_channel (midi_channel);
   mchannel->disable_poly();
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
+}
+
+/// Select how note-on events that find all poly voices busy reuse a voice.
+void
+bse_midi_receiver_channel_set_voice_stealing (BseMidiReceiver   *self,
+                                              guint              midi_channel,
+                                              Bse::VoiceStealing policy)
+{
+  assert_return (self != NULL);
+  assert_return (midi_channel > 0);
+
+  BSE_MIDI_RECEIVER_LOCK (self);
+  MidiChannel *mchannel = self->get_channel (midi_channel);
+  mchannel->voice_stealing = policy;
+  BSE_MIDI_RECEIVER_UNLOCK (self);
 }
 
 BseModule*
@@ -1683,13 +1986,13 @@ bse_midi_receiver_retrieve_mono_voice (BseMidiReceiver *self,
   assert_return (self != NULL, NULL);
   assert_return (midi_channel > 0, NULL);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   mchannel = self->get_channel (midi_channel);
   if (mchannel->vinput)
     mchannel->vinput->ref_count++;
   else
-    mchannel->vinput = create_voice_input_L (&mchannel->voice_input_table, TRUE, trans);
-  BSE_MIDI_RECEIVER_UNLOCK ();
+    mchannel->vinput = create_voice_input_L (&mchannel->voice_input_table, TRUE, self->mutex, trans);
+  BSE_MIDI_RECEIVER_UNLOCK (self);
   return mchannel->vinput->fmodule;
 }
 
@@ -1704,7 +2007,7 @@ bse_midi_receiver_discard_mono_voice (BseMidiReceiver *self,
   assert_return (self != NULL);
   assert_return (fmodule != NULL);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   mchannel = self->get_channel (midi_channel);
   if (mchannel->vinput && mchannel->vinput->fmodule == fmodule)
     {
@@ -1714,10 +2017,10 @@ bse_midi_receiver_discard_mono_voice (BseMidiReceiver *self,
           destroy_voice_input_L (mchannel->vinput, trans);
           mchannel->vinput = NULL;
         }
-      BSE_MIDI_RECEIVER_UNLOCK ();
+      BSE_MIDI_RECEIVER_UNLOCK (self);
       return;
     }
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
   Bse::warning ("no such mono synth module: %p", fmodule);
 }
 
@@ -1732,7 +2035,7 @@ bse_midi_receiver_create_poly_voice (BseMidiReceiver *self,
   assert_return (self != NULL, 0);
   assert_return (midi_channel > 0, 0);
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   mchannel = self->get_channel (midi_channel);
   /* find free voice slot */
   for (i = 0; i < mchannel->n_voices; i++)
@@ -1744,8 +2047,8 @@ bse_midi_receiver_create_poly_voice (BseMidiReceiver *self,
       i = mchannel->n_voices++;
       mchannel->voices = g_renew (VoiceSwitch*, mchannel->voices, mchannel->n_voices);
     }
-  mchannel->voices[i] = create_voice_switch_module_L (trans);
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  mchannel->voices[i] = create_voice_switch_module_L (self->mutex, trans);
+  BSE_MIDI_RECEIVER_UNLOCK (self);
 
   return i + 1;
 }
@@ -1764,7 +2067,7 @@ bse_midi_receiver_discard_poly_voice (BseMidiReceiver *self,
   assert_return (voice_id > 0);
   voice_id -= 1;
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   mchannel = self->get_channel (midi_channel);
   vswitch = voice_id < mchannel->n_voices ? mchannel->voices[voice_id] : NULL;
   if (vswitch)
@@ -1777,7 +2080,7 @@ bse_midi_receiver_discard_poly_voice (BseMidiReceiver *self,
           mchannel->voices[voice_id] = NULL;
         }
     }
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
   if (!vswitch)
     Bse::warning ("MIDI channel %u has no voice %u", midi_channel, voice_id + 1);
 }
@@ -1796,11 +2099,11 @@ bse_midi_receiver_get_poly_voice_input (BseMidiReceiver   *self,
   assert_return (voice_id > 0, NULL);
   voice_id -= 1;
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   mchannel = self->get_channel (midi_channel);
   vswitch = voice_id < mchannel->n_voices ? mchannel->voices[voice_id] : NULL;
   module = vswitch ? vswitch->smodule : NULL;
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
   return module;
 }
 
@@ -1818,11 +2121,11 @@ bse_midi_receiver_get_poly_voice_output (BseMidiReceiver   *self,
   assert_return (voice_id > 0, NULL);
   voice_id -= 1;
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   mchannel = self->get_channel (midi_channel);
   vswitch = voice_id < mchannel->n_voices ? mchannel->voices[voice_id] : NULL;
   module = vswitch ? vswitch->vmodule : NULL;
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
   return module;
 }
 
@@ -1841,7 +2144,7 @@ bse_midi_receiver_create_sub_voice (BseMidiReceiver   *self,
   assert_return (voice_id > 0, NULL);
   voice_id -= 1;
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   mchannel = self->get_channel (midi_channel);
   vswitch = voice_id < mchannel->n_voices ? mchannel->voices[voice_id] : NULL;
   uint n = 0;
@@ -1849,12 +2152,12 @@ bse_midi_receiver_create_sub_voice (BseMidiReceiver   *self,
     {
       guint i = vswitch->n_vinputs++;
       vswitch->vinputs = g_renew (VoiceInput*, vswitch->vinputs, vswitch->n_vinputs);
-      vswitch->vinputs[i] = create_voice_input_L (&mchannel->voice_input_table, FALSE, trans);
+      vswitch->vinputs[i] = create_voice_input_L (&mchannel->voice_input_table, FALSE, self->mutex, trans);
       vswitch->ref_count++;
       module = vswitch->vinputs[i]->fmodule;
       n = vswitch->n_vinputs;
     }
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
   assert_return (n <= 1, module); // we don't actually ever create more than one vinput per vswitch
   return module;
 }
@@ -1876,7 +2179,7 @@ bse_midi_receiver_discard_sub_voice (BseMidiReceiver   *self,
   assert_return (voice_id > 0);
   voice_id -= 1;
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   mchannel = self->get_channel (midi_channel);
   vswitch = voice_id < mchannel->n_voices ? mchannel->voices[voice_id] : NULL;
   if (vswitch)
@@ -1901,7 +2204,7 @@ bse_midi_receiver_discard_sub_voice (BseMidiReceiver   *self,
           fmodule = NULL;
           break;
         }
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  BSE_MIDI_RECEIVER_UNLOCK (self);
   if (need_unref)
     bse_midi_receiver_discard_poly_voice (self, midi_channel, voice_id + 1, trans);
   if (fmodule)
@@ -1913,16 +2216,15 @@ bse_midi_receiver_voices_pending (BseMidiReceiver *self,
                                   guint            midi_channel)
 {
   MidiChannel *mchannel;
-  SfiRing *ring = NULL;
   guint i, active = 0;
 
   assert_return (self != NULL, FALSE);
   assert_return (midi_channel > 0, FALSE);
 
-  if (self->events)
+  if (!self->events.empty())
     return TRUE;
 
-  BSE_MIDI_RECEIVER_LOCK ();
+  BSE_MIDI_RECEIVER_LOCK (self);
   mchannel = self->get_channel (midi_channel);
   if (mchannel)
     {
@@ -1933,12 +2235,9 @@ bse_midi_receiver_voices_pending (BseMidiReceiver *self,
         active = active || (mchannel->voices[i] && !check_voice_switch_available_L (mchannel->voices[i]));
     }
   /* find pending events */
-  for (ring = self->events; ring && !active; ring = sfi_ring_next (ring, self->events))
-    {
-      BseMidiEvent *event = (BseMidiEvent *) ring->data;
-      active += event->channel == midi_channel;
-    }
-  BSE_MIDI_RECEIVER_UNLOCK ();
+  for (i = 0; i < self->events.size() && !active; i++)
+    active += self->events[i].event->channel == midi_channel;
+  BSE_MIDI_RECEIVER_UNLOCK (self);
 
   return active > 0;
 }
@@ -2095,15 +2394,16 @@ midi_receiver_process_event_L (BseMidiReceiver *self,
   BseMidiEvent *event;
   gboolean need_wakeup = FALSE;
 
-  if (!self->events)
+  event = self->peek_event();
+  if (!event)
     return FALSE;
 
-  event = (BseMidiEvent *) self->events->data;
   if (event->delta_time <= max_tick_stamp)
     {
+      Bse::EngineCapture::PlaybackScope playback;       // replaying MIDI input and playback recreates these
       BseTrans *trans = bse_trans_open ();
       MidiChannel *mchannel = self->peek_channel (event->channel);
-      self->events = sfi_ring_remove_node (self->events, self->events);
+      self->pop_event();
       uint event_status = event->status;
       if (mchannel && mchannel->call_event_handlers (event, trans))
         event_status = 0; // already handled
@@ -2195,3 +2495,85 @@ midi_receiver_process_event_L (BseMidiReceiver *self,
 
   return TRUE;
 }
+
+// == Testing ==
+#include "testing.hh"
+
+namespace { // Anon
+
+BSE_INTEGRITY_TEST (bse_midi_voice_stealing_policies);
+static void
+bse_midi_voice_stealing_policies ()
+{
+  using Bse::VoiceStealing;
+  // voice 0: busy, loud, plays the new note; 1: released, oldest release; 2: busy, oldest; 3: released, quietest
+  VoiceStealPicker picker;
+  picker.consider (0, 500, true,  true,  0.9);
+  picker.consider (1, 300, false, false, 0.5);
+  picker.consider (2, 100, true,  false, 0.4);
+  picker.consider (3, 400, false, false, 0.1);
+  TCMP (picker.victim (VoiceStealing::NONE), ==, -1);
+  TCMP (picker.victim (VoiceStealing::OLDEST), ==, 2);
+  TCMP (picker.victim (VoiceStealing::QUIETEST), ==, 3);
+  TCMP (picker.victim (VoiceStealing::SAME_NOTE), ==, 0);
+  TCMP (picker.victim (VoiceStealing::RELEASED_FIRST), ==, 1);
+  // fallbacks to the oldest voice without same note or released voices
+  VoiceStealPicker busy;
+  busy.consider (0, 200, true, false, 0.2);
+  busy.consider (1, 150, true, false, 0.3);
+  TCMP (busy.victim (VoiceStealing::SAME_NOTE), ==, 1);
+  TCMP (busy.victim (VoiceStealing::RELEASED_FIRST), ==, 1);
+  TCMP (busy.victim (VoiceStealing::QUIETEST), ==, 0);
+  // no candidates, e.g. all voices are restarting already
+  VoiceStealPicker none;
+  TCMP (none.victim (VoiceStealing::OLDEST), ==, -1);
+  TCMP (none.victim (VoiceStealing::RELEASED_FIRST), ==, -1);
+}
+
+BSE_INTEGRITY_TEST (bse_midi_voice_steal_fade);
+static void
+bse_midi_voice_steal_fade ()
+{
+  // a stolen voice jumps from a loud note to a new note with unrelated phase at the restart
+  constexpr guint SR = 48000, BLOCK = 64, FADE = SR * VOICE_STEAL_FADE_MS / 1000;
+  constexpr guint64 STEAL = 1000 + 37, RESTART = STEAL + FADE, END = RESTART + 2 * FADE;
+  constexpr double F1 = 880, F2 = 1320, AMP = 0.9;
+  const double before = AMP * sin (2 * M_PI * F1 * (RESTART - 1) / SR);
+  auto voice = [&] (guint64 t) {
+    return t < RESTART ? AMP * sin (2 * M_PI * F1 * t / SR) : (before > 0 ? -AMP : AMP) * cos (2 * M_PI * F2 * (t - RESTART) / SR);
+  };
+  const double max_slope = AMP * 2 * M_PI * F2 / SR;    // largest per sample change of the notes
+  VoiceStealFade fade;
+  fade.setup (STEAL, RESTART);
+  double max_jump = 0, last_in = 0, last_out = 0, max_in_jump = 0;
+  for (guint64 stamp = 1000 - 3 * BLOCK; stamp < END; stamp += BLOCK)
+    {
+      gfloat in[BLOCK], out[BLOCK], out2[BLOCK];
+      for (guint i = 0; i < BLOCK; i++)
+        in[i] = voice (stamp + i);
+      if (fade.passthrough (stamp, BLOCK))
+        std::copy (in, in + BLOCK, out);
+      else
+        fade.apply (stamp, in, in, out, out2, BLOCK);
+      for (guint i = 0; i < BLOCK; i++)
+        {
+          const guint64 t = stamp + i;
+          if (t > 1000 - 3 * BLOCK)
+            {
+              max_in_jump = MAX (max_in_jump, fabs (in[i] - last_in));
+              max_jump = MAX (max_jump, fabs (out[i] - last_out));
+            }
+          if (t < STEAL || t >= RESTART + FADE)
+            TCMP (out[i], ==, in[i]);           // untouched outside of the fade
+          if (t == RESTART - 1)
+            TCMP (out[i], ==, 0);               // faded out before the restart
+          last_in = in[i];
+          last_out = out[i];
+        }
+    }
+  TCMP (max_in_jump, >, 0.5);                   // the restart alone would click
+  TCMP (max_jump, <, max_slope + AMP / FADE * 2);
+  TASSERT (fade.passthrough (END, BLOCK));
+}
+
+} // Anon
@@ -76,6 +76,9 @@ void             bse_midi_receiver_channel_enable_poly     (BseMidiReceiver   *s
                                                             guint              midi_channel);
 void             bse_midi_receiver_channel_disable_poly    (BseMidiReceiver   *self,
                                                             guint              midi_channel);
+void             bse_midi_receiver_channel_set_voice_stealing (BseMidiReceiver *self,
+                                                            guint              midi_channel,
+                                                            Bse::VoiceStealing policy);
 guint            bse_midi_receiver_create_poly_voice       (BseMidiReceiver   *self,
                                                             guint              midi_channel,
                                                             BseTrans          *trans);
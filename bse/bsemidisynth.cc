@@ -80,6 +80,7 @@ bse_midi_synth_init (BseMidiSynth *self)
   self->set_flag (BSE_SUPER_FLAG_NEEDS_CONTEXT);
   self->midi_channel_id = 1;
   self->n_voices = 16;
+  self->voice_stealing = Bse::VoiceStealing::RELEASED_FIRST;
 }
 
 static void
@@ -245,6 +246,7 @@ bse_midi_synth_context_create (BseSource *source,
 	bse_snet_context_clone_branch (snet, context_handle, self->context_merger, mcontext, trans);
 
       bse_midi_receiver_channel_enable_poly (mcontext.midi_receiver, mcontext.midi_channel);
+      bse_midi_receiver_channel_set_voice_stealing (mcontext.midi_receiver, mcontext.midi_channel, self->voice_stealing);
     }
 }
 
@@ -419,6 +421,24 @@ MidiSynthImpl::n_voices() const
   return self->n_voices;
 }
 
+void
+MidiSynthImpl::voice_stealing (VoiceStealing policy)
+{
+  BseMidiSynth *self = as<BseMidiSynth*>();
+
+  VoiceStealing value = self->voice_stealing;
+  if (APPLY_IDL_PROPERTY (value, policy) && !BSE_SOURCE_PREPARED (self))
+    self->voice_stealing = value;
+}
+
+VoiceStealing
+MidiSynthImpl::voice_stealing() const
+{
+  BseMidiSynth *self = const_cast<MidiSynthImpl*> (this)->as<BseMidiSynth*>();
+
+  return self->voice_stealing;
+}
+
 void
 MidiSynthImpl::volume_f (double val)
 {
@@ -16,6 +16,7 @@
 struct BseMidiSynth : BseSNet {
   guint		 midi_channel_id;
   guint		 n_voices;
+  Bse::VoiceStealing voice_stealing;
   BseSNet       *snet;
   BseSNet       *pnet;
   BseSource	*voice_input;
@@ -42,6 +43,8 @@ public:
   virtual void    midi_channel   (int val) override;
   virtual int     n_voices       () const override;
   virtual void    n_voices       (int val) override;
+  virtual VoiceStealing voice_stealing () const override;
+  virtual void    voice_stealing (VoiceStealing val) override;
   virtual double  volume_f       () const override;
   virtual void    volume_f       (double val) override;
   virtual double  volume_dB      () const override;
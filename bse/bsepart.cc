@@ -105,6 +105,7 @@ bse_part_init (BsePart *self)
   self->ids = NULL;
   self->last_id = 0;
   self->last_tick_SL = 0;
+  self->timeline_SL = new BsePartTimeline();
   self->links_queued = FALSE;
   self->range_queued = FALSE;
   self->range_tick = BSE_PART_MAX_TICK;
@@ -199,6 +200,9 @@ bse_part_finalize (GObject *object)
   g_free (self->channels);
   self->channels = NULL;
 
+  delete self->timeline_SL;
+  self->timeline_SL = NULL;
+
   /* chain parent class' handler */
   G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -210,6 +214,132 @@ bse_part_set_semitone_table (BsePart      *self,
   assert_return (BSE_IS_PART (self));
   assert_return (semitone_table != NULL);
   self->semitone_table = semitone_table;
+  BSE_SEQUENCER_LOCK ();
+  for (BsePartTimelineEvent &tevent : self->timeline_SL->events)
+    if (!tevent.ctype)
+      tevent.freq = BSE_PART_NOTE_FREQ (self, &tevent);
+  BSE_SEQUENCER_UNLOCK ();
+}
+
+/* --- timeline --- */
+static bool
+timeline_event_before (const BsePartTimelineEvent &a, const BsePartTimelineEvent &b)
+{
+  return a.tick < b.tick || (a.tick == b.tick && a.ctype < b.ctype);
+}
+
+static BsePartTimelineEvent*
+part_timeline_find (BsePart *self,
+                    guint    tick,
+                    guint    id)
+{
+  std::vector<BsePartTimelineEvent> &events = self->timeline_SL->events;
+  BsePartTimelineEvent key = { 0 };
+  key.tick = tick;
+  for (auto it = std::lower_bound (events.begin(), events.end(), key, timeline_event_before);
+       it != events.end() && it->tick == tick; it++)
+    if (it->id == id)
+      return &*it;
+  return NULL;
+}
+
+static void
+part_timeline_insert (BsePart              *self,
+                      BsePartTimelineEvent &tevent)
+{
+  std::vector<BsePartTimelineEvent> &events = self->timeline_SL->events;
+  if (!tevent.ctype)
+    tevent.freq = BSE_PART_NOTE_FREQ (self, &tevent);
+  auto it = std::upper_bound (events.begin(), events.end(), tevent, timeline_event_before);
+  BSE_SEQUENCER_LOCK ();
+  events.insert (it, tevent);
+  self->timeline_SL->cursor = 0;
+  BSE_SEQUENCER_UNLOCK ();
+}
+
+static void
+part_timeline_insert_note (BsePart                *self,
+                           const BsePartEventNote &note)
+{
+  BsePartTimelineEvent tevent = { 0 };
+  tevent.tick = note.tick;
+  tevent.id = note.id;
+  tevent.duration = note.duration;
+  tevent.note = note.note;
+  tevent.fine_tune = note.fine_tune;
+  tevent.value = note.velocity;
+  part_timeline_insert (self, tevent);
+}
+
+static void
+part_timeline_insert_control (BsePart        *self,
+                              guint           tick,
+                              guint           id,
+                              Bse::MidiSignal ctype,
+                              gfloat          value)
+{
+  BsePartTimelineEvent tevent = { 0 };
+  tevent.tick = tick;
+  tevent.id = id;
+  tevent.ctype = guint (ctype);
+  tevent.value = value;
+  part_timeline_insert (self, tevent);
+}
+
+static void
+part_timeline_change_note (BsePart                *self,
+                           const BsePartEventNote &note)
+{
+  BsePartTimelineEvent *tevent = part_timeline_find (self, note.tick, note.id);
+  assert_return (tevent != NULL);
+  BSE_SEQUENCER_LOCK ();
+  tevent->note = note.note;
+  tevent->fine_tune = note.fine_tune;
+  tevent->value = note.velocity;
+  tevent->freq = BSE_PART_NOTE_FREQ (self, tevent);
+  BSE_SEQUENCER_UNLOCK ();
+}
+
+static void
+part_timeline_change_control (BsePart *self,
+                              guint    tick,
+                              guint    id,
+                              gfloat   value)
+{
+  BsePartTimelineEvent *tevent = part_timeline_find (self, tick, id);
+  assert_return (tevent != NULL);
+  BSE_SEQUENCER_LOCK ();
+  tevent->value = value;
+  BSE_SEQUENCER_UNLOCK ();
+}
+
+static void
+part_timeline_remove (BsePart *self,
+                      guint    tick,
+                      guint    id)
+{
+  std::vector<BsePartTimelineEvent> &events = self->timeline_SL->events;
+  BsePartTimelineEvent *tevent = part_timeline_find (self, tick, id);
+  assert_return (tevent != NULL);
+  BSE_SEQUENCER_LOCK ();
+  events.erase (events.begin() + (tevent - events.data()));
+  self->timeline_SL->cursor = 0;
+  BSE_SEQUENCER_UNLOCK ();
+}
+
+/// Index of the first timeline event at or after @a tick, resumes from the last position if possible.
+size_t
+bse_part_timeline_seek_SL (BsePart *self,
+                           guint    tick)
+{
+  BsePartTimeline &timeline = *self->timeline_SL;
+  const std::vector<BsePartTimelineEvent> &events = timeline.events;
+  size_t i = timeline.cursor;
+  if (i < events.size() && events[i].tick >= tick && (i == 0 || events[i - 1].tick < tick))
+    return i;
+  BsePartTimelineEvent key = { 0 };
+  key.tick = tick;
+  return std::lower_bound (events.begin(), events.end(), key, timeline_event_before) - events.begin();
 }
 
 static guint
@@ -692,6 +822,7 @@ bse_part_delete_note (BsePart           *self,
 
   /* remove note */
   queue_note_update (self, note);
+  part_timeline_remove (self, note->tick, id);
   tick = note->tick + note->duration;
   bse_part_note_channel_remove (&self->channels[channel], note->tick);
   bse_part_free_id (self, id);
@@ -716,6 +847,7 @@ bse_part_delete_control (BsePart *self,
   if (cev)
     {
       queue_control_update (self, tick);
+      part_timeline_remove (self, tick, id);
       bse_part_controls_remove (&self->controls, tick, cev);
       bse_part_free_id (self, id);
       if (tick >= self->last_tick_SL)
@@ -774,6 +906,7 @@ bse_part_insert_note (BsePart *self,
     }
   /* insert note */
   bse_part_note_channel_insert (&self->channels[channel], key);
+  part_timeline_insert_note (self, key);
   queue_note_update (self, &key);
   if (key.tick + key.duration >= self->last_tick_SL)
     part_update_last_tick (self);
@@ -819,12 +952,14 @@ bse_part_insert_control (BsePart          *self,
       {
         bse_part_controls_change (&self->controls, node, cev,
                                   cev->id, cev->selected, cev->ctype, value);
+        part_timeline_change_control (self, tick, cev->id, value);
         queue_control_update (self, tick);
         return cev->id;
       }
   /* insert new event */
   id = bse_part_alloc_id (self, tick);
   bse_part_controls_insert (&self->controls, node, id, FALSE, int64 (ctype), value);
+  part_timeline_insert_control (self, tick, id, ctype, value);
   queue_control_update (self, tick);
   if (tick >= self->last_tick_SL)
     part_update_last_tick (self);
@@ -905,15 +1040,20 @@ bse_part_change_note (BsePart *self,
   if (note->tick != key.tick || note->duration != key.duration)
     {
       guint ltick = note->tick + note->duration;
+      part_timeline_remove (self, note->tick, id);
       bse_part_note_channel_remove (&self->channels[i], note->tick);
       bse_part_move_id (self, id, tick);
       bse_part_note_channel_insert (&self->channels[channel], key);
+      part_timeline_insert_note (self, key);
       if (MAX (ltick, key.tick + key.duration) >= self->last_tick_SL)
         part_update_last_tick (self);
     }
   else
-    bse_part_note_channel_change_note (&self->channels[channel], note, key.id, key.selected,
-                                       key.note, key.fine_tune, key.velocity);
+    {
+      bse_part_note_channel_change_note (&self->channels[channel], note, key.id, key.selected,
+                                         key.note, key.fine_tune, key.velocity);
+      part_timeline_change_note (self, key);
+    }
   queue_note_update (self, &key);
 
   return TRUE;
@@ -962,16 +1102,28 @@ bse_part_change_control (BsePart           *self,
       selected = cev->selected;
       if (tick != old_tick)
         {
+          part_timeline_remove (self, old_tick, id);
           bse_part_controls_remove (&self->controls, old_tick, cev);    /* invalidates node */
           bse_part_move_id (self, id, tick);
           node = bse_part_controls_ensure_tick (&self->controls, tick);
           bse_part_controls_insert (&self->controls, node, id, selected, int64 (ctype), value);
+          part_timeline_insert_control (self, tick, id, ctype, value);
           queue_control_update (self, tick);
           if (MAX (old_tick, tick) >= self->last_tick_SL)
             part_update_last_tick (self);
         }
       else
-        bse_part_controls_change (&self->controls, node, cev, id, selected, int64 (ctype), value);
+        {
+          const bool retyped = cev->ctype != guint (ctype);
+          bse_part_controls_change (&self->controls, node, cev, id, selected, int64 (ctype), value);
+          if (retyped)  /* reorders within tick */
+            {
+              part_timeline_remove (self, tick, id);
+              part_timeline_insert_control (self, tick, id, ctype, value);
+            }
+          else
+            part_timeline_change_control (self, tick, id, value);
+        }
       return TRUE;
     }
   else
@@ -2400,3 +2552,131 @@ PartImpl::queue_notes (int tick, int duration, int min_note, int max_note)
 }
 
 } // Bse
+
+// == Testing ==
+#include "testing.hh"
+
+namespace { // Anon
+
+struct SweepEvent {
+  guint tick, id, duration, ctype;
+  gfloat freq, value;
+  bool
+  operator< (const SweepEvent &o) const
+  {
+    return tick < o.tick || (tick == o.tick && (ctype < o.ctype || (ctype == o.ctype && id < o.id)));
+  }
+  bool
+  operator== (const SweepEvent &o) const
+  {
+    return tick == o.tick && id == o.id && duration == o.duration && ctype == o.ctype && freq == o.freq && value == o.value;
+  }
+};
+
+// Events within [start_tick, tick_bound) from the per channel notes and the controls, as sequenced before the timeline.
+static std::vector<SweepEvent>
+part_scan_linear (BsePart *part, guint start_tick, guint tick_bound)
+{
+  std::vector<SweepEvent> sevents;
+  for (guint channel = 0; channel < part->n_channels; channel++)
+    {
+      BsePartEventNote *note = bse_part_note_channel_lookup_ge (&part->channels[channel], start_tick);
+      BsePartEventNote *bound = note ? bse_part_note_channel_get_bound (&part->channels[channel]) : NULL;
+      for (; note < bound && note->tick < tick_bound; note++)
+        sevents.push_back ({ note->tick, note->id, note->duration, 0, gfloat (BSE_PART_NOTE_FREQ (part, note)), note->velocity });
+    }
+  BsePartTickNode *node = bse_part_controls_lookup_ge (&part->controls, start_tick);
+  BsePartTickNode *last = bse_part_controls_lookup_lt (&part->controls, tick_bound);
+  if (node)
+    for (; node <= last; node++)
+      for (BsePartEventControl *cev = node->events; cev; cev = cev->next)
+        sevents.push_back ({ node->tick, cev->id, 0, cev->ctype, 0, cev->value });
+  std::sort (sevents.begin(), sevents.end());
+  return sevents;
+}
+
+// Events within [start_tick, tick_bound) from the timeline, like Sequencer::process_part_SL().
+static std::vector<SweepEvent>
+part_sweep_timeline (BsePart *part, guint start_tick, guint tick_bound)
+{
+  std::vector<SweepEvent> sevents;
+  const std::vector<BsePartTimelineEvent> &events = part->timeline_SL->events;
+  size_t i;
+  for (i = bse_part_timeline_seek_SL (part, start_tick); i < events.size() && events[i].tick < tick_bound; i++)
+    {
+      const BsePartTimelineEvent &tevent = events[i];
+      sevents.push_back ({ tevent.tick, tevent.id, tevent.duration, tevent.ctype, tevent.ctype ? 0 : tevent.freq, tevent.value });
+    }
+  part->timeline_SL->cursor = i;
+  std::sort (sevents.begin(), sevents.end());
+  return sevents;
+}
+
+static void
+part_compare_sweeps (BsePart *part, guint last_tick, uint32 &seed)
+{
+  auto rand = [&seed] (uint n) { seed = seed * 1664525 + 1013904223; return (seed >> 8) % n; };
+  size_t n_events = 0;
+  for (guint tick = 0; tick < last_tick; )                      // consecutive windows, resume from the cursor
+    {
+      const guint bound = tick + 1 + rand (97);
+      const std::vector<SweepEvent> linear = part_scan_linear (part, tick, bound);
+      TASSERT (part_sweep_timeline (part, tick, bound) == linear);
+      n_events += linear.size();
+      tick = bound;
+    }
+  TCMP (n_events, ==, part->timeline_SL->events.size());
+  for (uint i = 0; i < 50; i++)                                 // seeks and loops
+    {
+      const guint tick = rand (last_tick), bound = tick + 1 + rand (384);
+      TASSERT (part_sweep_timeline (part, tick, bound) == part_scan_linear (part, tick, bound));
+    }
+}
+
+BSE_INTEGRITY_TEST (bse_part_timeline_sweep);
+static void
+bse_part_timeline_sweep ()
+{
+  BsePart *part = (BsePart*) bse_object_new (BSE_TYPE_PART, NULL);
+  uint32 seed = 2020;
+  auto rand = [&seed] (uint n) { seed = seed * 1664525 + 1013904223; return (seed >> 8) % n; };
+  const guint last_tick = 384 * 16;
+  std::vector<std::pair<guint,guint>> notes; // (id, tick)
+  std::vector<guint> controls;
+  const Bse::MidiSignal ctypes[] = { Bse::MidiSignal::PRESSURE, Bse::MidiSignal::PITCH_BEND, Bse::MidiSignal::CONTINUOUS_1 };
+  for (uint i = 0; i < 400; i++)
+    {
+      // overlapping notes end up in several channels, simultaneous notes and controls share ticks
+      const guint tick = rand (last_tick / 48) * 48 + (rand (4) ? 0 : rand (48));
+      const guint id = bse_part_insert_note (part, ~uint (0), tick, 1 + rand (384), 48 + rand (36), int (rand (21)) - 10, 0.1 + rand (9) * 0.1);
+      if (id)
+        notes.push_back ({ id, tick });
+      if (rand (3) == 0)
+        controls.push_back (bse_part_insert_control (part, tick, ctypes[rand (3)], rand (201) * 0.01 - 1.0));
+    }
+  TCMP (part->n_channels, >, 1);
+  part_compare_sweeps (part, last_tick, seed);
+  // incremental timeline updates after edits
+  for (uint i = 0; i < notes.size(); i += 3)
+    for (guint channel = 0; channel < part->n_channels; channel++)
+      {
+        BsePartEventNote *note = bse_part_note_channel_lookup (&part->channels[channel], notes[i].second);
+        if (note && note->id == notes[i].first)
+          {
+            if (i % 2)
+              bse_part_delete_note (part, notes[i].first, channel);
+            else
+              bse_part_change_note (part, notes[i].first, channel, notes[i].second + rand (96), note->duration, note->note + 1, 0, 0.5);
+            break;
+          }
+      }
+  for (uint i = 0; i < controls.size(); i += 2)
+    if (controls[i] && i % 4)
+      bse_part_delete_control (part, controls[i]);
+    else if (controls[i])
+      bse_part_change_control (part, controls[i], rand (last_tick), Bse::MidiSignal::CONTINUOUS_2, 0.25);
+  part_compare_sweeps (part, last_tick + 96, seed);
+  g_object_unref (part);
+}
+
+} // Anon
@@ -21,6 +21,7 @@ struct BsePartControls {
 struct BsePartNoteChannel {
   GBSearchArray *bsa;
 };
+struct BsePartTimeline;
 struct BsePart : BseItem {
   const double       *semitone_table; // [-132..+132] only updated when not playing
   /* id -> tick lookups */
@@ -34,6 +35,8 @@ struct BsePart : BseItem {
   BsePartNoteChannel *channels;
   /* one after any tick used by controls or notes */
   guint               last_tick_SL;
+  /* all notes and controls, flattened for the sequencer */
+  BsePartTimeline    *timeline_SL;
   /* queued updates */
   guint               links_queued : 1;
   guint               range_queued : 1;
@@ -261,6 +264,25 @@ void              bse_part_note_channel_remove        (BsePartNoteChannel *self,
                                                        guint               tick);
 void              bse_part_note_channel_destroy       (BsePartNoteChannel *self);
 
+/* --- BsePartTimeline --- */
+struct BsePartTimelineEvent {
+  guint                  tick;
+  guint                  id;
+  guint                  duration;      /* note length in ticks, 0 for controls */
+  guint                  ctype;         /* Bse::MidiSignal for controls, 0 for notes */
+  gint                   note;
+  gint                   fine_tune;
+  gfloat                 freq;          /* precomputed note frequency */
+  gfloat                 value;         /* note velocity or control value */
+};
+struct BsePartTimeline {
+  std::vector<BsePartTimelineEvent> events;     /* ordered by tick, notes before controls */
+  size_t                            cursor = 0; /* sequencer position hint */
+};
+
+size_t            bse_part_timeline_seek_SL           (BsePart            *self,
+                                                       guint               tick);
+
 namespace Bse {
 
 class PartImpl : public ItemImpl, public virtual PartIface {
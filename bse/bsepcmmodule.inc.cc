@@ -28,6 +28,12 @@ struct BsePCMModuleData {
   bool            pcm_input_checked = false;
   Bse::AudioSignal::Engine *engine = nullptr;
   std::vector<Bse::AudioSignal::ProcessorP> procs;
+  struct Stem {
+    Bse::AudioSignal::ProcessorP proc;
+    BsePcmWriter      *writer = nullptr;
+    std::vector<float> buffer;
+  };
+  std::vector<Stem> stems;      // processor outputs recorded into separate writers
   explicit BsePCMModuleData (uint nv);
   ~BsePCMModuleData();
 };
@@ -88,6 +94,29 @@ bse_pcm_module_del_proc (BseModule *module, Bse::AudioSignal::ProcessorP procp)
   bse_trans_commit (trans);
 }
 
+static BsePCMModuleData::Stem
+bse_pcm_module_new_stem (Bse::AudioSignal::ProcessorP procp, BsePcmWriter *writer)
+{
+  BsePCMModuleData::Stem stem;
+  assert_return (procp != nullptr && writer != nullptr, stem);
+  stem.proc = procp;
+  stem.writer = writer;
+  stem.buffer.resize (BSE_ENGINE_MAX_BLOCK_SIZE * writer->n_channels);
+  return stem;
+}
+
+static void
+bse_pcm_module_set_stems (BseModule *module, std::vector<BsePCMModuleData::Stem> &&stems, BseTrans *trans)
+{
+  BsePCMModuleData *mdata = (BsePCMModuleData*) module->user_data;
+  // the stems are allocated in the UserThread, the engine only swaps vectors
+  auto sstems = std::make_shared<std::vector<BsePCMModuleData::Stem>> (std::move (stems));
+  auto sset = [mdata, sstems] () { // releases the old ProcessorPs with lambda destruction in UserThread
+    sstems->swap (mdata->stems);
+  };
+  bse_trans_add (trans, bse_job_access (module, sset));
+}
+
 static gboolean
 bse_pcm_module_poll (gpointer       data,
 		     guint          n_values,
@@ -157,6 +186,20 @@ bse_pcm_omodule_process (BseModule *module,
         do { *d += *src++; d += 2; } while (d < b);
       }
 
+  for (auto &stem : mdata->stems)
+    {
+      const uint n_channels = stem.writer->n_channels;
+      const uint n_ochannels = stem.proc->n_ochannels (MAIN_OBUS);
+      for (uint c = 0; c < n_channels; c++)
+        {
+          src = n_ochannels ? stem.proc->ofloats (MAIN_OBUS, MIN (c, n_ochannels - 1)) : bse_engine_const_zeros (n_values);
+          d = stem.buffer.data() + c;
+          for (i = 0; i < n_values; i++)
+            d[i * n_channels] = src[i];
+        }
+      bse_pcm_writer_write (stem.writer, n_values * n_channels, stem.buffer.data(), bse_module_tick_stamp (module));
+    }
+
   if (mdata->pcm_driver)
     mdata->pcm_driver->pcm_write (n_values * BSE_PCM_MODULE_N_JSTREAMS, mdata->buffer);
   if (mdata->pcm_writer)
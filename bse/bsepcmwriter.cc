@@ -1,8 +1,11 @@
 // Licensed GNU LGPL v2.1 or later: http://www.gnu.org/licenses/lgpl.html
 #include "bsepcmwriter.hh"
 #include "bseserver.hh"
-#include "gsldatautils.hh"
+#include "sndfiles.hh"
+#include "bseengine.hh"
 #include "bse/internal.hh"
+#include "bse/memory.hh"
+#include <condition_variable>
 #include <errno.h>
 #include <unistd.h>
 #include <sys/types.h>
@@ -66,10 +69,118 @@ bse_pcm_writer_finalize (GObject *object)
   self->mutex.~mutex();
 }
 
+// == BsePcmRecorder ==
+#define PCM_RECORDER_RING_SECONDS       (4)     /* audio buffered against disk stalls */
+#define PCM_RECORDER_CHUNK_VALUES       (16384) /* values encoded per Encoder::write() */
+#define PCM_RECORDER_POLL_MS            (20)    /* recorder thread wake up interval */
+
+/// Single producer, single consumer ring buffer between the engine and the recorder thread.
+struct BsePcmRecorder {
+  Bse::FastMemArray<float>  ring;
+  Bse::Snd::EncoderP        encoder;
+  std::atomic<uint64>       head { 0 };         // values pushed by the engine
+  std::atomic<uint64>       tail { 0 };         // values consumed by the recorder
+  std::atomic<uint64>       n_overflows { 0 };
+  std::atomic<uint64>       n_dropped { 0 };
+  std::atomic<bool>         broken { false };
+  explicit BsePcmRecorder (size_t ring_size, Bse::Snd::EncoderP enc) :
+    ring (ring_size), encoder (enc)
+  {}
+  bool
+  push (const float *values, size_t n_values)
+  {
+    const uint64 h = head.load (std::memory_order_relaxed);
+    const uint64 t = tail.load (std::memory_order_acquire);
+    if (ring.size() - (h - t) < n_values)
+      return false;
+    const size_t offset = h & (ring.size() - 1), l = MIN (n_values, ring.size() - offset);
+    std::copy (values, values + l, &ring[offset]);
+    std::copy (values + l, values + n_values, &ring[0]);
+    head.store (h + n_values, std::memory_order_release);
+    return true;
+  }
+};
+
+static void
+pcm_recorder_drain (BsePcmWriter *self)
+{
+  BsePcmRecorder &rec = *self->recorder;
+  const size_t mask = rec.ring.size() - 1;
+  while (!rec.broken)
+    {
+      const uint64 t = rec.tail.load (std::memory_order_relaxed);
+      const uint64 h = rec.head.load (std::memory_order_acquire);
+      const size_t offset = t & mask;
+      const size_t n = MIN (MIN (h - t, rec.ring.size() - offset), PCM_RECORDER_CHUNK_VALUES);
+      if (!n)
+        break;
+      const int err = rec.encoder->write (&rec.ring[offset], n);
+      rec.tail.store (t + n, std::memory_order_release);
+      if (err)
+        {
+          Bse::info ("failed to write %u values to %s: %s", n, rec.encoder->filename(), g_strerror (-err));
+          rec.broken = true;
+        }
+    }
+}
+
+// == PcmRecorder pool ==
+/* A single recorder thread encodes the rings of all open writers, i.e. the master and all stem recordings.
+ * Writers are added and removed from the UserThread, the engine only ever touches the rings.
+ */
+static std::mutex                 pool_mutex;   // protects pool_writers, pool_quit
+static std::condition_variable    pool_cond;
+static std::vector<BsePcmWriter*> pool_writers;
+static bool                       pool_quit = false;
+static std::thread                pool_thread;
+
+static void
+pcm_recorder_pool_thread ()
+{
+  Bse::this_thread_set_name ("PcmRecorder");
+  std::unique_lock<std::mutex> lock (pool_mutex);
+  while (!pool_quit)
+    {
+      for (BsePcmWriter *self : pool_writers)
+        pcm_recorder_drain (self);              // removal waits for the current round
+      pool_cond.wait_for (lock, std::chrono::milliseconds (PCM_RECORDER_POLL_MS));
+    }
+}
+
+static void
+pcm_recorder_pool_add (BsePcmWriter *self)
+{
+  std::lock_guard<std::mutex> locker (pool_mutex);
+  pool_writers.push_back (self);
+  if (!pool_thread.joinable())
+    {
+      pool_quit = false;
+      pool_thread = std::thread (pcm_recorder_pool_thread);
+    }
+}
+
+static void
+pcm_recorder_pool_remove (BsePcmWriter *self)
+{
+  std::thread thread;
+  pool_mutex.lock();
+  Bse::vector_erase_element (pool_writers, self);
+  if (pool_writers.empty())
+    {
+      pool_quit = true;
+      pool_cond.notify_one();
+      thread.swap (pool_thread);
+    }
+  pool_mutex.unlock();
+  if (thread.joinable())
+    thread.join();
+}
+
 Bse::Error
 bse_pcm_writer_open (BsePcmWriter *self,
 		     const gchar  *file,
 		     guint         n_channels,
+		     guint         n_bits,
 		     guint         sample_freq,
                      uint64        recorded_maximum)
 {
@@ -78,40 +189,46 @@ bse_pcm_writer_open (BsePcmWriter *self,
   assert_return (!self->open, Bse::Error::INTERNAL);
   assert_return (file != NULL, Bse::Error::INTERNAL);
   assert_return (n_channels > 0, Bse::Error::INTERNAL);
+  assert_return (n_bits == 16 || n_bits == 24 || n_bits == 32, Bse::Error::INTERNAL);
   assert_return (sample_freq >= 1000, Bse::Error::INTERNAL);
   self->mutex.lock();
-  self->n_bytes = 0;
+  self->n_values = 0;
+  self->n_channels = n_channels;
+  self->n_bits = n_bits;
   self->recorded_maximum = recorded_maximum;
   self->start_tick = atomic_trigger_tick;
-  fd = open (file, O_WRONLY | O_CREAT | O_TRUNC, 0666);
-  if (fd < 0)
-    {
-      self->mutex.unlock();
-      return bse_error_from_errno (errno, Bse::Error::FILE_OPEN_FAILED);
-    }
-
-  errno = bse_wave_file_dump_header (fd, 0x7fff0000, 16, n_channels, sample_freq);
-  if (errno)
+  int err = 0;
+  Bse::Snd::EncoderP encoder = Bse::Snd::Encoder::create (Bse::Snd::Encoder::format_from_filename (file), file,
+                                                          n_channels, n_bits, sample_freq, &err);
+  if (!encoder)
     {
-      close (fd);
       self->mutex.unlock();
-      return bse_error_from_errno (errno, Bse::Error::FILE_OPEN_FAILED);
+      return bse_error_from_errno (-err, Bse::Error::FILE_OPEN_FAILED);
     }
-  self->fd = fd;
   self->open = TRUE;
-  self->broken = FALSE;
+  const size_t ring_size = 1 << g_bit_storage (PCM_RECORDER_RING_SECONDS * sample_freq * n_channels - 1);
+  self->recorder = new BsePcmRecorder (ring_size, encoder);
+  pcm_recorder_pool_add (self);
   self->mutex.unlock();
   return Bse::Error::NONE;
 }
+
 void
 bse_pcm_writer_close (BsePcmWriter *self)
 {
   assert_return (BSE_IS_PCM_WRITER (self));
   assert_return (self->open);
   self->mutex.lock();
-  bse_wave_file_patch_length (self->fd, self->n_bytes);
-  close (self->fd);
-  self->fd = -1;
+  pcm_recorder_pool_remove (self);
+  pcm_recorder_drain (self);    // values queued after the last round
+  BsePcmRecorder *rec = self->recorder;
+  if (rec->n_overflows)
+    Bse::info ("PCM recording: %u buffer overflows, dropped %u frames", rec->n_overflows, rec->n_dropped / self->n_channels);
+  self->recorder = NULL;
+  const int err = rec->encoder->close();
+  if (err)
+    Bse::info ("failed to complete %s: %s", rec->encoder->filename(), g_strerror (-err));
+  delete rec;
   self->open = FALSE;
   self->mutex.unlock();
   errno = 0;
@@ -124,6 +241,30 @@ bsethread_halt_recording (gpointer data)
   return false;
 }
 
+/* Streams that are connected after the trigger tick, e.g. stems of late scheduled modules,
+ * get leading silence, so all recordings share the trigger tick as sample accurate start.
+ */
+static void
+pcm_writer_pad_start (BsePcmWriter *self, uint64 n_pad)
+{
+  BsePcmRecorder &rec = *self->recorder;
+  n_pad = MIN (n_pad, rec.ring.size() / 2);     // bounds padding for stale trigger ticks
+  if (self->recorded_maximum)
+    n_pad = MIN (n_pad, self->recorded_maximum);
+  n_pad -= n_pad % self->n_channels;
+  const float *zeros = bse_engine_const_zeros (BSE_ENGINE_MAX_BLOCK_SIZE);
+  for (uint64 i = 0; i < n_pad; i += BSE_ENGINE_MAX_BLOCK_SIZE)
+    {
+      const size_t n = MIN (n_pad - i, BSE_ENGINE_MAX_BLOCK_SIZE);
+      if (!rec.push (zeros, n))
+        {
+          rec.n_overflows += 1;
+          rec.n_dropped += n;
+        }
+    }
+  self->n_values += n_pad;
+}
+
 void
 bse_pcm_writer_write (BsePcmWriter *self, size_t n_values, const float *values, uint64 start_stamp)
 {
@@ -131,51 +272,94 @@ bse_pcm_writer_write (BsePcmWriter *self, size_t n_values, const float *values,
   assert_return (self->open);
   return_unless (n_values);
   assert_return (values != NULL);
-  if (UNLIKELY (start_stamp + n_values <= self->start_tick))
+  const uint n_channels = self->n_channels;
+  if (UNLIKELY (start_stamp + n_values / n_channels <= self->start_tick))
     {
-      self->mutex.lock();
       self->start_tick = atomic_trigger_tick;
-      self->mutex.unlock();
-      if (start_stamp + n_values <= self->start_tick)
+      if (start_stamp + n_values / n_channels <= self->start_tick)
         return; // writer not yet activated
     }
   if (self->start_tick > start_stamp)
     {
-      const uint64 delta = self->start_tick - start_stamp;
+      const uint64 delta = (self->start_tick - start_stamp) * n_channels;
       n_values -= delta;
       values += delta;
-      start_stamp += delta;
     }
-  self->mutex.lock();
-  const uint bw = 2; /* 16bit */
-  if (!self->broken && (!self->recorded_maximum || self->n_bytes < bw * self->recorded_maximum))
+  BsePcmRecorder &rec = *self->recorder;
+  if (rec.broken || (self->recorded_maximum && self->n_values >= self->recorded_maximum))
+    return;
+  if (UNLIKELY (self->n_values == 0 && start_stamp > self->start_tick))
+    pcm_writer_pad_start (self, (start_stamp - self->start_tick) * n_channels);
+  if (self->recorded_maximum)
+    n_values = MIN (n_values, self->recorded_maximum - self->n_values);
+  // never block the engine, account for values that don't fit instead
+  if (!rec.push (values, n_values))
     {
-      guint j;
-      guint8 *dest = g_new (guint8, n_values * bw);
-      uint n_bytes = gsl_conv_from_float_clip (GSL_WAVE_FORMAT_SIGNED_16,
-                                               G_BYTE_ORDER,
-                                               values,
-                                               dest,
-                                               n_values);
-      if (self->recorded_maximum)
-        n_bytes = bw * MIN (n_bytes / bw, self->recorded_maximum - self->n_bytes / bw);
-      do
-	j = write (self->fd, dest, n_bytes);
-      while (j < 0 && errno == EINTR);
-      if (j > 0)
-        {
-          self->n_bytes += j;
-          if (self->recorded_maximum && self->n_bytes >= bw * self->recorded_maximum)
-            bse_idle_next (bsethread_halt_recording, NULL);
-        }
-      g_free (dest);
-      if (j < 0 && errno)
-	{
- 	  Bse::info ("failed to write %u bytes to WAV file: %s", n_bytes, g_strerror (errno));
-	  self->broken = TRUE;
-	}
+      rec.n_overflows += 1;
+      rec.n_dropped += n_values;
     }
-  self->mutex.unlock();
+  self->n_values += n_values;
+  if (self->recorded_maximum && self->n_values >= self->recorded_maximum)
+    bse_idle_next (bsethread_halt_recording, NULL);
+}
+
+// == PcmWriterTap ==
+#define PCM_WRITER_TAP_MAX_CHANNELS     (8)
+
+/// Engine module that records the sum of each jstream as one channel of a BsePcmWriter.
+class PcmWriterTap : public Bse::Module {
+  BsePcmWriter *const writer_;
+  float              *buffer_ = nullptr;
+public:
+  explicit
+  PcmWriterTap (const BseModuleClass &klass, BsePcmWriter *writer) :
+    Module (klass), writer_ (writer)
+  {
+    buffer_ = (float*) Bse::fast_mem_alloc (BSE_ENGINE_MAX_BLOCK_SIZE * klass.n_jstreams * sizeof (float));
+  }
+  virtual
+  ~PcmWriterTap()
+  {
+    Bse::fast_mem_free (buffer_);
+  }
+  virtual void
+  reset () override
+  {}
+  virtual void
+  process (uint n_values) override // EngineThread
+  {
+    const uint n_channels = klass.n_jstreams;
+    for (uint c = 0; c < n_channels; c++)
+      {
+        const BseJStream &jstream = BSE_MODULE_JSTREAM (this, c);
+        float *d = buffer_ + c;
+        const float *src = jstream.n_connections ? jstream.values[0] : bse_engine_const_zeros (n_values);
+        for (uint i = 0; i < n_values; i++)
+          d[i * n_channels] = src[i];
+        for (uint j = 1; j < jstream.n_connections; j++)
+          for (uint i = 0; i < n_values; i++)
+            d[i * n_channels] += jstream.values[j][i];
+      }
+    bse_pcm_writer_write (writer_, n_values * n_channels, buffer_, bse_module_tick_stamp (this));
+  }
+};
+
+BseModule*
+bse_pcm_writer_tap_new (BsePcmWriter *self)
+{
+  assert_return (BSE_IS_PCM_WRITER (self), NULL);
+  assert_return (self->open, NULL);
+  assert_return (self->n_channels <= PCM_WRITER_TAP_MAX_CHANNELS, NULL);
+  static const BseModuleClass *const tap_classes = [] () {
+    static BseModuleClass classes[PCM_WRITER_TAP_MAX_CHANNELS] = {};
+    for (uint i = 0; i < PCM_WRITER_TAP_MAX_CHANNELS; i++)
+      {
+        classes[i].n_jstreams = 1 + i;
+        classes[i].mflags = Bse::ModuleFlag::CHEAP;
+      }
+    return classes;
+  } ();
+  return new PcmWriterTap (tap_classes[self->n_channels - 1], self);
 }
 
 namespace Bse {
@@ -200,3 +384,80 @@ PcmWriterImpl::trigger_tick (uint64 start_tick)
 }
 
 } // Bse
+
+// == Testing ==
+#include "testing.hh"
+
+namespace { // Anon
+using namespace Bse;
+
+static float
+stem_test_value (uint64 stamp, uint channel)
+{
+  return (stamp % 1000) * 0.001 + channel * 0.25;
+}
+
+BSE_INTEGRITY_TEST (bse_pcm_writer_stem_alignment);
+static void
+bse_pcm_writer_stem_alignment ()
+{
+  const String dir = Path::join (Path::cache_home(), "bse-tests");
+  Path::mkdirs (dir);
+  const uint64 saved_trigger_tick = atomic_trigger_tick;
+  const uint64 trigger = 48000 * 10 + 17;
+  const uint block = 64, n_blocks = 40;
+  PcmWriterImpl::trigger_tick (trigger);
+  // both stems share the recorder pool
+  const String names[2] = { Path::join (dir, string_format ("stem-a-%u.wav", getpid())),
+                            Path::join (dir, string_format ("stem-b-%u.wav", getpid())) };
+  const uint n_channels[2] = { 2, 1 };
+  BsePcmWriter *writers[2];
+  for (uint w = 0; w < 2; w++)
+    {
+      writers[w] = (BsePcmWriter*) bse_object_new (BSE_TYPE_PCM_WRITER, NULL);
+      TASSERT (bse_pcm_writer_open (writers[w], names[w].c_str(), n_channels[w], 32, 48000, 0) == Bse::Error::NONE);
+    }
+  {
+    std::lock_guard<std::mutex> locker (pool_mutex);
+    TASSERT (pool_thread.joinable());
+    TASSERT (std::find (pool_writers.begin(), pool_writers.end(), writers[0]) != pool_writers.end());
+    TASSERT (std::find (pool_writers.begin(), pool_writers.end(), writers[1]) != pool_writers.end());
+  }
+  // stem A is tapped before the trigger tick and gets trimmed, stem B is connected late and gets padded
+  const uint64 first_stamp[2] = { trigger - block - 5, trigger + 3 * block + 7 };
+  for (uint w = 0; w < 2; w++)
+    for (uint64 stamp = first_stamp[w]; stamp < trigger + n_blocks * block; stamp += block)
+      {
+        float values[2 * block];
+        for (uint i = 0; i < block; i++)
+          for (uint c = 0; c < n_channels[w]; c++)
+            values[i * n_channels[w] + c] = stem_test_value (stamp + i, c);
+        bse_pcm_writer_write (writers[w], block * n_channels[w], values, stamp);
+      }
+  for (uint w = 0; w < 2; w++)
+    {
+      bse_pcm_writer_close (writers[w]);
+      g_object_unref (writers[w]);
+    }
+  PcmWriterImpl::trigger_tick (saved_trigger_tick);
+  // both files start with the sample at the trigger tick
+  for (uint w = 0; w < 2; w++)
+    {
+      const String data = Path::stringread (names[w]);
+      unlink (names[w].c_str());
+      const size_t data_offset = 80;    // Snd::WavWriter layout
+      TCMP (data.substr (data_offset - 8, 4), ==, "data");
+      TASSERT (data.size() >= data_offset + n_blocks * block * n_channels[w] * sizeof (float));
+      const float *fvalues = (const float*) &data[data_offset];
+      const uint64 n_pad = first_stamp[w] > trigger ? first_stamp[w] - trigger : 0;
+      for (uint64 i = 0; i < n_blocks * block; i++)
+        for (uint c = 0; c < n_channels[w]; c++)
+          {
+            const float expected = i < n_pad ? 0.0 : stem_test_value (trigger + i, c);
+            if (fvalues[i * n_channels[w] + c] != expected)
+              TCMP (fvalues[i * n_channels[w] + c], ==, expected);
+          }
+    }
+}
+
+} // Anon
@@ -14,24 +14,28 @@
 
 
 /* --- BsePcmWriter  --- */
+struct BsePcmRecorder;
 struct BsePcmWriter : BseItem {
   std::mutex	mutex;
   guint		open : 1;
-  guint		broken : 1;
-  gint		fd;
-  Bse::uint64	n_bytes;
+  guint         n_channels;
+  guint         n_bits;                 /* 16, 24 or 32 (float) */
+  Bse::uint64   n_values;               /* queued by the engine thread */
   Bse::uint64   recorded_maximum;
   Bse::uint64   start_tick;
+  BsePcmRecorder *recorder;
 };
 struct BsePcmWriterClass : BseItemClass
 {};
 
-Bse::Error bse_pcm_writer_open	(BsePcmWriter *pdev, const gchar *file, guint n_channels,
+Bse::Error bse_pcm_writer_open	(BsePcmWriter *pdev, const gchar *file, guint n_channels, guint n_bits,
                                  guint sample_freq, Bse::uint64 recorded_maximum);
 void	   bse_pcm_writer_close	(BsePcmWriter *pdev);
-/* writing is lock protected */
+/* writing is lock-free, the recorder thread performs all encoding and disk IO */
 void	   bse_pcm_writer_write	(BsePcmWriter *pdev, size_t n_values,
                                  const float *values, Bse::uint64 start_stamp);
+/* engine module that records the sum of its jstream i as channel i, must be discarded before closing */
+BseModule* bse_pcm_writer_tap_new (BsePcmWriter *pdev);
 
 namespace Bse {
 
@@ -797,6 +797,7 @@ bse_project_start_playback (BseProject *self)
       if (BSE_IS_SONG (super))
 	songs = sfi_ring_append (songs, super);
     }
+  BSE_SERVER.connect_stem_taps (self, trans);
   if (!songs) // start pcm-writer ASAP if no songs are present
     Bse::PcmWriterImpl::trigger_tick (Bse::TickStamp::current());
   /* enfore MasterThread roundtrip */
@@ -825,6 +826,7 @@ bse_project_stop_playback (BseProject *self)
   assert_return (BSE_SOURCE_PREPARED (self) == TRUE);
 
   trans = bse_trans_open ();
+  BSE_SERVER.disconnect_stem_taps (self, trans);
   for (slist = self->supers; slist; slist = slist->next)
     {
       BseSuper *super = BSE_SUPER (slist->data);
@@ -11,21 +11,27 @@
 #include "bsepcmwriter.hh"
 #include "bseieee754.hh"
 #include "bsestartup.hh"        // for TaskRegistry
+#include "enginecapture.hh"
 #include "bse/internal.hh"
 #include <sys/poll.h>
 #include <errno.h>
 #include <string.h>
 #include <vector>
+#include <set>
 
 #define SDEBUG(...)     Bse::debug ("sequencer", __VA_ARGS__)
 #define SDUMP(...)      Bse::debug ("sequencer-events", __VA_ARGS__)
 
-#define	BSE_SEQUENCER_FUTURE_BLOCKS    (7)
+#define	BSE_SEQUENCER_FUTURE_BLOCKS    (7)     /* initial lookahead */
+#define	BSE_SEQUENCER_MIN_BLOCKS       (3)
+#define	BSE_SEQUENCER_MAX_BLOCKS       (48)
+#define	BSE_SEQUENCER_RELAX_ITERATIONS (1024)  /* iterations without pressure before shrinking the lookahead */
+#define	BSE_SEQUENCER_MAX_WORKERS      (3)     /* threads helping the sequencer thread with multiple songs */
 
 namespace Bse {
 
 Sequencer              *Sequencer::singleton_ = NULL;
-std::mutex              Sequencer::sequencer_mutex_;
+std::shared_mutex       Sequencer::sequencer_mutex_;
 static Bse::ThreadId    sequencer_thread_self;
 
 class Sequencer::PollPool {
@@ -130,13 +136,126 @@ public:
   static_assert (sizeof (((GPollFD*) 0)->revents) == sizeof (((struct pollfd*) 0)->revents), "");
 };
 
+namespace { // Anon
+
+/** Worker threads that sequence the songs of one sequencer iteration concurrently.
+ * Songs own their tracks, parts and MIDI receiver, so they can be processed independently
+ * while the sequencer thread holds sequencer_mutex_ in shared mode for the whole batch.
+ */
+class SongBatchWorkers {
+public:
+  /// Sequence one song up to `next_stamp`, returns the underrun in blocks.
+  using SongJob = std::function<uint (BseSong *song, uint64 cur_stamp, uint64 next_stamp)>;
+private:
+  const SongJob             song_job_;
+  std::mutex                mutex_;
+  std::condition_variable   work_cond_, done_cond_;
+  std::vector<std::thread*> threads_;
+  std::vector<BseSong*>     songs_;
+  std::atomic<size_t>       next_song_ { 0 };
+  std::atomic<uint>         underrun_blocks_ { 0 };
+  uint64                    cur_stamp_ = 0, next_stamp_ = 0;
+  uint64                    batch_ = 0;
+  uint                      n_busy_ = 0;
+  bool                      running_ = true;
+  void
+  drain_songs ()
+  {
+    for (size_t i = next_song_++; i < songs_.size(); i = next_song_++)
+      {
+        const uint blocks = song_job_ (songs_[i], cur_stamp_, next_stamp_);
+        uint last = underrun_blocks_;
+        while (blocks > last && !underrun_blocks_.compare_exchange_weak (last, blocks))
+          ;
+      }
+  }
+  void
+  worker_thread (uint nth, uint64 last_batch)
+  {
+    const String myid = string_format ("BseSequencer-#%u", nth);
+    this_thread_set_name (myid);
+    TaskRegistry::add (myid, this_thread_getpid(), this_thread_gettid());
+    EngineCapture::PlaybackScope playback;
+    std::unique_lock<std::mutex> guard (mutex_);
+    while (running_)
+      {
+        if (last_batch == batch_)
+          {
+            work_cond_.wait (guard);
+            continue;
+          }
+        last_batch = batch_;
+        guard.unlock();
+        drain_songs();
+        guard.lock();
+        if (--n_busy_ == 0)
+          done_cond_.notify_all();
+      }
+    TaskRegistry::remove (this_thread_gettid());
+  }
+public:
+  explicit
+  SongBatchWorkers (const SongJob &song_job) :
+    song_job_ (song_job)
+  {}
+  ~SongBatchWorkers()
+  {
+    mutex_.lock();
+    running_ = false;
+    mutex_.unlock();
+    work_cond_.notify_all();
+    for (std::thread *thread : threads_)
+      {
+        thread->join();
+        delete thread;
+      }
+  }
+  /// Sequence `songs` up to `next_stamp`, returns the maximum underrun in blocks.
+  uint
+  sequence (SfiRing *songs, uint64 cur_stamp, uint64 next_stamp)
+  {
+    songs_.clear();
+    for (SfiRing *ring = songs; ring; ring = sfi_ring_walk (ring, songs))
+      songs_.push_back (BSE_SONG (ring->data));
+    cur_stamp_ = cur_stamp;
+    next_stamp_ = next_stamp;
+    next_song_ = 0;
+    underrun_blocks_ = 0;
+    const size_t n_threads = MIN (BSE_SEQUENCER_MAX_WORKERS + 1, MAX (1, this_thread_online_cpus()));
+    const size_t n_workers = songs_.empty() ? 0 : MIN (songs_.size(), n_threads) - 1;
+    if (n_workers == 0)         // single song or single CPU, no need to hand off
+      {
+        drain_songs();
+        return underrun_blocks_;
+      }
+    std::unique_lock<std::mutex> guard (mutex_);
+    while (threads_.size() < n_workers)
+      threads_.push_back (new std::thread (&SongBatchWorkers::worker_thread, this, threads_.size() + 1, batch_));
+    n_busy_ = threads_.size();
+    batch_++;
+    guard.unlock();
+    work_cond_.notify_all();
+    drain_songs();
+    guard.lock();
+    while (n_busy_)
+      done_cond_.wait (guard);
+    return underrun_blocks_;
+  }
+};
+
+} // Anon
+
+class Sequencer::SongWorkers : public SongBatchWorkers {
+public:
+  using SongBatchWorkers::SongBatchWorkers;
+};
+
 void
 Sequencer::add_io_watch (uint n_pfds, const GPollFD *pfds, BseIOWatch watch_func, void *watch_data)
 {
   assert_return (watch_func != NULL);
-  BSE_SEQUENCER_LOCK();
+  std::lock_guard<std::mutex> watch_guard (watch_mutex_);
   poll_pool_->add_watch (n_pfds, pfds, watch_func, watch_data);
-  BSE_SEQUENCER_UNLOCK();
 }
 
 static BseIOWatch current_watch_func = NULL;    // global guards allow removal of watch function while it's in use
@@ -160,7 +279,7 @@ Sequencer::remove_io_watch (BseIOWatch watch_func, void *watch_data)
    *   least conceptually) or has never been installed
    */
   bool removal_success;
-  std::unique_lock<std::mutex> sequencer_guard (sequencer_mutex_);
+  std::unique_lock<std::mutex> watch_guard (watch_mutex_);
   if (current_watch_func == watch_func && current_watch_data == watch_data)
     {  /* watch_func() to be removed is currently in call */
       if (Bse::this_thread_self() == sequencer_thread_self)
@@ -176,7 +295,7 @@ Sequencer::remove_io_watch (BseIOWatch watch_func, void *watch_data)
           current_watch_needs_remove2 = true;
           /* wait until watch_func() call has finished */
           while (current_watch_func == watch_func && current_watch_data == watch_data)
-            watch_cond_.wait (sequencer_guard);
+            watch_cond_.wait (watch_guard);
         }
     }
   else /* can remove (watch_func(watch_data) not in call) */
@@ -190,19 +309,20 @@ Sequencer::remove_io_watch (BseIOWatch watch_func, void *watch_data)
 }
 
 bool
-Sequencer::pool_poll_Lm (gint timeout_ms)
+Sequencer::pool_poll (gint timeout_ms)
 {
+  std::unique_lock<std::mutex> watch_guard (watch_mutex_);
   uint n_pfds = poll_pool_->get_n_pfds() + 1;   // one for the wake-up event_fd_
   GPollFD *pfds = g_newa (GPollFD, n_pfds);
   pfds[0].fd = event_fd_.inputfd();
   pfds[0].events = G_IO_IN;
   pfds[0].revents = 0;
   poll_pool_->fill_pfds (n_pfds - 1, pfds + 1); // rest used for io watch array
-  BSE_SEQUENCER_UNLOCK();
+  watch_guard.unlock();
   int result = poll ((struct pollfd*) pfds, n_pfds, timeout_ms);
   if (result < 0 && errno != EINTR)
     printerr ("%s: poll() error: %s\n", __func__, g_strerror (errno));
-  BSE_SEQUENCER_LOCK();
+  watch_guard.lock();
   if (result > 0 && pfds[0].revents)
     {
       event_fd_.flush();                        // eat wake up message
@@ -216,9 +336,9 @@ Sequencer::pool_poll_Lm (gint timeout_ms)
       while (poll_pool_->fetch_notify_watch (current_watch_func, current_watch_data, watch_n_pfds, watch_pfds))
         {
           assert_return (!current_watch_needs_remove1 && !current_watch_needs_remove2, false);
-          BSE_SEQUENCER_UNLOCK();
+          watch_guard.unlock();
           bool current_watch_stays_alive = current_watch_func (current_watch_data, watch_n_pfds, watch_pfds);
-          BSE_SEQUENCER_LOCK();
+          watch_guard.lock();
           if (current_watch_needs_remove1 ||            // removal queued from within io handler
               current_watch_needs_remove2 ||            // removal queued from other thread
               !current_watch_stays_alive)               // removal requested by io handler return value
@@ -327,6 +447,52 @@ Sequencer::thread_lagging (uint n_blocks)
   return lagging;
 }
 
+/// Adjust the lookahead to the measured processing time, grow quickly on underruns, shrink slowly.
+void
+Sequencer::adapt_lookahead_SL (uint64 process_us, uint underrun_blocks)
+{
+  const double block_us = bse_engine_block_size() * 1000000.0 / MAX (1, bse_engine_sample_freq());
+  process_peak_us_ = MAX (double (process_us), process_peak_us_ * 0.995);
+  if (block_us <= 0)
+    return;
+  // a sequencer iteration must comfortably fit into the lookahead, even at peak processing times
+  const uint needed = CLAMP (BSE_SEQUENCER_MIN_BLOCKS + uint (std::ceil (2 * process_peak_us_ / block_us)),
+                             BSE_SEQUENCER_MIN_BLOCKS, BSE_SEQUENCER_MAX_BLOCKS);
+  if (underrun_blocks)
+    {
+      underruns_++;
+      const uint bucket = MIN (LATENESS_BUCKETS - 1, uint (std::log2 (underrun_blocks)));
+      lateness_[bucket]++;
+      lookahead_blocks_ = MIN (BSE_SEQUENCER_MAX_BLOCKS, MAX (needed, lookahead_blocks_ + underrun_blocks + 1));
+      relaxed_iterations_ = 0;
+    }
+  else if (needed > lookahead_blocks_)
+    {
+      lookahead_blocks_ = needed;
+      relaxed_iterations_ = 0;
+    }
+  else if (needed < lookahead_blocks_ && ++relaxed_iterations_ >= BSE_SEQUENCER_RELAX_ITERATIONS)
+    {
+      lookahead_blocks_--;
+      relaxed_iterations_ = 0;
+    }
+}
+
+/// Retrieve lookahead and underrun telemetry, MT-Safe.
+Sequencer::Stats
+Sequencer::stats ()
+{
+  Stats stats;
+  BSE_SEQUENCER_LOCK();
+  stats.underruns = underruns_;
+  stats.lookahead_blocks = lookahead_blocks_;
+  stats.process_usecs = process_peak_us_;
+  for (uint i = 0; i < LATENESS_BUCKETS; i++)
+    stats.lateness[i] = lateness_[i];
+  BSE_SEQUENCER_UNLOCK();
+  return stats;
+}
+
 static std::atomic<bool> sequencer_thread_running { false };
 
 void
@@ -336,64 +502,72 @@ Sequencer::sequencer_thread ()
   Bse::this_thread_set_name (myid);
   Bse::TaskRegistry::add (myid, Bse::this_thread_getpid(), Bse::this_thread_gettid());
   sequencer_thread_self = Bse::this_thread_self();
+  Bse::EngineCapture::PlaybackScope playback;   // transactions for song playback are recreated by a replay
   SDEBUG ("thrdstrt: now=%llu", Bse::TickStamp::current());
   Bse::TickStampWakeupP wakeup = Bse::TickStamp::create_wakeup ([&]() { this->wakeup(); });
-  BSE_SEQUENCER_LOCK();
   do
     {
+      sequencer_mutex_.lock_shared();
+      const uint64 process_start = timestamp_realtime();
       const guint64 cur_stamp = Bse::TickStamp::current();
-      guint64 next_stamp = cur_stamp + BSE_SEQUENCER_FUTURE_BLOCKS * bse_engine_block_size();
-      SfiRing *ring;
-      for (ring = songs_; ring; ring = sfi_ring_walk (ring, songs_))
-	{
-          BseSong *song = BSE_SONG (ring->data);
-          bool forced_ticks = 0;
-          if (!song->sequencer_start_SL && song->sequencer_start_request_SL <= next_stamp + bse_engine_block_size())
-            {
-              song->sequencer_start_SL = next_stamp;
-              forced_ticks = bse_engine_block_size();
-            }
-          if (song->sequencer_start_SL && !song->sequencer_done_SL)
-            {
-              gdouble stamp_diff = (next_stamp - song->sequencer_start_SL) - song->delta_stamp_SL;
-              guint64 old_song_pos = bse_dtoll (song->sequencer_start_SL + song->delta_stamp_SL);
-              gboolean song_starting = song->delta_stamp_SL == 0;
-              if (UNLIKELY (forced_ticks))
-                stamp_diff = MAX (stamp_diff, 1);
-	      while (stamp_diff > 0)
-		{
-		  guint n_ticks = bse_dtoi (stamp_diff * song->tpsi_SL);
-                  if (UNLIKELY (forced_ticks))
-                    {
-                      n_ticks = MAX (n_ticks, forced_ticks);
-                      forced_ticks = 0;
-                    }
-		  if (n_ticks < 1)
-		    break;
-		  process_song_SL (song, n_ticks);
-		  stamp_diff = (next_stamp - song->sequencer_start_SL) - song->delta_stamp_SL;
-		}
-              if (old_song_pos <= cur_stamp && !song_starting) /* detect underrun after song start */
-                {
-                  gchar *dh = bse_object_strdup_debug_handle (song);    /* thread safe */
-                  /* if (!song->sequencer_underrun_detected_SL) */
-                  printerr ("BseSequencer: underrun by %lld blocks for song: %s\n",
-                              uint64 ((cur_stamp - old_song_pos) / bse_engine_block_size() + 1),
-                              dh);
-                  song->sequencer_underrun_detected_SL = TRUE;
-                  g_free (dh);
-                }
-	    }
-	}
-      stamp_ = next_stamp;
+      guint64 next_stamp = cur_stamp + lookahead_blocks_ * bse_engine_block_size();
+      const uint underrun_blocks = song_workers_->sequence (songs_, cur_stamp, next_stamp);
+      stamp_ = MAX (stamp_, next_stamp);
+      adapt_lookahead_SL (timestamp_realtime() - process_start, underrun_blocks);
+      sequencer_mutex_.unlock_shared();
       wakeup->awake_after (cur_stamp + bse_engine_block_size ());
     }
-  while (pool_poll_Lm (-1) && sequencer_thread_running);
-  BSE_SEQUENCER_UNLOCK();
+  while (pool_poll (-1) && sequencer_thread_running);
   SDEBUG ("thrdstop: now=%llu", Bse::TickStamp::current());
   Bse::TaskRegistry::remove (Bse::this_thread_gettid());
 }
 
+/// Sequence `song` up to `next_stamp`, called concurrently for different songs, returns the underrun in blocks.
+uint
+Sequencer::sequence_song_SL (BseSong *song, uint64 cur_stamp, uint64 next_stamp)
+{
+  uint underrun_blocks = 0;
+  bool forced_ticks = 0;
+  if (!song->sequencer_start_SL && song->sequencer_start_request_SL <= next_stamp + bse_engine_block_size())
+    {
+      song->sequencer_start_SL = next_stamp;
+      forced_ticks = bse_engine_block_size();
+    }
+  if (song->sequencer_start_SL && !song->sequencer_done_SL)
+    {
+      gdouble stamp_diff = (next_stamp - song->sequencer_start_SL) - song->delta_stamp_SL;
+      guint64 old_song_pos = bse_dtoll (song->sequencer_start_SL + song->delta_stamp_SL);
+      gboolean song_starting = song->delta_stamp_SL == 0;
+      if (UNLIKELY (forced_ticks))
+        stamp_diff = MAX (stamp_diff, 1);
+      while (stamp_diff > 0)
+        {
+          guint n_ticks = bse_dtoi (stamp_diff * song->tpsi_SL);
+          if (UNLIKELY (forced_ticks))
+            {
+              n_ticks = MAX (n_ticks, forced_ticks);
+              forced_ticks = 0;
+            }
+          if (n_ticks < 1)
+            break;
+          process_song_SL (song, n_ticks);
+          stamp_diff = (next_stamp - song->sequencer_start_SL) - song->delta_stamp_SL;
+        }
+      if (old_song_pos <= cur_stamp && !song_starting) /* detect underrun after song start */
+        {
+          const uint blocks = (cur_stamp - old_song_pos) / bse_engine_block_size() + 1;
+          gchar *dh = bse_object_strdup_debug_handle (song);    /* thread safe */
+          SDEBUG ("underrun by %u blocks for song: %s (lookahead: %u blocks)", blocks, dh, lookahead_blocks_);
+          if (!song->sequencer_underrun_detected_SL)
+            printerr ("BseSequencer: underrun by %u blocks for song: %s\n", blocks, dh);
+          song->sequencer_underrun_detected_SL = TRUE;
+          g_free (dh);
+          underrun_blocks = blocks;
+        }
+    }
+  return underrun_blocks;
+}
+
 bool
 Sequencer::process_song_unlooped_SL (BseSong *song, uint n_ticks, bool force_active_tracks)
 {
@@ -492,60 +666,50 @@ Sequencer::process_part_SL (BseSong *song, BsePart *part, double start_stamp, ui
                             uint tick_bound, /* start_tick + n_ticks */
                             double stamps_per_tick, BseMidiReceiver *midi_receiver, uint midi_channel)
 {
-  BsePartTickNode *node, *last;
-  uint channel;
-  for (channel = 0; channel < part->n_channels; channel++)
+  const std::vector<BsePartTimelineEvent> &events = part->timeline_SL->events;
+  size_t i;
+  for (i = bse_part_timeline_seek_SL (part, start_tick); i < events.size() && events[i].tick < tick_bound; i++)
     {
-      BsePartEventNote *note = bse_part_note_channel_lookup_ge (&part->channels[channel], start_tick);
-      BsePartEventNote *bound = note ? bse_part_note_channel_get_bound (&part->channels[channel]) : NULL;
-      while (note < bound && note->tick < tick_bound)
+      const BsePartTimelineEvent &tevent = events[i];
+      const uint64 stamp = bse_dtoull (start_stamp + (tevent.tick - start_tick) * stamps_per_tick);
+      if (!tevent.ctype)
         {
           BseMidiEvent *eon, *eoff;
-          gfloat freq = BSE_PART_NOTE_FREQ (part, note);
-          eon  = bse_midi_event_note_on (midi_channel,
-                                         bse_dtoull (start_stamp + (note->tick - start_tick) * stamps_per_tick),
-                                         freq, note->velocity);
+          eon  = bse_midi_event_note_on (midi_channel, stamp, tevent.freq, tevent.value);
           eoff = bse_midi_event_note_off (midi_channel,
-                                          bse_dtoull (start_stamp + (note->tick - start_tick + note->duration) * stamps_per_tick),
-                                          freq);
+                                          bse_dtoull (start_stamp + (tevent.tick - start_tick + tevent.duration) * stamps_per_tick),
+                                          tevent.freq);
           bse_midi_receiver_push_event (midi_receiver, eon);
           bse_midi_receiver_push_event (midi_receiver, eoff);
           SDUMP ("note-on:  tick=%llu midinote=%-3d velocity=%02x freq=% 10f late=%u",
-                 uint64 (eon->delta_time) - song->sequencer_start_SL,  note->note, bse_ftoi (note->velocity * 128), freq,
+                 uint64 (eon->delta_time) - song->sequencer_start_SL, tevent.note, bse_ftoi (tevent.value * 128), tevent.freq,
                  Bse::TickStamp::current() >= eon->delta_time);
           SDUMP ("note-off: tick=%llu midinote=%-3d velocity=%02x freq=% 10f late=%u",
-                 uint64 (eoff->delta_time) - song->sequencer_start_SL, note->note, bse_ftoi (note->velocity * 128), freq,
+                 uint64 (eoff->delta_time) - song->sequencer_start_SL, tevent.note, bse_ftoi (tevent.value * 128), tevent.freq,
                  Bse::TickStamp::current() >= eoff->delta_time);
-          note++;
         }
-    }
-
-  node = bse_part_controls_lookup_ge (&part->controls, start_tick);
-  last = bse_part_controls_lookup_lt (&part->controls, tick_bound);
-  if (node) while (node <= last)
-    {
-      BsePartEventControl *cev;
-      for (cev = node->events; cev; cev = cev->next)
+      else
         {
-          BseMidiEvent *event = bse_midi_event_signal (midi_channel,
-                                                       bse_dtoull (start_stamp + (node->tick - start_tick) * stamps_per_tick),
-                                                       Bse::MidiSignal (cev->ctype), cev->value);
+          BseMidiEvent *event = bse_midi_event_signal (midi_channel, stamp, Bse::MidiSignal (tevent.ctype), tevent.value);
           bse_midi_receiver_push_event (midi_receiver, event);
           SDUMP ("control:  tick=%llu midisignal=%-3d value=%f late=%u",
-                 uint64 (event->delta_time) - song->sequencer_start_SL, cev->ctype, cev->value,
+                 uint64 (event->delta_time) - song->sequencer_start_SL, tevent.ctype, tevent.value,
                  Bse::TickStamp::current() >= event->delta_time);
         }
-      node++;
     }
+  part->timeline_SL->cursor = i;
 }
 
 Sequencer::Sequencer() :
-  stamp_ (0), songs_ (NULL)
+  stamp_ (0), songs_ (NULL), lookahead_blocks_ (BSE_SEQUENCER_FUTURE_BLOCKS)
 {
   stamp_ = Bse::TickStamp::current();
   assert_return (stamp_ > 0);
 
   poll_pool_ = new PollPool;
+  song_workers_ = new SongWorkers ([this] (BseSong *song, uint64 cur_stamp, uint64 next_stamp) {
+    return sequence_song_SL (song, cur_stamp, next_stamp);
+  });
 
   if (event_fd_.open() != 0)
     Bse::warning ("failed to create sequencer wake-up pipe: %s", strerror (errno));
@@ -558,6 +722,8 @@ Sequencer::reap_thread ()
   sequencer_thread_running = false;
   singleton_->wakeup();
   singleton_->thread_.join();
+  delete singleton_->song_workers_;
+  singleton_->song_workers_ = NULL;
 }
 
 void
@@ -573,3 +739,72 @@ Sequencer::_init_threaded ()
 }
 
 } // Bse
+
+// == Testing ==
+#include "testing.hh"
+
+namespace { // Anon
+using namespace Bse;
+
+BSE_INTEGRITY_TEST (bse_sequencer_song_workers);
+static void
+bse_sequencer_song_workers ()
+{
+  BseSong *songs[2] = { (BseSong*) bse_object_new (BSE_TYPE_SONG, NULL), (BseSong*) bse_object_new (BSE_TYPE_SONG, NULL) };
+  SfiRing *ring = NULL;
+  for (BseSong *song : songs)
+    {
+      *song->tick_SL = 0;
+      ring = sfi_ring_append (ring, song);
+    }
+  std::atomic<uint> arrivals { 0 }, in_flight { 0 }, max_in_flight { 0 };
+  std::mutex mutex;
+  std::map<BseSong*,std::set<std::thread::id>> threads;
+  const bool concurrent = this_thread_online_cpus() > 1;
+  // advances the song tick per stamp, like the sequencer, and reports the song index as underrun
+  auto song_job = [&] (BseSong *song, uint64 cur_stamp, uint64 next_stamp) -> uint {
+    const uint n = ++in_flight;
+    uint m = max_in_flight;
+    while (n > m && !max_in_flight.compare_exchange_weak (m, n))
+      ;
+    for (uint64 stamp = cur_stamp; stamp < next_stamp; stamp++)
+      *song->tick_SL += 1;
+    if (concurrent)                     // barrier, a batch can only complete with both songs in flight
+      {
+        const uint batch_end = (++arrivals + 1) / 2 * 2;
+        while (arrivals < batch_end)
+          std::this_thread::yield();
+      }
+    {
+      std::lock_guard<std::mutex> locker (mutex);
+      threads[song].insert (std::this_thread::get_id());
+    }
+    in_flight--;
+    return song == songs[1] ? 7 : 3;
+  };
+  SongBatchWorkers workers (song_job);
+  uint64 stamp = 0;
+  for (uint i = 0; i < 20; i++)
+    {
+      Sequencer::sequencer_mutex().lock_shared();
+      TCMP (workers.sequence (ring, stamp, stamp + 128), ==, 7);   // maximum underrun of both songs
+      Sequencer::sequencer_mutex().unlock_shared();
+      stamp += 128;
+      for (BseSong *song : songs)                                       // each song exactly once per batch
+        TCMP (*song->tick_SL, ==, stamp);
+    }
+  if (concurrent)
+    {
+      TCMP (max_in_flight.load(), ==, 2);                               // songs were sequenced concurrently
+      std::set<std::thread::id> all;
+      for (auto &it : threads)
+        all.insert (it.second.begin(), it.second.end());
+      TCMP (all.size(), >=, 2);
+    }
+  TCMP (workers.sequence (NULL, stamp, stamp + 128), ==, 0);
+  sfi_ring_free (ring);
+  for (BseSong *song : songs)
+    g_object_unref (song);
+}
+
+} // Anon
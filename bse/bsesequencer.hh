@@ -2,6 +2,7 @@
 #ifndef __BSE_SSEQUENCER_HH__
 #define __BSE_SSEQUENCER_HH__
 #include <bse/bsesong.hh>
+#include <shared_mutex>
 
 namespace Bse {
 
@@ -9,19 +10,38 @@ namespace Bse {
  * The sequencer processes notes from parts and MIDI input and generates events for the synthesis engine.
  */
 class Sequencer {
+public:
+  static constexpr uint LATENESS_BUCKETS = 8;
+  /// Lookahead and underrun telemetry.
+  struct Stats {
+    uint64 underruns = 0;               ///< Song underruns since startup.
+    uint   lookahead_blocks = 0;        ///< Engine blocks the sequencer currently runs ahead.
+    double process_usecs = 0;           ///< Decaying peak of the time spent per sequencer iteration.
+    std::array<uint64,LATENESS_BUCKETS> lateness = {}; ///< Underruns by lateness, bucket n covers 2^n to 2^(n+1)-1 blocks.
+  };
+private:
+  class  SongWorkers;
   static Sequencer *singleton_;
-  static std::mutex sequencer_mutex_;
+  static std::shared_mutex sequencer_mutex_;    // exclusive for song, track and part changes, shared while sequencing
   class  PollPool;
   uint64     stamp_;            // sequencer time (ahead of real time)
   SfiRing   *songs_;
+  std::mutex watch_mutex_;      // guards poll_pool_ and io watch dispatching
   std::condition_variable watch_cond_;
   PollPool  *poll_pool_;
+  SongWorkers *song_workers_;
   EventFd    event_fd_;
   std::thread thread_;
+  uint       lookahead_blocks_;  // adapted to processing time and underruns
+  double     process_peak_us_ = 0;
+  uint       relaxed_iterations_ = 0;
+  uint64     underruns_ = 0;
+  uint64     lateness_[LATENESS_BUCKETS] = {};
 private:
   static void   reap_thread      ();
   void          sequencer_thread ();
-  bool          pool_poll_Lm     (int timeout_ms);
+  bool          pool_poll        (int timeout_ms);
+  void          adapt_lookahead_SL (uint64 process_us, uint underrun_blocks);
   void          process_part_SL  (BseSong *song, BsePart *part, double start_stamp, uint start_tick,
                                   uint tick_bound, /* start_tick + n_ticks */
                                   double stamps_per_tick, BseMidiReceiver *midi_receiver, uint midi_channel);
@@ -29,6 +49,7 @@ private:
                                   uint bound, /* start_tick + n_ticks */
                                   double stamps_per_tick, BseMidiReceiver *midi_receiver);
   void          process_song_SL  (BseSong *song, uint n_ticks);
+  uint          sequence_song_SL (BseSong *song, uint64 cur_stamp, uint64 next_stamp);
   bool          process_song_unlooped_SL (BseSong *song, uint n_ticks, bool force_active_tracks);
   explicit      Sequencer       ();
 protected:
@@ -39,8 +60,9 @@ public:
   void          start_song	(BseSong *song, uint64 start_stamp);
   void          remove_song	(BseSong *song);
   bool          thread_lagging  (uint n_blocks);
+  Stats         stats           ();
   void          wakeup          ()      { event_fd_.wakeup(); }
-  static std::mutex& sequencer_mutex () { return sequencer_mutex_; }
+  static std::shared_mutex& sequencer_mutex () { return sequencer_mutex_; }
   static Sequencer&  instance        () { return *singleton_; }
 };
 
@@ -5,12 +5,14 @@
 #include "gslcommon.hh"
 #include "bsemain.hh"		/* threads enter/leave */
 #include "bsepcmwriter.hh"
+#include "bsesequencer.hh"
 #include "bsecxxplugin.hh"
 #include "gsldatahandle-mad.hh"
 #include "gslvorbis-enc.hh"
 #include "bseladspa.hh"
 #include "devicecrawler.hh"
 #include "storage.hh"
+#include "enginecapture.hh"
 #include "path.hh"
 #include "internal.hh"
 #include <sys/stat.h>
@@ -107,6 +109,7 @@ bse_server_init (BseServer *self)
   self->set_flag (BSE_ITEM_FLAG_SINGLETON);
 
   self->dev_use_count = 0;
+  self->wave_bits = 16;
   self->pcm_writer = NULL;
 
   /* keep the server singleton alive */
@@ -297,20 +300,24 @@ bse_server_open_devices (BseServer *self)
     error = impl->open_pcm_driver (mix_freq, latency, &block_size);
   if (error == 0)
     bse_engine_update_block_size (block_size);
+  bse_engine_set_dsp_budget (Bse::global_prefs->dsp_budget * 0.01);
+  bse_engine_set_dsp_shedding (Bse::global_prefs->dsp_shed_load * 0.01, Bse::global_prefs->dsp_reduce_load * 0.01);
   if (error == 0)
     error = impl->open_midi_driver();
   if (error == 0)
     {
+      impl->global_engine().start_workers(); // the render thread must not create threads
       Bse::global_prefs->lock();
       BseTrans *trans = bse_trans_open ();
       bse_trans_add (trans, bse_pcm_imodule_change_driver (self->pcm_imodule, impl->pcm_driver().get()));
+      Bse::PcmWriterImpl::trigger_tick (~Bse::uint64 (0)); // all recordings start with the next playback
       if (self->wave_file)
 	{
 	  Bse::Error error;
 	  self->pcm_writer = (BsePcmWriter*) bse_object_new (BSE_TYPE_PCM_WRITER, NULL);
           const uint n_channels = 2;
 	  error = bse_pcm_writer_open (self->pcm_writer, self->wave_file,
-                                       n_channels, bse_engine_sample_freq (),
+                                       n_channels, self->wave_bits, bse_engine_sample_freq (),
                                        n_channels * bse_engine_sample_freq() * self->wave_seconds);
 	  if (error != 0)
 	    {
@@ -327,6 +334,7 @@ bse_server_open_devices (BseServer *self)
 	      self->pcm_writer = NULL;
 	    }
 	}
+      impl->open_stems (trans);
       bse_trans_add (trans, bse_pcm_omodule_change_driver (self->pcm_omodule, impl->pcm_driver().get(), self->pcm_writer));
       bse_trans_commit (trans);
       self->dev_use_count++;
@@ -379,6 +387,7 @@ bse_server_close_devices (BseServer *self)
       BseTrans *trans = bse_trans_open ();
       bse_trans_add (trans, bse_pcm_imodule_change_driver (self->pcm_imodule, nullptr));
       bse_trans_add (trans, bse_pcm_omodule_change_driver (self->pcm_omodule, nullptr, nullptr));
+      impl->detach_stems (trans);
       bse_trans_commit (trans);
       /* wait until transaction has been processed */
       bse_engine_wait_on_trans ();
@@ -389,6 +398,7 @@ bse_server_close_devices (BseServer *self)
 	  g_object_unref (self->pcm_writer);
 	  self->pcm_writer = NULL;
 	}
+      impl->close_stems();
       impl->close_pcm_driver();
       impl->close_midi_driver();
       Bse::global_prefs->unlock();
@@ -671,6 +681,12 @@ ServerImpl::engine_ipc_pending ()
   return engine_->ipc_pending();
 }
 
+int
+ServerImpl::engine_ipc_timeout ()
+{
+  return engine_->ipc_timeout();
+}
+
 void
 ServerImpl::engine_ipc_dispatch ()
 {
@@ -705,6 +721,25 @@ ServerImpl::wave_file (const String& filename)
   bse_server_start_recording (self, filename.c_str(), 0);
 }
 
+int
+ServerImpl::wave_bits () const
+{
+  BseServer *self = const_cast<ServerImpl*> (this)->as<BseServer*>();
+  return self->wave_bits;
+}
+
+void
+ServerImpl::wave_bits (int bits)
+{
+  BseServer *self = as<BseServer*>();
+  const guint n_bits = bits >= 32 ? 32 : bits >= 24 ? 24 : 16;
+  if (self->wave_bits != n_bits)
+    {
+      self->wave_bits = n_bits;
+      notify ("wave_bits");
+    }
+}
+
 void
 ServerImpl::enginechange (bool active)
 {
@@ -713,14 +748,22 @@ ServerImpl::enginechange (bool active)
 }
 
 void
-ServerImpl::commit_job (const std::function<void()> &lambda)
+ServerImpl::commit_job (const std::function<void()> &lambda, uint64 tick_stamp)
 {
   BseServer *self = this->as<BseServer*>();
   assert_return (lambda != nullptr);
   assert_return (self->pcm_omodule);
+  AudioSignal::Engine *engine = engine_;
+  auto job = [engine, lambda] () {
+    engine->suspend_ahead(); // graph changes must not race with rendering ahead of time
+    lambda();
+  };
   BseTrans *trans = bse_trans_open ();
-  bse_trans_add (trans, bse_job_access (self->pcm_omodule, lambda));
-  bse_trans_commit (trans);
+  bse_trans_add (trans, bse_job_access (self->pcm_omodule, job));
+  if (tick_stamp)
+    bse_trans_commit_delayed (trans, tick_stamp);
+  else
+    bse_trans_commit (trans);
 }
 
 bool
@@ -730,6 +773,88 @@ ServerImpl::engine_active ()
   return self->dev_use_count;
 }
 
+SequencerStats
+ServerImpl::sequencer_stats ()
+{
+  const Sequencer::Stats stats = Sequencer::instance().stats();
+  SequencerStats sstats;
+  sstats.underruns = stats.underruns;
+  sstats.lookahead_blocks = stats.lookahead_blocks;
+  sstats.lookahead_frames = stats.lookahead_blocks * bse_engine_block_size();
+  sstats.process_usecs = stats.process_usecs;
+  for (auto count : stats.lateness)
+    sstats.lateness.push_back (count);
+  return sstats;
+}
+
+DspBudgetStats
+ServerImpl::dsp_budget_stats ()
+{
+  const BseEngineBudget budget = bse_engine_budget_stats();
+  DspBudgetStats bstats;
+  bstats.load = budget.load;
+  bstats.peak_load = budget.peak_load;
+  bstats.voice_fraction = budget.voice_fraction;
+  bstats.reductions = budget.reductions;
+  bstats.raises = budget.raises;
+  bstats.stolen_voices = budget.stolen_voices;
+  bstats.degradation = budget.degradation;
+  bstats.degraded_blocks = budget.degraded_blocks;
+  return bstats;
+}
+
+NotifyStats
+ServerImpl::notify_stats ()
+{
+  const AudioSignal::Processor::NotifyStats stats = AudioSignal::Processor::notify_stats();
+  NotifyStats nstats;
+  nstats.delivered = stats.delivered;
+  nstats.coalesced = stats.coalesced;
+  nstats.dropped = stats.dropped;
+  return nstats;
+}
+
+int
+ServerImpl::notify_interval ()
+{
+  return AudioSignal::Processor::notify_interval_ms();
+}
+
+void
+ServerImpl::set_notify_interval (int milliseconds)
+{
+  AudioSignal::Processor::notify_interval_ms (std::max (0, milliseconds));
+}
+
+PcmStats
+ServerImpl::pcm_stats ()
+{
+  PcmStats pstats;
+  PcmDriverP driver = pcm_driver_;
+  return_unless (driver, pstats);
+  const PcmDriverStats stats = driver->pcm_stats();
+  pstats.xruns = stats.xruns;
+  pstats.adjustments = stats.adjustments;
+  pstats.n_periods = stats.n_periods;
+  pstats.period_size = stats.period_size;
+  for (auto count : stats.jitter)
+    pstats.jitter.push_back (count);
+  for (auto count : stats.lateness)
+    pstats.lateness.push_back (count);
+  pstats.roundtrip_frames = stats.roundtrip_frames;
+  pstats.latency_frames = stats.latency_frames;
+  pstats.buffered_latency_frames = stats.buffered_latency_frames;
+  return pstats;
+}
+
+bool
+ServerImpl::probe_pcm_roundtrip ()
+{
+  PcmDriverP driver = pcm_driver_;
+  return_unless (driver && driver->readable() && driver->writable(), false);
+  return driver->pcm_probe_roundtrip();
+}
+
 LegacyObjectIfaceP
 ServerImpl::from_proxy (int64_t proxyid)
 {
@@ -887,6 +1012,148 @@ ServerImpl::start_recording (const String &wave_file, double n_seconds)
   bse_server_start_recording (server, wave_file.c_str(), n_seconds);
 }
 
+bool
+ServerImpl::start_engine_capture (const String &capture_file)
+{
+  return EngineCapture::start (capture_file);
+}
+
+void
+ServerImpl::stop_engine_capture ()
+{
+  EngineCapture::stop();
+}
+
+bool
+ServerImpl::add_stem_source (SourceIface &source, const String &wave_file)
+{
+  BseServer *self = as<BseServer*>();
+  SourceImpl *simpl = dynamic_cast<SourceImpl*> (&source);
+  assert_return (simpl != nullptr, false);
+  return_unless (!self->dev_use_count && !wave_file.empty(), false);
+  return_unless (simpl->n_ochannels() > 0, false);
+  Stem stem;
+  stem.wave_file = wave_file;
+  stem.source = simpl->as<SourceImplP>();
+  stems_.push_back (stem);
+  return true;
+}
+
+bool
+ServerImpl::add_stem_processor (ProcessorIface &processor, const String &wave_file)
+{
+  BseServer *self = as<BseServer*>();
+  ProcessorImpl *pimpl = dynamic_cast<ProcessorImpl*> (&processor);
+  assert_return (pimpl != nullptr, false);
+  return_unless (!self->dev_use_count && !wave_file.empty(), false);
+  Stem stem;
+  stem.wave_file = wave_file;
+  stem.proc = pimpl->audio_signal_processor();
+  return_unless (stem.proc && stem.proc->n_obuses() > 0, false);
+  stems_.push_back (stem);
+  return true;
+}
+
+void
+ServerImpl::clear_stems ()
+{
+  BseServer *self = as<BseServer*>();
+  return_unless (!self->dev_use_count);
+  stems_.clear();
+}
+
+/// Open writers for all stems, Processor stems are recorded from the PCM output module.
+void
+ServerImpl::open_stems (BseTrans *trans)
+{
+  BseServer *self = as<BseServer*>();
+  std::vector<BsePCMModuleData::Stem> pcm_stems;
+  for (Stem &stem : stems_)
+    {
+      assert_return (stem.writer == nullptr);
+      uint n_channels;
+      if (stem.proc)
+        n_channels = stem.proc->n_ochannels (MAIN_OBUS);
+      else
+        n_channels = stem.source->n_ochannels();
+      n_channels = CLAMP (n_channels, 1, 8);
+      BsePcmWriter *writer = (BsePcmWriter*) bse_object_new (BSE_TYPE_PCM_WRITER, NULL);
+      const Error error = bse_pcm_writer_open (writer, stem.wave_file.c_str(), n_channels, self->wave_bits,
+                                               bse_engine_sample_freq(), n_channels * bse_engine_sample_freq() * self->wave_seconds);
+      if (error != 0)
+        {
+          Bse::info ("Failed to open file \"%s\" for stem recording: %s", stem.wave_file, bse_error_blurb (error));
+          g_object_unref (writer);
+          continue;
+        }
+      stem.writer = writer;
+      if (stem.proc)
+        pcm_stems.push_back (bse_pcm_module_new_stem (stem.proc, stem.writer));
+    }
+  if (pcm_stems.size())
+    bse_pcm_module_set_stems (self->pcm_omodule, std::move (pcm_stems), trans);
+}
+
+/// Stop feeding stem writers, the writers may be closed once `trans` has been processed.
+void
+ServerImpl::detach_stems (BseTrans *trans)
+{
+  BseServer *self = as<BseServer*>();
+  bse_pcm_module_set_stems (self->pcm_omodule, {}, trans);
+  for (Stem &stem : stems_)
+    if (stem.tap)
+      {
+        bse_trans_add (trans, bse_job_discard (stem.tap));
+        stem.tap = nullptr;
+      }
+}
+
+void
+ServerImpl::close_stems ()
+{
+  for (Stem &stem : stems_)
+    if (stem.writer)
+      {
+        bse_pcm_writer_close (stem.writer);
+        g_object_unref (stem.writer);
+        stem.writer = nullptr;
+      }
+}
+
+/// Connect Source stems of `project` to their writers, called when playback starts.
+void
+ServerImpl::connect_stem_taps (BseProject *project, BseTrans *trans)
+{
+  for (Stem &stem : stems_)
+    {
+      BseSource *source = stem.source ? stem.source->as<BseSource*>() : nullptr;
+      if (!source || !stem.writer || stem.tap || !BSE_SOURCE_PREPARED (source) ||
+          bse_item_get_project (BSE_ITEM (source)) != project)
+        continue;
+      std::vector<BseModule*> omodules;
+      bse_source_list_omodules (source, omodules);
+      stem.tap = bse_pcm_writer_tap_new (stem.writer);
+      bse_trans_add (trans, bse_job_integrate (stem.tap));
+      bse_trans_add (trans, bse_job_set_consumer (stem.tap, TRUE));
+      const uint n_channels = MIN (stem.writer->n_channels, uint (BSE_SOURCE_N_OCHANNELS (source)));
+      for (auto omodule : omodules)
+        for (uint i = 0; i < n_channels; i++)
+          bse_trans_add (trans, bse_job_jconnect (omodule, i, stem.tap, i));
+    }
+}
+
+/// Discard the stem taps of `project`, called when playback stops.
+void
+ServerImpl::disconnect_stem_taps (BseProject *project, BseTrans *trans)
+{
+  for (Stem &stem : stems_)
+    if (stem.tap && bse_item_get_project (BSE_ITEM (stem.source->as<BseSource*>())) == project)
+      {
+        bse_trans_add (trans, bse_job_discard (stem.tap));
+        stem.tap = nullptr;
+      }
+}
+
 bool
 ServerImpl::can_load (const String &file_name)
 {
@@ -1350,6 +1617,13 @@ ServerImpl::open_midi_driver()
   return midi_driver_ ? Error::NONE : error;
 }
 
+/// Open `devid` instead of Preferences.pcm_driver, e.g. for offline rendering, an empty string restores the preferences.
+void
+ServerImpl::override_pcm_driver (const String &devid)
+{
+  pcm_driver_override_ = devid;
+}
+
 void
 ServerImpl::close_pcm_driver()
 {
@@ -1369,8 +1643,11 @@ ServerImpl::open_pcm_driver (uint mix_freq, uint latency, uint *block_size)
   config.n_channels = 2;
   config.mix_freq = mix_freq;
   config.latency_ms = latency;
+  config.max_latency_ms = get_prefs().synth_latency_max;
   config.block_length = *block_size;
-  pcm_driver_ = PcmDriver::open (get_prefs().pcm_driver, Driver::READWRITE, Driver::WRITEONLY, config, &error);
+  config.monitor_level = get_prefs().input_monitor * 0.01;
+  const String pcm_driver = pcm_driver_override_.empty() ? get_prefs().pcm_driver : pcm_driver_override_;
+  pcm_driver_ = PcmDriver::open (pcm_driver, Driver::READWRITE, Driver::WRITEONLY, config, &error);
   if (pcm_driver_)
     *block_size = pcm_driver_->block_length();
   else // !pcm_driver_
@@ -1460,7 +1737,10 @@ ServerImpl::add_event_input (AudioSignal::Processor &proc)
 {
   if (!midi_proc_)
     midi_proc_ = create_server_midi_input();
-  proc.connect_event_input (*midi_proc_);
+  AudioSignal::ProcessorP procp = proc.shared_from_this(), midi_proc = midi_proc_;
+  commit_job ([procp, midi_proc] () {
+    procp->connect_event_input (*midi_proc);
+  });
 }
 
 void
@@ -1496,6 +1776,7 @@ class ServerMidiInput : public AudioSignal::Processor {
   initialize () override
   {
     prepare_event_output();
+    flags_ |= LIVE_INPUT;
   }
   void configure (uint n_ibusses, const SpeakerArrangement *ibusses, uint n_obusses, const SpeakerArrangement *obusses) override {}
   void reset () override {}
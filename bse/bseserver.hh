@@ -16,6 +16,7 @@ struct BseServer : BseContainer {
   GSList	  *children;
   gchar		  *wave_file;
   double           wave_seconds;
+  guint            wave_bits;
   guint		   dev_use_count;
   BseModule       *pcm_imodule;
   BseModule       *pcm_omodule;
@@ -59,11 +60,21 @@ class ServerImpl : public virtual ServerIface, public virtual ContainerImpl {
   MidiDriverP        midi_driver_;
   AudioSignal::Engine     *engine_ = nullptr;
   AudioSignal::ProcessorP  midi_proc_;
+  String                   pcm_driver_override_;
+  struct Stem {
+    String                  wave_file;
+    SourceImplP             source;     // records all output channels of a Source, or
+    AudioSignal::ProcessorP proc;       // the main output bus of a Processor
+    BsePcmWriter           *writer = nullptr;
+    BseModule              *tap = nullptr;
+  };
+  std::vector<Stem>        stems_;
 protected:
   virtual             ~ServerImpl            ();
 public:
   AudioSignal::Engine& global_engine         ();
   bool                 engine_ipc_pending    ();
+  int                  engine_ipc_timeout    ();
   void                 engine_ipc_dispatch   ();
   void                 enginechange          (bool active);
   void                 shutdown_             ();
@@ -72,7 +83,8 @@ public:
   size_t               shared_block_offset   (const void *mem) const;
   void                 set_ipc_handler       (IpcHandler *ipch);
   IpcHandler*          get_ipc_handler       ();
-  void                commit_job            (const std::function<void()> &lambda);
+  void                commit_job            (const std::function<void()> &lambda, uint64 tick_stamp = 0);
+  void                override_pcm_driver   (const String &devid);
   Error               open_midi_driver      ();
   void                close_midi_driver     ();
   PcmDriverP          pcm_driver            () const { return pcm_driver_; }
@@ -82,12 +94,26 @@ public:
   void                add_pcm_output_processor (AudioSignal::ProcessorP procp);
   void                del_pcm_output_processor (AudioSignal::ProcessorP procp);
   void                add_event_input       (AudioSignal::Processor &proc);
+  void                open_stems            (BseTrans *trans);
+  void                detach_stems          (BseTrans *trans);
+  void                close_stems           ();
+  void                connect_stem_taps     (BseProject *project, BseTrans *trans);
+  void                disconnect_stem_taps  (BseProject *project, BseTrans *trans);
   explicit                 ServerImpl       (BseObject*);
   virtual bool             log_messages     () const override;
   virtual void             log_messages     (bool val) override;
   virtual String           wave_file        () const override;
   virtual void             wave_file        (const String& val) override;
+  virtual int              wave_bits        () const override;
+  virtual void             wave_bits        (int bits) override;
   virtual bool             engine_active    () override;
+  virtual SequencerStats   sequencer_stats  () override;
+  virtual DspBudgetStats   dsp_budget_stats () override;
+  virtual PcmStats         pcm_stats        () override;
+  virtual NotifyStats      notify_stats     () override;
+  virtual int              notify_interval  () override;
+  virtual void             set_notify_interval (int milliseconds) override;
+  virtual bool             probe_pcm_roundtrip () override;
   virtual LegacyObjectIfaceP    from_proxy       (int64_t proxyid) override;
   virtual SharedMemory  get_shared_memory   () override;
   virtual void    broadcast_shm_fragments   (const ShmFragmentSeq &plan, int interval_ms) override;
@@ -104,6 +130,11 @@ public:
   virtual String        get_custom_instrument_dir () override;
   virtual void   purge_stale_cachedirs   () override;
   virtual void   start_recording         (const String &wave_file, double n_seconds) override;
+  virtual bool   start_engine_capture    (const String &capture_file) override;
+  virtual void   stop_engine_capture     () override;
+  virtual bool   add_stem_source         (SourceIface &source, const String &wave_file) override;
+  virtual bool   add_stem_processor      (ProcessorIface &processor, const String &wave_file) override;
+  virtual void   clear_stems             () override;
   virtual void   load_assets             () override;
   virtual void   load_ladspa             () override;
   virtual bool   can_load                (const String &file_name) override;
@@ -453,6 +453,42 @@ standard_osc_process (BseModule *module,
     gsl_osc_process (osc, n_values, freq_in, mod_in, sync_in, osc_out, sync_out);
 }
 
+static void
+standard_osc_process_lanes (BseModule **modules,
+                            guint       n_modules,
+                            guint       n_values)
+{
+  GslOscData *oscs[BSE_ENGINE_MAX_LANES];
+  const gfloat *freq_in[BSE_ENGINE_MAX_LANES];
+  gfloat *osc_out[BSE_ENGINE_MAX_LANES];
+  guint l, n_lanes = 0;
+
+  assert_return (n_modules <= BSE_ENGINE_MAX_LANES);
+  for (l = 0; l < n_modules; l++)
+    {
+      BseModule *module = modules[l];
+      GslOscData *osc = (GslOscData*) module->user_data;
+      /* modulated, synced and pulse oscillators take the single voice path */
+      if (BSE_MODULE_OSTREAM (module, BSE_STANDARD_OSC_OCHANNEL_SYNC).connected ||
+          BSE_MODULE_ISTREAM (module, BSE_STANDARD_OSC_ICHANNEL_FREQ_MOD).connected ||
+          BSE_MODULE_ISTREAM (module, BSE_STANDARD_OSC_ICHANNEL_SYNC).connected ||
+          osc->config.table->wave_form == GSL_OSC_WAVE_PULSE_SAW)
+        {
+          standard_osc_process (module, n_values);
+          continue;
+        }
+      if (!BSE_MODULE_OSTREAM (module, BSE_STANDARD_OSC_OCHANNEL_OSC).connected)
+        continue;	/* nothing to process */
+      oscs[n_lanes] = osc;
+      freq_in[n_lanes] = BSE_MODULE_ISTREAM (module, BSE_STANDARD_OSC_ICHANNEL_FREQ).connected ?
+                         BSE_MODULE_IBUFFER (module, BSE_STANDARD_OSC_ICHANNEL_FREQ) : NULL;
+      osc_out[n_lanes] = BSE_MODULE_OBUFFER (module, BSE_STANDARD_OSC_OCHANNEL_OSC);
+      n_lanes++;
+    }
+  if (n_lanes)
+    gsl_osc_process_lanes (n_lanes, oscs, n_values, freq_in, osc_out);
+}
+
 static void
 bse_standard_osc_context_create (BseSource *source,
 				 guint      context_handle,
@@ -467,6 +503,7 @@ bse_standard_osc_context_create (BseSource *source,
     standard_osc_reset,           /* reset */
     (BseModuleFreeFunc) g_free,	  /* free */
     Bse::ModuleFlag::NORMAL,		  /* cost */
+    standard_osc_process_lanes,   /* process_lanes */
   };
   BseStandardOsc *self = BSE_STANDARD_OSC (source);
   GslOscData *osc = g_new0 (GslOscData, 1);
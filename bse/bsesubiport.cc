@@ -146,38 +146,14 @@ bse_sub_iport_set_parent (BseItem *item,
       }
 }
 
-static void
-sub_iport_process (BseModule *module,
-                   guint      n_values)
-{
-  guint i, n = BSE_MODULE_N_OSTREAMS (module);
-
-  for (i = 0; i < n; i++)
-    BSE_MODULE_OBUFFER (module, i) = (gfloat*) BSE_MODULE_IBUFFER (module, i);
-}
-
 static void
 bse_sub_iport_context_create (BseSource *source,
                               guint      context_handle,
                               BseTrans  *trans)
 {
   BseSubIPort *self = BSE_SUB_IPORT (source);
-
-  if (!BSE_SOURCE_GET_CLASS (self)->engine_class)
-    {
-      BseModuleClass module_class = {
-        BSE_SOURCE_N_OCHANNELS (self),  // n_istreams
-        0,                              // n_jstreams
-        BSE_SOURCE_N_OCHANNELS (self),  // n_ostreams
-        sub_iport_process,              // process
-        NULL,                           // process_defer
-        NULL,                           // reset
-        NULL,                           // free
-        Bse::ModuleFlag::CHEAP,                 // mflags
-      };
-      bse_source_class_cache_engine_class (BSE_SOURCE_GET_CLASS (self), &module_class);
-    }
-  BseModule *module = bse_module_new (BSE_SOURCE_GET_CLASS (self)->engine_class, NULL);
+  /* no processing needed, the scheduler connects our consumers to the real signal sources */
+  BseModule *module = bse_module_new_port (BSE_SOURCE_N_OCHANNELS (self));
 
   /* commit module to engine */
   bse_trans_add (trans, bse_job_integrate (module));
@@ -21,6 +21,8 @@
 #include "bseserver.hh"
 #include "bsecxxplugin.hh"
 #include "combo.hh"
+#include "freeze.hh"
+#include "enginecapture.hh"
 #include "bse/internal.hh"
 #include <string.h>
 
@@ -1239,6 +1241,32 @@ TrackImpl::muted (bool muted)
     }
 }
 
+bool
+TrackImpl::live_input() const
+{
+  return live_input_;
+}
+
+void
+TrackImpl::live_input (bool live)
+{
+  bool value = live_input_;
+  if (APPLY_IDL_PROPERTY (value, live))
+    {
+      live_input_ = value;
+      return_unless (combo_chain_);
+      AudioSignal::ChainP chain = combo_chain_;
+      MidiLib::MidiInputIfaceP midiin = midi_in_;
+      if (value)
+        BSE_SERVER.add_event_input (*midiin);
+      BSE_SERVER.commit_job ([chain, midiin, value] () {
+        if (!value)
+          midiin->disconnect_event_input();
+        chain->anticipate (!value); // rendered ahead unless live events may arrive
+      });
+    }
+}
+
 int
 TrackImpl::midi_channel() const
 {
@@ -1477,10 +1505,52 @@ TrackImpl::update_clip()
   struct PtrCopy { mutable MidiLib::ClipEventVectorP cevp; };
   PtrCopy pc { cevp }; // use ClipEventVectorP copy to defer dtor to user thread
   auto lambda = [midiin, BPM, nbpm, pc] () {
+    EngineCapture::PlaybackScope playback;      // song tempo, recreated by loading the project
     midiin->set_normalized (BPM, nbpm);
     midiin->swap_event_vector (pc.cevp);
   };
   BSE_SERVER.commit_job (lambda);
+  if (freezer_ && freezer_->enabled())
+    freezer_->freeze (cevp, bpm); // re-render with new clip contents, unless cached
+}
+
+/// Render the combo output in the background and bypass its processors once the rendering is ready.
+bool
+TrackImpl::freeze ()
+{
+  access_combo(); // ensures combo_chain_
+  return_unless (combo_chain_ && midi_in_, false);
+  SongImpl *song = get_song().get();
+  const double bpm = song ? song->bpm() : 110;
+  ClipImpl::OrderedEventsP cevp = clips_.size() ? clips_[0]->tick_events() : nullptr;
+  if (!freezer_)
+    {
+      AudioSignal::ChainP chain = combo_chain_;
+      MidiLib::MidiInputIfaceP midiin = midi_in_;
+      auto installer = [chain, midiin] (AudioSignal::FreezeCacheP cache, AudioSignal::FreezeCacheP previous) {
+        struct PtrCopy { mutable AudioSignal::FreezeCacheP cache; };
+        PtrCopy pc { previous }; // defer dtor of the previous cache to user thread
+        BSE_SERVER.commit_job ([chain, midiin, cache, pc] () {
+          chain->freeze (cache, cache ? midiin->playback_start() : 0);
+        });
+      };
+      freezer_ = AudioSignal::Freezer::create (combo_chain_, installer);
+    }
+  freezer_->freeze (cevp, bpm);
+  return true;
+}
+
+void
+TrackImpl::unfreeze ()
+{
+  return_unless (freezer_);
+  freezer_->unfreeze();
+}
+
+bool
+TrackImpl::is_frozen ()
+{
+  return freezer_ && freezer_->frozen();
 }
 
 ComboIfaceP
@@ -1498,7 +1568,13 @@ TrackImpl::access_combo ()
       combo_chain_ = std::dynamic_pointer_cast<AudioSignal::Chain> (AudioSignal::Processor::registry_create (BSE_SERVER.global_engine(), combo_chain_uri));
       assert_return (combo_chain_, nullptr);
       combo_chain_->set_event_source (midi_in_);
-      BSE_SERVER.add_event_input (*midi_in_);
+      if (live_input_)
+        BSE_SERVER.add_event_input (*midi_in_);
+      else
+        {
+          AudioSignal::ChainP chain = combo_chain_;
+          BSE_SERVER.commit_job ([chain] () { chain->anticipate (true); });
+        }
     }
   ProcessorImplP procimplp = combo_chain_->access_processor();
   assert_return (procimplp, nullptr);
@@ -93,6 +93,8 @@ using SongImplP = std::shared_ptr<SongImpl>;
 class TrackImpl : public ContextMergerImpl, public virtual TrackIface {
   AudioSignal::ChainP combo_chain_;
   MidiLib::MidiInputIfaceP midi_in_;
+  AudioSignal::FreezerP freezer_;
+  bool                 live_input_ = true;
   using ClipV = std::vector<ClipImplP>;
   ClipV                clips_;
 protected:
@@ -121,11 +123,16 @@ public:
   virtual void         outputs           (const ItemSeq &newoutputs) override;
   virtual bool         muted             () const override;
   virtual void         muted             (bool val) override;
+  virtual bool         live_input        () const override;
+  virtual void         live_input        (bool val) override;
   virtual int          midi_channel      () const override;
   virtual void         midi_channel      (int val) override;
   virtual int          n_voices          () const override;
   virtual void         n_voices          (int val) override;
   virtual ComboIfaceP  access_combo      () override;
+  virtual bool         freeze            () override;
+  virtual void         unfreeze          () override;
+  virtual bool         is_frozen         () override;
 };
 using TrackImplP = std::shared_ptr<TrackImpl>;
 
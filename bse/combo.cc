@@ -1,7 +1,12 @@
 // Licensed GNU LGPL v2.1 or later: http://www.gnu.org/licenses/lgpl.html
 #include "combo.hh"
+#include "freeze.hh"
 #include "bseserver.hh"
 #include "internal.hh"
+#include <condition_variable>
+#include <thread>
+#include <sys/resource.h>
+#include <sched.h>
 
 #define PDEBUG(...)     Bse::debug ("processor", __VA_ARGS__)
 
@@ -107,6 +112,25 @@ public:
   }
 };
 
+// == Chain::Ahead ==
+/// Ring buffer of Chain output blocks that were rendered ahead of time.
+struct Chain::Ahead {
+  static constexpr uint N_BLOCKS = 16;
+  std::vector<Processor*> schedule;     // detached from the Engine schedule
+  bool                    eligible = false;
+  uint                    n_channels = 0;
+  std::vector<float>      ring;         // N_BLOCKS * n_channels * MAX_RENDER_BLOCK_SIZE
+  std::atomic<uint64_t>   next_frame { 0 };     // frame counter of the next block to render
+  std::atomic<uint64_t>   last_frame { 0 };     // frame counter of the last block consumed
+  std::atomic<uint64>     n_underruns { 0 };    // blocks rendered at the deadline after the AheadJob fell behind
+  float*
+  block (uint64_t frame, uint channel)
+  {
+    const size_t nth = frame / MAX_RENDER_BLOCK_SIZE % N_BLOCKS;
+    return &ring[(nth * n_channels + channel) * MAX_RENDER_BLOCK_SIZE];
+  }
+};
+
 // == Chain ==
 Chain::Chain (SpeakerArrangement iobuses) :
   ispeakers_ (iobuses), ospeakers_ (iobuses)
@@ -121,6 +145,9 @@ Chain::Chain (SpeakerArrangement iobuses) :
 
 Chain::~Chain()
 {
+  if (ahead_)
+    engine_.del_ahead_job (this);
+  ahead_ = nullptr;
   pm_remove_all_buses (*inlet_);
   inlet_ = nullptr;
   eproc_ = nullptr;
@@ -161,26 +188,169 @@ void
 Chain::reset()
 {}
 
+/// Replace the output by the rendering in `cache`, `anchor` is the engine frame of its position 0.
+/// While frozen, the Chain processors are removed from the schedule, `cache == nullptr` thaws the Chain.
+/// Insertions and removals keep the Chain frozen, its owner (see Freezer) needs to thaw it.
+void
+Chain::freeze (FreezeCacheP cache, int64_t anchor)
+{
+  if (cache)
+    assert_return (cache->n_channels() > 0);
+  frozen_ = cache;
+  frozen_anchor_ = anchor;
+  engine_.reschedule();
+}
+
+/// Render the Chain processors ahead of time in a background thread, if they have no live input.
+/// This frees the low latency render cycle from their load, but delays parameter changes.
+void
+Chain::anticipate (bool enable)
+{
+  constexpr OBusId OUT1 = OBusId (1);
+  return_unless (enable != anticipated());
+  engine_.suspend_ahead();
+  if (ahead_)
+    {
+      engine_.del_ahead_job (this);
+      rewind_processors();
+    }
+  ahead_ = nullptr;
+  if (enable)
+    {
+      ahead_ = std::unique_ptr<Ahead> (new Ahead());
+      ahead_->n_channels = n_ochannels (OUT1);
+      ahead_->ring.resize (Ahead::N_BLOCKS * ahead_->n_channels * MAX_RENDER_BLOCK_SIZE);
+      engine_.add_ahead_job (render_ahead, this);
+    }
+  engine_.reschedule();
+}
+
+/// Number of blocks that were rendered at the deadline, because the anticipation fell behind.
+uint64
+Chain::underruns () const
+{
+  return ahead_ ? ahead_->n_underruns.load() : 0;
+}
+
 void
 Chain::enqueue_children ()
 {
   last_output_ = nullptr;
-  engine_.enqueue (*inlet_);
+  if (frozen_)
+    return;
   const ProcessorVec &cprocessors = processors_mt_;
+  if (ahead_)
+    {
+      Ahead &ahead = *ahead_;
+      const bool was_eligible = ahead.eligible;
+      ahead.schedule.clear();
+      engine_.enqueue_detached (*inlet_, ahead.schedule);
+      for (auto procp : cprocessors)
+        engine_.enqueue_detached (*procp, ahead.schedule);
+      ahead.eligible = engine_.independent (*this, ahead.schedule) && ahead.n_channels == n_ochannels (OBusId (1));
+      // keep playing the blocks rendered ahead, graph changes become audible after them
+      if (!was_eligible || !ahead.eligible)
+        {
+          // discard blocks rendered by the previous graph, processors continue at the Engine frame
+          for (Processor *proc : ahead.schedule)
+            pm_rewind_state (*proc);
+          ahead.next_frame = 0;
+        }
+    }
+  else
+    engine_.enqueue (*inlet_);
   for (auto procp : cprocessors)
     {
-      engine_.enqueue (*procp);
+      if (!ahead_)
+        engine_.enqueue (*procp);
       if (procp->n_obuses())
         last_output_ = procp.get();
     }
   // last_output_ is only valid during render()
 }
 
+// Render detached processors, called from within the AheadJob or while it is idle or suspended.
+void
+Chain::render_processors ()
+{
+  for (Processor *proc : ahead_->schedule)
+    pm_render_block (*proc);
+}
+
+// Let processors that rendered ahead of time continue at the Engine frame, needs a suspended AheadJob.
+void
+Chain::rewind_processors ()
+{
+  pm_rewind_state (*inlet_);
+  if (eproc_)
+    pm_rewind_state (*eproc_);
+  for (auto procp : processors_mt_)
+    pm_rewind_state (*procp);
+}
+
+// AheadJob, render one block into the ring buffer.
+// Blocks are rendered strictly in sequence, after an underrun render() takes over at the
+// deadline and the AheadJob continues after the block rendered there, so no block is skipped.
+bool
+Chain::render_ahead (void *data)
+{
+  constexpr OBusId OUT1 = OBusId (1);
+  Chain &self = *(Chain*) data;
+  Ahead &ahead = *self.ahead_;
+  const uint64_t last = ahead.last_frame;
+  const uint64_t frame = ahead.next_frame.load (std::memory_order_acquire);
+  return_unless (ahead.eligible && frame && frame < last + Ahead::N_BLOCKS * MAX_RENDER_BLOCK_SIZE, false);
+  {
+    Engine::AheadFrame ahead_frame (frame);
+    self.render_processors();
+  }
+  Processor *const lproc = self.last_output_;
+  const uint nlastchannels = lproc ? lproc->n_ochannels (OUT1) : 0;
+  for (uint c = 0; c < ahead.n_channels; c++)
+    if (nlastchannels)
+      floatcopy (ahead.block (frame, c), lproc->ofloats (OUT1, std::min (c, nlastchannels - 1)), MAX_RENDER_BLOCK_SIZE);
+    else
+      floatfill (ahead.block (frame, c), 0.0, MAX_RENDER_BLOCK_SIZE);
+  ahead.next_frame.store (frame + MAX_RENDER_BLOCK_SIZE, std::memory_order_release);
+  return true;
+}
+
 void
 Chain::render (uint n_frames)
 {
   // make the last processor output the chain output
   constexpr OBusId OUT1 = OBusId (1);
+  if (frozen_)
+    {
+      const int64_t pos = int64_t (engine_.frame_counter()) - frozen_anchor_;
+      for (size_t c = 0; c < n_ochannels (OUT1); c++)
+        frozen_->read (c, pos, oblock (OUT1, c), n_frames);
+      return;
+    }
+  if (ahead_)
+    {
+      Ahead &ahead = *ahead_;
+      const uint64_t frame = engine_.frame_counter();
+      ahead.last_frame = frame;
+      if (ahead.eligible && ahead.next_frame.load (std::memory_order_acquire) <= frame)
+        {
+          if (ahead.next_frame.load (std::memory_order_relaxed))
+            ahead.n_underruns++;
+          // the processors may be inside a block of the AheadJob, wait for it and keep
+          // anticipation paused for the rest of this render cycle
+          engine_.suspend_ahead();
+        }
+      if (ahead.eligible && ahead.next_frame.load (std::memory_order_acquire) > frame)
+        {
+          for (size_t c = 0; c < ahead.n_channels; c++)
+            redirect_oblock (OUT1, c, ahead.block (frame, c));
+          return;
+        }
+      // underrun, idle before the first block or not eligible, render at the deadline
+      render_processors();
+      if (ahead.eligible)
+        ahead.next_frame.store (frame + MAX_RENDER_BLOCK_SIZE, std::memory_order_release); // (re)start anticipation
+    }
   const size_t nlastchannels = last_output_ ? last_output_->n_ochannels (OUT1) : 0;
   const size_t n_och = n_ochannels (OUT1);
   for (size_t c = 0; c < n_och; c++)
@@ -228,6 +398,8 @@ Chain::remove (Processor &proc)
   std::vector<Processor*> unconnected;
   ProcessorP processorp;
   const ProcessorVec &cprocessors = processors_mt_;
+  if (ahead_)
+    engine_.suspend_ahead();    // the AheadJob renders processors_mt_ until the next make_schedule()
   size_t pos; // find proc
   for (pos = 0; pos < cprocessors.size(); pos++)
     if (cprocessors[pos].get() == &proc)
@@ -239,6 +411,8 @@ Chain::remove (Processor &proc)
       }
   if (!processorp)
     return false;
+  if (ahead_)
+    pm_rewind_state (*processorp);
   // clear stale connections
   pm_disconnect_ibuses (*processorp);
   pm_disconnect_obuses (*processorp);
@@ -256,6 +430,8 @@ Chain::insert (ProcessorP proc, size_t pos)
   assert_return (proc != nullptr);
   const ProcessorVec &cprocessors = processors_mt_;
   const size_t index = CLAMP (pos, 0, cprocessors.size());
+  if (ahead_)
+    engine_.suspend_ahead();    // reconnect() rewires processors the AheadJob renders
   {
     std::lock_guard<std::mutex> locker (mt_mutex_);
     processors_mt_.insert (processors_mt_.begin() + index, proc);
@@ -357,7 +533,537 @@ Chain::processor_interface () const
   return std::make_shared<Bse::ComboImpl> (*const_cast<Chain*> (this));
 }
 
+// == Parallel::Splitter ==
+/// Feeds a Parallel branch, either with the Parallel input or a crossover band of it.
+class Parallel::Splitter : public Processor {
+  struct Biquad {
+    float b0 = 1, b1 = 0, b2 = 0, a1 = 0, a2 = 0;
+  };
+  enum { HP1, HP2, LP1, LP2, N_STAGES };        // Linkwitz-Riley: 2 cascaded Butterworth sections per edge
+  Parallel &parallel_;
+  Biquad stages_[N_STAGES];
+  bool hp_ = false, lp_ = false, mute_ = false;
+  std::vector<float> z_;                        // 2 delay elements per stage and channel
+  static Biquad
+  butterworth (bool highpass, double freq, double sample_rate)
+  {
+    const double w0 = 2 * M_PI * freq / sample_rate, cosw = cos (w0);
+    const double alpha = sin (w0) * M_SQRT1_2;  // sin (w0) / (2 * Q), Q = 1/sqrt(2)
+    const double ia0 = 1.0 / (1 + alpha);
+    const double b1 = highpass ? -(1 + cosw) : 1 - cosw;
+    Biquad bq;
+    bq.b0 = 0.5 * fabs (b1) * ia0;
+    bq.b1 = b1 * ia0;
+    bq.b2 = bq.b0;
+    bq.a1 = -2 * cosw * ia0;
+    bq.a2 = (1 - alpha) * ia0;
+    return bq;
+  }
+  static void
+  filter (const Biquad &bq, float *z, const float *src, float *dst, uint n_frames)
+  {
+    float z1 = z[0], z2 = z[1];                 // transposed direct form II
+    for (uint i = 0; i < n_frames; i++)
+      {
+        const float x = src[i], y = bq.b0 * x + z1;
+        z1 = bq.b1 * x - bq.a1 * y + z2;
+        z2 = bq.b2 * x - bq.a2 * y;
+        dst[i] = y;
+      }
+    z[0] = z1;
+    z[1] = z2;
+  }
+public:
+  Splitter (const std::any &any) :
+    parallel_ (*std::any_cast<Parallel*> (any))
+  {
+    assert_return (nullptr != std::any_cast<Parallel*> (any));
+  }
+  void query_info (ProcessorInfo &info) const override  { info.label = "Bse.AudioSignal.Parallel.Splitter"; }
+  void initialize () override                           {}
+  void
+  reset () override
+  {
+    std::fill (z_.begin(), z_.end(), 0);
+  }
+  void
+  configure (uint n_ibusses, const SpeakerArrangement *ibusses, uint n_obusses, const SpeakerArrangement *obusses) override
+  {
+    remove_all_buses();
+    auto output = add_output_bus ("Output", parallel_.iospeakers_);
+    z_.resize (2 * N_STAGES * n_ochannels (output));
+    reset();
+  }
+  /// Select the crossover band, edges are Hz, `lower <= 0` or `upper <= 0` leave the band open.
+  void
+  set_band (double lower, double upper)
+  {
+    const bool hp = lower > 0, lp = upper > 0;
+    if (hp != hp_ || lp != lp_ || mute_)
+      reset();
+    hp_ = hp;
+    lp_ = lp;
+    mute_ = false;
+    if (hp_)
+      stages_[HP1] = stages_[HP2] = butterworth (true, lower, sample_rate());
+    if (lp_)
+      stages_[LP1] = stages_[LP2] = butterworth (false, upper, sample_rate());
+  }
+  void
+  set_mute ()
+  {
+    mute_ = true;
+  }
+  void
+  render (uint n_frames) override
+  {
+    const IBusId i1 = IBusId (1);
+    const OBusId o1 = OBusId (1);
+    const uint ni = parallel_.n_ichannels (i1);
+    const uint no = this->n_ochannels (o1);
+    assert_return (ni == no);
+    for (size_t c = 0; c < ni; c++)
+      {
+        const float *src = parallel_.ifloats (i1, c);
+        float *z = &z_[c * 2 * N_STAGES];
+        if (mute_)
+          assign_oblock (o1, c, 0);
+        else if (!hp_ && !lp_)
+          redirect_oblock (o1, c, src);
+        else
+          {
+            float *dst = oblock (o1, c);
+            for (uint s = hp_ ? HP1 : LP1; s < (lp_ ? N_STAGES : LP1); s++)
+              {
+                filter (stages_[s], z + 2 * s, src, dst, n_frames);
+                src = dst;
+              }
+          }
+      }
+  }
+};
+
+// == Parallel ==
+Parallel::Parallel (SpeakerArrangement iobuses) :
+  iospeakers_ (iobuses)
+{
+  assert_return (speaker_arrangement_count_channels (iobuses) > 0);
+}
+
+Parallel::~Parallel()
+{
+  for (Branch &branch : branches_mt_)
+    pm_remove_all_buses (*branch.splitter);
+  branches_mt_.clear();
+  eproc_ = nullptr;
+}
+
+void
+Parallel::query_info (ProcessorInfo &info) const
+{
+  info.uri = "Bse.AudioSignal.Parallel";
+  info.label = "Bse::AudioSignal::Parallel";
+  info.category = "Routing";
+}
+static auto bseaudiosignalparallel = Bse::enroll_asp<AudioSignal::Parallel>();
+
+void
+Parallel::initialize ()
+{
+  ChoiceEntries centries;
+  centries += { "Sum", "Feed the input into all branches and sum their outputs" };
+  centries += { "Crossover", "Split the input into frequency bands, one per branch" };
+  add_param (MODE, "Mode", "Mode", std::move (centries), SUM, "dropdown",
+             "How the input is distributed among the branches");
+  start_param_group ("Crossover");
+  add_param (XOVER1, "Crossover 1", "X1", 20, 20000, 200, "Hz", "Upper edge of the first band");
+  add_param (XOVER2, "Crossover 2", "X2", 20, 20000, 2000, "Hz", "Upper edge of the second band");
+  add_param (XOVER3, "Crossover 3", "X3", 20, 20000, 8000, "Hz", "Upper edge of the third band");
+}
+
+void
+Parallel::configure (uint n_ibusses, const SpeakerArrangement *ibusses, uint n_obusses, const SpeakerArrangement *obusses)
+{
+  remove_all_buses();
+  auto stereoin  = add_input_bus ("Input", iospeakers_);
+  auto stereoout = add_output_bus ("Output", iospeakers_);
+  (void) stereoin;
+  (void) stereoout;
+}
+
+void
+Parallel::reset()
+{
+  bands_dirty_ = true;
+}
+
+/// Assign event source for all branches.
+void
+Parallel::set_event_source (ProcessorP eproc)
+{
+  if (eproc)
+    assert_return (eproc->has_event_output());
+  eproc_ = eproc;
+  for (Branch &branch : branches_mt_)
+    branch.chain->set_event_source (eproc_);
+}
+
+/// Add a new, empty Chain as branch.
+ChainP
+Parallel::add_branch ()
+{
+  static const auto reg_id = enroll_asp<AudioSignal::Parallel::Splitter>();
+  Branch branch;
+  branch.chain = std::dynamic_pointer_cast<Chain> (Processor::registry_create (engine_, "Bse.AudioSignal.Chain"));
+  branch.splitter = Processor::registry_create (engine_, reg_id, this);
+  assert_return (branch.chain && branch.splitter, nullptr);
+  branch.chain->set_event_source (eproc_);
+  pm_connect (*branch.chain, IBusId (1), *branch.splitter, OBusId (1));
+  {
+    std::lock_guard<std::mutex> locker (mt_mutex_);
+    branches_mt_.push_back (branch);
+  }
+  bands_dirty_ = true;
+  engine_.reschedule();
+  enqueue_notify_mt (INSERTION);
+  return branch.chain;
+}
+
+/// Remove a branch previously created with add_branch().
+bool
+Parallel::remove_branch (Chain &chain)
+{
+  Branch branch;
+  for (size_t i = 0; i < branches_mt_.size(); i++)
+    if (branches_mt_[i].chain.get() == &chain)
+      {
+        branch = branches_mt_[i];
+        std::lock_guard<std::mutex> locker (mt_mutex_);
+        branches_mt_.erase (branches_mt_.begin() + i);
+        break;
+      }
+  if (!branch.chain)
+    return false;
+  pm_disconnect_ibuses (*branch.chain);
+  pm_remove_all_buses (*branch.splitter);
+  bands_dirty_ = true;
+  engine_.reschedule();
+  enqueue_notify_mt (REMOVAL);
+  return true;
+}
+
+/// Return the number of branches.
+size_t
+Parallel::n_branches ()
+{
+  const BranchVec &cbranches = branches_mt_;
+  return cbranches.size();
+}
+
+/// Return the Chain of branch `nth`.
+ChainP
+Parallel::branch (uint nth)
+{
+  const BranchVec &cbranches = branches_mt_;
+  return_unless (nth < cbranches.size(), nullptr);
+  return cbranches[nth].chain;
+}
+
+void
+Parallel::enqueue_children ()
+{
+  // shared dependencies go into the Engine schedule, so branches only read them
+  if (eproc_)
+    engine_.enqueue (*eproc_);
+  for (Branch &branch : branches_mt_)
+    {
+      branch.schedule.clear();
+      engine_.enqueue_detached (*branch.chain, branch.schedule);
+    }
+  // processors needed by several branches are rendered once, before the branches fork
+  std::vector<Processor*> shared;
+  auto contains = [] (const std::vector<Processor*> &v, Processor *proc) {
+    return std::find (v.begin(), v.end(), proc) != v.end();
+  };
+  for (size_t i = 0; i < branches_mt_.size(); i++)
+    for (Processor *proc : branches_mt_[i].schedule)
+      for (size_t j = i + 1; j < branches_mt_.size(); j++)
+        if (contains (branches_mt_[j].schedule, proc) && !contains (shared, proc))
+          shared.push_back (proc);
+  return_unless (!shared.empty());
+  for (Branch &branch : branches_mt_)
+    branch.schedule.erase (std::remove_if (branch.schedule.begin(), branch.schedule.end(),
+                                           [&] (Processor *proc) { return contains (shared, proc); }),
+                           branch.schedule.end());
+  for (Processor *proc : shared) // in dependency order, as enqueued by the first branch
+    engine_.enqueue (*proc);
+}
+
+/// Assign crossover bands to the Splitter of each branch.
+void
+Parallel::update_bands ()
+{
+  const bool dirty = check_dirty (MODE) | check_dirty (XOVER1) | check_dirty (XOVER2) | check_dirty (XOVER3);
+  return_unless (dirty || bands_dirty_);
+  bands_dirty_ = false;
+  const bool crossover = std::round (get_param (MODE)) == CROSSOVER;
+  const uint n_bands = std::min (branches_mt_.size(), size_t (MAX_BANDS));
+  double edges[MAX_BANDS - 1] = { get_param (XOVER1), get_param (XOVER2), get_param (XOVER3) };
+  if (n_bands > 1)
+    std::sort (edges, edges + n_bands - 1);
+  for (double &edge : edges)
+    edge = std::min (edge, 0.9 * engine_.nyquist());
+  for (size_t i = 0; i < branches_mt_.size(); i++)
+    {
+      Splitter &splitter = dynamic_cast<Splitter&> (*branches_mt_[i].splitter);
+      if (!crossover)
+        splitter.set_band (0, 0);
+      else if (i >= n_bands)
+        splitter.set_mute();            // excess branches receive no band
+      else
+        splitter.set_band (i > 0 ? edges[i - 1] : 0, i + 1 < n_bands ? edges[i] : 0);
+    }
+}
+
+void
+Parallel::render_branch (void *data, size_t nth)
+{
+  Parallel &self = *(Parallel*) data;
+  for (Processor *proc : self.branches_mt_[nth].schedule)
+    pm_render_block (*proc);
+}
+
+void
+Parallel::render (uint n_frames)
+{
+  constexpr OBusId OUT1 = OBusId (1);
+  update_bands();
+  const BranchVec &cbranches = branches_mt_;
+  engine_.parallel_for (cbranches.size(), render_branch, this);
+  const size_t n_och = n_ochannels (OUT1);
+  for (size_t c = 0; c < n_och; c++)
+    {
+      if (cbranches.empty())
+        {
+          assign_oblock (OUT1, c, 0);
+          continue;
+        }
+      float *dst = oblock (OUT1, c);
+      for (size_t i = 0; i < cbranches.size(); i++)
+        {
+          const Chain &chain = *cbranches[i].chain;
+          const float *src = chain.ofloats (OUT1, std::min (c, size_t (chain.n_ochannels (OUT1)) - 1));
+          if (i == 0)
+            floatcopy (dst, src, n_frames);
+          else
+            floataccumulate (dst, src, n_frames);
+        }
+    }
+}
+
+// == Engine::Workers ==
+static __thread bool tls_in_parallel_job = false;
+static __thread int  tls_thread_tid = 0;
+
+// Apply scheduling policy and nice level of the thread `render_tid` to the calling thread, once per render thread.
+static void
+adopt_render_scheduling (const std::atomic<int> &render_tid, int &adopted_tid)
+{
+  const int tid = render_tid.load (std::memory_order_relaxed);
+  return_unless (tid && tid != adopted_tid);
+  adopted_tid = tid;
+  struct sched_param param = { 0, };
+  const int policy = sched_getscheduler (tid);
+  if (policy >= 0 && sched_getparam (tid, &param) == 0 && sched_setscheduler (0, policy, &param) != 0)
+    PDEBUG ("%s: failed to adopt scheduling policy %d: %s", this_thread_get_name(), policy, strerror (errno));
+  errno = 0;
+  const int prio = getpriority (PRIO_PROCESS, tid);
+  if (errno == 0)
+    setpriority (PRIO_PROCESS, this_thread_gettid(), prio);
+}
+
+/// Helper threads that render independent parts of a schedule concurrently.
+/// The threads adopt the scheduling class and priority of the render thread.
+class Engine::Workers {
+  const std::atomic<int>  &render_tid_;
+  std::vector<std::thread> threads_;
+  std::mutex               mutex_;
+  std::condition_variable  cond_, done_cond_;
+  uint64                   generation_ = 0;     // guarded by mutex_
+  bool                     running_ = true;     // guarded by mutex_
+  bool                     open_ = false;       // guarded by mutex_, set while run() accepts participants
+  bool                     waiting_ = false;    // guarded by mutex_
+  ParallelJob              job_ = nullptr;      // guarded by mutex_, along with data_ and n_jobs_
+  void                    *data_ = nullptr;
+  size_t                   n_jobs_ = 0;
+  std::atomic<size_t>      next_job_ { 0 }, done_jobs_ { 0 };
+  uint                     busy_ = 0;           // guarded by mutex_
+  void
+  work (ParallelJob job, void *data, size_t n_jobs)
+  {
+    tls_in_parallel_job = true;
+    size_t nth;
+    while ((nth = next_job_++) < n_jobs)
+      {
+        job (data, nth);
+        done_jobs_++;
+      }
+    tls_in_parallel_job = false;
+  }
+  void
+  worker_loop (uint nth)
+  {
+    this_thread_set_name (string_format ("DSP-Worker-%u", nth));
+    int adopted_tid = 0;
+    adopt_render_scheduling (render_tid_, adopted_tid);
+    uint64 seen = 0;
+    std::unique_lock<std::mutex> lock (mutex_);
+    while (true)
+      {
+        cond_.wait (lock, [&] () { return !running_ || generation_ != seen; });
+        if (!running_)
+          break;
+        seen = generation_;
+        if (!open_)
+          continue;             // woken too late, run() returned and job_ may be rewritten any time
+        // run() cannot return before busy_ drops, so the snapshot and counters stay valid for `seen`
+        const ParallelJob job = job_;
+        void *const data = data_;
+        const size_t n_jobs = n_jobs_;
+        busy_++;
+        lock.unlock();
+        adopt_render_scheduling (render_tid_, adopted_tid); // the render thread may have changed
+        work (job, data, n_jobs);
+        lock.lock();
+        busy_--;
+        if (!busy_ && waiting_)
+          done_cond_.notify_one();
+      }
+  }
+public:
+  explicit
+  Workers (uint n_threads, const std::atomic<int> &render_tid) :
+    render_tid_ (render_tid)
+  {
+    for (uint i = 0; i < n_threads; i++)
+      threads_.emplace_back (&Workers::worker_loop, this, 1 + i);
+  }
+  ~Workers()
+  {
+    {
+      std::lock_guard<std::mutex> locker (mutex_);
+      running_ = false;
+    }
+    cond_.notify_all();
+    for (auto &thread : threads_)
+      thread.join();
+  }
+  void
+  run (size_t n_jobs, ParallelJob job, void *data)
+  {
+    std::unique_lock<std::mutex> lock (mutex_);
+    job_ = job;
+    data_ = data;
+    n_jobs_ = n_jobs;
+    next_job_ = 0;
+    done_jobs_ = 0;
+    generation_++;
+    open_ = true;
+    lock.unlock();
+    cond_.notify_all();
+    work (job, data, n_jobs);   // the calling thread participates
+    for (uint spins = 0; done_jobs_ < n_jobs && spins < 1024; spins++)
+      ;                         // jobs are short, spin briefly before sleeping
+    lock.lock();
+    waiting_ = true;            // workers run with the render thread priority, so waiting cannot invert
+    done_cond_.wait (lock, [&] () { return busy_ == 0; });
+    waiting_ = false;
+    open_ = false;              // workers woken from now on skip this generation
+    assert_warn (done_jobs_ == n_jobs);
+  }
+};
+
+// == Engine::Anticipator ==
+/// Helper thread that runs AheadJob callbacks between Engine render cycles.
+/// Suspending and resuming from the render thread is lock-free, the jobs run without locks and
+/// the thread adopts the render thread scheduling, so suspend() spins at most for one block.
+class Engine::Anticipator {
+  using Job = std::pair<AheadJob,void*>;
+  const std::atomic<int>  &render_tid_;
+  std::vector<Job>         jobs_;               // modified only while suspended and idle
+  std::mutex               mutex_;              // only used to sleep on cond_
+  std::condition_variable  cond_;
+  std::atomic<bool>        running_ { true };
+  std::atomic<bool>        suspended_ { false };
+  std::atomic<bool>        busy_ { false };     // set while jobs_ are in use
+  std::atomic<uint64>      generation_ { 0 };   // incremented by resume()
+  std::thread              thread_;
+  void
+  thread_loop ()
+  {
+    this_thread_set_name ("DSP-Ahead");
+    int adopted_tid = 0;
+    uint64 seen = 0;
+    while (running_)
+      {
+        adopt_render_scheduling (render_tid_, adopted_tid);
+        bool worked = false;
+        busy_ = true;                                   // pairs with suspend(), both are seq_cst
+        for (size_t i = 0; !suspended_ && i < jobs_.size(); i++)
+          worked |= jobs_[i].first (jobs_[i].second);   // renders at most one block
+        busy_ = false;
+        if (worked && !suspended_)
+          continue;
+        // resume() notifies without the mutex, so a wakeup can be missed, the timeout bounds the delay
+        std::unique_lock<std::mutex> lock (mutex_);
+        cond_.wait_for (lock, std::chrono::milliseconds (5), [&] () { return !running_ || generation_ != seen; });
+        seen = generation_;
+      }
+  }
+public:
+  explicit
+  Anticipator (const std::atomic<int> &render_tid) :
+    render_tid_ (render_tid), thread_ (&Anticipator::thread_loop, this)
+  {}
+  ~Anticipator()
+  {
+    running_ = false;
+    cond_.notify_all();
+    thread_.join();
+  }
+  void
+  add (AheadJob job, void *data)
+  {
+    suspend();
+    jobs_.push_back ({ job, data });
+  }
+  void
+  del (void *data)
+  {
+    suspend();
+    for (size_t i = 0; i < jobs_.size(); i++)
+      if (jobs_[i].second == data)
+        jobs_.erase (jobs_.begin() + i--);
+  }
+  void
+  suspend ()
+  {
+    suspended_ = true;
+    while (busy_)                       // a job renders at most one block
+      std::this_thread::yield();        // let the job finish on the same CPU
+  }
+  void
+  resume ()
+  {
+    suspended_ = false;
+    generation_++;
+    cond_.notify_one();
+  }
+};
+
 // == Engine ==
+__thread uint64_t Engine::tls_frame_counter_ = 0;
+
 Engine::Engine (uint32 samplerate, AudioTiming &atiming, std::function<void()> wakeup) :
   nyquist_ (samplerate * 0.5), inyquist_ (1.0 / nyquist_), sample_rate_ (samplerate),
   frame_counter_ (MAX_RENDER_BLOCK_SIZE), eflags_ (0), scheduler_depth_ (0),
@@ -371,6 +1077,14 @@ Engine::Engine (uint32 samplerate, AudioTiming &atiming, std::function<void()> w
   assert_return (wakeup_ != nullptr);
 }
 
+Engine::~Engine()
+{
+  delete anticipator_;
+  anticipator_ = nullptr;
+  delete workers_;
+  workers_ = nullptr;
+}
+
 void
 Engine::add_root (ProcessorP rootproc)
 {
@@ -407,6 +1121,10 @@ Engine::in_schedule (Processor &proc)
   for (auto procp : schedule_)
     if (procp == &proc)
       return true;
+  if (detached_)
+    for (auto procp : *detached_)
+      if (procp == &proc)
+        return true;
   return false;
 }
 
@@ -419,6 +1137,7 @@ Engine::make_schedule ()
   if (0 == (eflags_ & RESCHEDULE))
     return;
   eflags_ &= ~uint (RESCHEDULE);
+  suspend_ahead();      // subschedules are rebuilt
   schedule_.clear();
   scheduler_depth_ += 1;
   for (auto root : roots_)
@@ -437,7 +1156,107 @@ Engine::enqueue (Processor &proc)
   proc.enqueue_deps();
   scheduler_depth_ -= 1;
   if (!in_schedule (proc))
-    schedule_.push_back (&proc);
+    (detached_ ? detached_ : &schedule_)->push_back (&proc);
+}
+
+/// Enqueue `proc` and its dependencies into `subschedule` instead of the Engine schedule.
+/// Dependencies that are already part of the Engine schedule are left out. Used by processors
+/// that render parts of the signal graph themselves, e.g. concurrently via parallel_for().
+void
+Engine::enqueue_detached (Processor &proc, std::vector<Processor*> &subschedule)
+{
+  std::vector<Processor*> *const saved = detached_;
+  const size_t start = subschedule.size();
+  detached_ = &subschedule;
+  enqueue (proc);
+  detached_ = saved;
+  for (size_t i = start; i < subschedule.size(); i++)
+    subschedule[i]->reset_state();
+}
+
+/// Check that `subschedule` can be rendered without the Engine schedule and without live input.
+/// Inputs of `owner` count as dependencies of the `subschedule`.
+bool
+Engine::independent (Processor &owner, const std::vector<Processor*> &subschedule)
+{
+  auto contained = [&subschedule] (Processor *proc) {
+    return std::find (subschedule.begin(), subschedule.end(), proc) != subschedule.end();
+  };
+  for (size_t i = 0; i < owner.n_ibuses(); i++)
+    if (owner.iobus (IBusId (1 + i)).proc)
+      return false;
+  for (Processor *proc : subschedule)
+    {
+      if (proc->live_input())
+        return false;
+      if (proc->estreams_ && proc->estreams_->oproc && !contained (proc->estreams_->oproc))
+        return false;
+      for (size_t i = 0; i < proc->n_ibuses(); i++)
+        {
+          Processor *iproc = proc->iobus (IBusId (1 + i)).proc;
+          if (iproc && !contained (iproc))
+            return false;
+        }
+    }
+  return true;
+}
+
+/// Register `job (data)` to be called repeatedly from a background thread between render cycles.
+/// The job renders ahead of time (see AheadFrame) and returns `false` once it has nothing to do.
+void
+Engine::add_ahead_job (AheadJob job, void *data)
+{
+  assert_return (job != nullptr);
+  if (!anticipator_)            // without start_workers(), e.g. for offline rendering
+    anticipator_ = new Anticipator (render_tid_);
+  anticipator_->add (job, data);
+}
+
+/// Unregister all AheadJob callbacks for `data`, returns after running jobs are done.
+void
+Engine::del_ahead_job (void *data)
+{
+  if (anticipator_)
+    anticipator_->del (data);
+}
+
+/// Pause AheadJob callbacks until the end of the current render cycle, needed for graph changes.
+/// Does not lock, but waits for a running AheadJob to complete its block.
+void
+Engine::suspend_ahead ()
+{
+  if (anticipator_)
+    anticipator_->suspend();
+}
+
+/// Start the worker threads used by parallel_for() and for AheadJob callbacks, `n_threads == 0` picks
+/// a default for the number of CPUs. Needs to be called when the Engine starts, since the render
+/// thread must not create threads. The threads adopt the scheduling class and priority of the thread
+/// that calls render_block().
+void
+Engine::start_workers (uint n_threads)
+{
+  static const uint n_default = std::min (std::max (1, this_thread_online_cpus()) - 1, 7);
+  if (!anticipator_)
+    anticipator_ = new Anticipator (render_tid_);
+  return_unless (!workers_);
+  if (!n_threads)
+    n_threads = n_default;
+  if (n_threads)
+    workers_ = new Workers (n_threads, render_tid_);
+}
+
+/// Call `job (data, nth)` for all `nth < n_jobs`, concurrently on the Engine worker threads.
+/// Returns once all jobs are done, nested calls from within a job or AheadJob are executed serially,
+/// as are all calls before start_workers().
+void
+Engine::parallel_for (size_t n_jobs, ParallelJob job, void *data)
+{
+  if (workers_ && n_jobs > 1 && !tls_in_parallel_job && !tls_frame_counter_) // workers serve the render thread only
+    workers_->run (n_jobs, job, data);
+  else
+    for (size_t i = 0; i < n_jobs; i++)
+      job (data, i);
 }
 
 /// Render a block of MAX_RENDER_BLOCK_SIZE in all Processors connected to this Engine.
@@ -445,9 +1264,15 @@ void
 Engine::render_block()
 {
   assert_return (!(eflags_ & RESCHEDULE));
+  if (BSE_UNLIKELY (!tls_thread_tid))
+    tls_thread_tid = this_thread_gettid();
+  if (BSE_UNLIKELY (render_tid_.load (std::memory_order_relaxed) != tls_thread_tid))
+    render_tid_.store (tls_thread_tid, std::memory_order_relaxed); // scheduling reference for workers
   frame_counter_ += MAX_RENDER_BLOCK_SIZE;
   for (auto procp : schedule_)
     procp->render_block();
+  if (anticipator_)
+    anticipator_->resume();
   /* TODO: concurrent rendering:
      - rework schedule_ into a dependency tree, each node reflects a processor and its dependencies
      - a worker starts on a node, processes dependencies in depth first fashion
@@ -465,6 +1290,13 @@ Engine::ipc_pending ()
   return Processor::has_notifies_e();
 }
 
+/// Milliseconds until pending notifications are due for ipc_dispatch(), or -1.
+int
+Engine::ipc_timeout ()
+{
+  return Processor::notifies_timeout_e();
+}
+
 void
 Engine::ipc_dispatch ()
 {
@@ -577,3 +1409,233 @@ ComboImpl::audio_signal_processor () const
 }
 
 } // Bse
+
+// == Testing ==
+#include "testing.hh"
+
+namespace { // Anon
+using namespace Bse;
+using namespace Bse::AudioSignal;
+
+// Source that counts its render() calls, outputs the count.
+class TestCounter : public Processor {
+public:
+  std::atomic<uint> n_renders { 0 }, n_resets { 0 };
+  void query_info (ProcessorInfo &info) const override  { info.label = "TestCounter"; }
+  void initialize () override                           {}
+  void reset () override                                { n_resets++; }
+  void
+  configure (uint n_ibusses, const SpeakerArrangement *ibusses, uint n_obusses, const SpeakerArrangement *obusses) override
+  {
+    remove_all_buses();
+    add_output_bus ("Output", SpeakerArrangement::MONO);
+  }
+  void
+  render (uint n_frames) override
+  {
+    assign_oblock (OBusId (1), 0, ++n_renders);
+  }
+};
+
+// Passes the main input through and adds the side input.
+class TestSideSum : public Processor {
+public:
+  void query_info (ProcessorInfo &info) const override  { info.label = "TestSideSum"; }
+  void initialize () override                           {}
+  void reset () override                                {}
+  void
+  configure (uint n_ibusses, const SpeakerArrangement *ibusses, uint n_obusses, const SpeakerArrangement *obusses) override
+  {
+    remove_all_buses();
+    add_input_bus ("Input", SpeakerArrangement::STEREO);
+    add_input_bus ("Side", SpeakerArrangement::MONO);
+    add_output_bus ("Output", SpeakerArrangement::STEREO);
+  }
+  void
+  render (uint n_frames) override
+  {
+    for (uint c = 0; c < 2; c++)
+      {
+        const float *in = ifloats (IBusId (1), c), *side = ifloats (IBusId (2), 0);
+        float *out = oblock (OBusId (1), c);
+        for (uint i = 0; i < n_frames; i++)
+          out[i] = in[i] + side[i];
+      }
+  }
+  static void
+  connect_side (Processor &sidesum, Processor &source)
+  {
+    struct Manager : ProcessorManager {
+      using ProcessorManager::pm_connect;
+    };
+    Manager::pm_connect (sidesum, IBusId (2), source, OBusId (1));
+  }
+};
+
+BSE_INTEGRITY_TEST (bse_engine_parallel_for);
+static void
+bse_engine_parallel_for ()
+{
+  AudioTiming timing { 120, 0 };
+  Engine engine (48000, timing, [] () {});
+  engine.start_workers (3);
+  constexpr size_t N = 97;
+  std::atomic<uint> counts[N];
+  for (auto &c : counts)
+    c = 0;
+  for (size_t r = 0; r < 50; r++)
+    engine.parallel_for (N, [] (void *data, size_t nth) {
+      std::atomic<uint> *counts = (std::atomic<uint>*) data;
+      counts[nth]++;
+    }, counts);
+  for (size_t i = 0; i < N; i++)
+    TCMP (counts[i].load(), ==, 50);
+  // back-to-back generations with alternating data and sizes, late workers must not mix them up
+  constexpr size_t ROUNDS = 4000;
+  std::atomic<uint> small[3] = { 0, 0, 0 };
+  uint small_jobs = 0;
+  for (auto &c : counts)
+    c = 0;
+  for (size_t r = 0; r < ROUNDS; r++)
+    {
+      const size_t n = r & 1 ? N : 1 + r % 3;
+      small_jobs += r & 1 ? 0 : n;
+      engine.parallel_for (n, [] (void *data, size_t nth) {
+        std::atomic<uint> *counts = (std::atomic<uint>*) data;
+        counts[nth]++;
+      }, r & 1 ? counts : small);
+    }
+  for (size_t i = 0; i < N; i++)
+    TCMP (counts[i].load(), ==, ROUNDS / 2);
+  TCMP (small[0].load() + small[1].load() + small[2].load(), ==, small_jobs);
+}
+
+BSE_INTEGRITY_TEST (bse_parallel_shared_dependency);
+static void
+bse_parallel_shared_dependency ()
+{
+  static const auto counter_id = enroll_asp<TestCounter>();
+  static const auto sidesum_id = enroll_asp<TestSideSum>();
+  AudioTiming timing { 120, 0 };
+  Engine engine (48000, timing, [] () {});
+  engine.start_workers (3);
+  ParallelP parallel = std::dynamic_pointer_cast<Parallel> (Processor::registry_create (engine, "Bse.AudioSignal.Parallel"));
+  auto counter = std::dynamic_pointer_cast<TestCounter> (Processor::registry_create (engine, counter_id, {}));
+  TASSERT (parallel && counter);
+  std::vector<ProcessorP> sums;
+  for (size_t i = 0; i < 3; i++)
+    {
+      ChainP branch = parallel->add_branch();
+      ProcessorP sum = Processor::registry_create (engine, sidesum_id, {});
+      TASSERT (branch && sum);
+      branch->insert (sum);
+      TestSideSum::connect_side (*sum, *counter);
+      sums.push_back (sum);
+    }
+  engine.add_root (parallel);
+  engine.make_schedule();
+  TASSERT (engine.in_schedule (*counter));      // rendered before the branches fork
+  constexpr uint N_BLOCKS = 100;
+  for (uint b = 1; b <= N_BLOCKS; b++)
+    {
+      engine.render_block();
+      TCMP (counter->n_renders.load(), ==, b);         // once per block, not once per branch
+      for (const ProcessorP &sum : sums)
+        TCMP (sum->ofloats (OBusId (1), 0)[0], ==, b);
+      TCMP (parallel->ofloats (OBusId (1), 0)[0], ==, 3 * b);
+    }
+  engine.del_root (parallel);
+}
+
+// Outputs its block count and stalls once, to force an underrun of the rendering ahead of time.
+// Stalls the AheadJob at block `stall_at` until the Chain has seen an underrun.
+class TestStaller : public TestCounter {
+public:
+  uint             stall_at = 10;
+  Chain           *chain = nullptr;
+  std::thread::id  render_thread;
+  void query_info (ProcessorInfo &info) const override  { info.label = "TestStaller"; }
+  void
+  render (uint n_frames) override
+  {
+    TestCounter::render (n_frames);
+    if (n_renders == stall_at && std::this_thread::get_id() != render_thread)
+      while (chain->underruns() == 0)
+        std::this_thread::yield();
+  }
+};
+
+BSE_INTEGRITY_TEST (bse_chain_ahead_underrun);
+static void
+bse_chain_ahead_underrun ()
+{
+  static const auto staller_id = enroll_asp<TestStaller>();
+  AudioTiming timing { 120, 0 };
+  Engine engine (48000, timing, [] () {});
+  engine.start_workers (1);
+  ChainP chain = std::dynamic_pointer_cast<Chain> (Processor::registry_create (engine, "Bse.AudioSignal.Chain"));
+  auto staller = std::dynamic_pointer_cast<TestStaller> (Processor::registry_create (engine, staller_id, {}));
+  TASSERT (chain && staller);
+  staller->chain = chain.get();
+  staller->render_thread = std::this_thread::get_id();
+  chain->insert (staller);
+  chain->anticipate (true);
+  engine.add_root (chain);
+  engine.make_schedule();
+  // every block `b` outputs `b`, whether rendered ahead or at the deadline after an underrun
+  for (uint b = 1; b <= 120; b++)
+    {
+      engine.render_block();
+      const float v = chain->ofloats (OBusId (1), 0)[0];
+      TCMP (chain->ofloats (OBusId (1), 1)[MAX_RENDER_BLOCK_SIZE - 1], ==, v);
+      TCMP (v, ==, b);
+    }
+  TCMP (chain->underruns(), >, 0);              // the stall caused an underrun
+  TCMP (staller->n_renders.load(), >=, 120);    // each block is rendered once, in order
+  engine.del_root (chain);
+  chain->anticipate (false);
+}
+
+BSE_INTEGRITY_TEST (bse_chain_ahead_reschedule);
+static void
+bse_chain_ahead_reschedule ()
+{
+  static const auto counter_id = enroll_asp<TestCounter>();
+  AudioTiming timing { 120, 0 };
+  Engine engine (48000, timing, [] () {});
+  engine.start_workers (1);
+  ChainP chain = std::dynamic_pointer_cast<Chain> (Processor::registry_create (engine, "Bse.AudioSignal.Chain"));
+  auto counter = std::dynamic_pointer_cast<TestCounter> (Processor::registry_create (engine, counter_id, {}));
+  TASSERT (chain && counter);
+  chain->insert (counter);
+  chain->anticipate (true);
+  engine.add_root (chain);
+  engine.make_schedule();
+  const uint n_resets = counter->n_resets;
+  // rescheduling while blocks are rendered ahead keeps the processor state and timeline
+  for (uint b = 1; b <= 60; b++)
+    {
+      if (b % 20 == 0)
+        {
+          while (counter->n_renders < b + 4)
+            std::this_thread::yield();          // let the AheadJob get ahead
+          engine.reschedule();
+          engine.make_schedule();
+        }
+      engine.render_block();
+      TCMP (chain->ofloats (OBusId (1), 0)[0], ==, b);
+    }
+  TCMP (counter->n_resets.load(), ==, n_resets);
+  // without anticipation, the processor is reset and continues at the Engine frame
+  while (counter->n_renders < 64)
+    std::this_thread::yield();
+  chain->anticipate (false);
+  TCMP (counter->n_resets.load(), >, n_resets);
+  engine.make_schedule();
+  const uint n_renders = counter->n_renders;
+  engine.render_block();
+  TCMP (counter->n_renders.load(), ==, n_renders + 1);
+  engine.del_root (chain);
+}
+
+} // Anon
@@ -7,6 +7,11 @@ namespace Bse {
 
 namespace AudioSignal {
 
+class FreezeCache;
+using FreezeCacheP = std::shared_ptr<FreezeCache>;
+class Freezer;
+using FreezerP = std::shared_ptr<Freezer>;
+
 // == Chain ==
 /// Container for connecting multiple Processors in a chain.
 class Chain : public Processor, ProcessorManager {
@@ -19,7 +24,14 @@ class Chain : public Processor, ProcessorManager {
   Processor *last_output_ = nullptr;
   const SpeakerArrangement ispeakers_ = SpeakerArrangement (0);
   const SpeakerArrangement ospeakers_ = SpeakerArrangement (0);
+  FreezeCacheP frozen_;         // bypasses processors_mt_ while set
+  int64_t frozen_anchor_ = 0;
+  struct Ahead;
+  std::unique_ptr<Ahead> ahead_; // renders processors_mt_ ahead of time while set
   std::mutex mt_mutex_;
+  static bool render_ahead      (void *data);
+  void        render_processors ();
+  void        rewind_processors ();
 protected:
   void       initialize       () override;
   void       configure        (uint n_ibusses, const SpeakerArrangement *ibusses, uint n_obusses, const SpeakerArrangement *obusses) override;
@@ -39,10 +51,55 @@ public:
   size_t     find_pos         (Processor &proc);
   size_t     size             ();
   void       set_event_source (ProcessorP eproc);
+  void       freeze           (FreezeCacheP cache, int64_t anchor);
+  bool       frozen           () const  { return frozen_ != nullptr; }
+  void       anticipate       (bool enable);
+  bool       anticipated      () const  { return ahead_ != nullptr; }
+  uint64     underruns        () const;
   ProcessorVec list_processors_mt () const;
 };
 using ChainP = std::shared_ptr<Chain>;
 
+// == Parallel ==
+/// Container for Chain branches that process the same input concurrently.
+/// The input is either copied into all branches or split into frequency bands by
+/// a Linkwitz-Riley crossover, the branch outputs are summed up.
+class Parallel : public Processor, ProcessorManager {
+  class Splitter;
+  struct Branch {
+    ChainP                  chain;
+    ProcessorP              splitter;
+    std::vector<Processor*> schedule;   // detached from the Engine schedule
+  };
+  using BranchVec = vector<Branch>;
+  BranchVec branches_mt_; // modifications guarded by mt_mutex_
+  ProcessorP eproc_;
+  const SpeakerArrangement iospeakers_ = SpeakerArrangement (0);
+  bool bands_dirty_ = true;
+  std::mutex mt_mutex_;
+  void       update_bands     ();
+  static void render_branch   (void *data, size_t nth);
+protected:
+  void       initialize       () override;
+  void       configure        (uint n_ibusses, const SpeakerArrangement *ibusses, uint n_obusses, const SpeakerArrangement *obusses) override;
+  void       reset            () override;
+  void       render           (uint n_frames) override;
+  void       enqueue_children () override;
+public:
+  enum Params { MODE = 1, XOVER1, XOVER2, XOVER3 };
+  enum Mode { SUM = 0, CROSSOVER };
+  static constexpr uint MAX_BANDS = 4; ///< Number of branches supported in CROSSOVER mode.
+  explicit   Parallel         (SpeakerArrangement iobuses = SpeakerArrangement::STEREO);
+  virtual    ~Parallel        ();
+  void       query_info       (ProcessorInfo &info) const override;
+  ChainP     add_branch       ();
+  bool       remove_branch    (Chain &chain);
+  size_t     n_branches       ();
+  ChainP     branch           (uint nth);
+  void       set_event_source (ProcessorP eproc);
+};
+using ParallelP = std::shared_ptr<Parallel>;
+
 } // AudioSignal
 
 // == ComboImpl ==
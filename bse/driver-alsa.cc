@@ -3,6 +3,8 @@
 #include "bseengine.hh"
 #include "internal.hh"
 #include "gsldatautils.hh"
+#include "signalmath.hh"
+#include "floatutils.hh"
 #include "bsesequencer.hh"
 #include "bsemididecoder.hh"
 
@@ -44,6 +46,9 @@
  * - If we're very fast generating periods, we ideally have enough buffer space to write without blocking.
  * Thus, we need 1 playing period, 1 extra period, 1 unfilled period, i.e. 3 periods of buffer size and
  * we need avail_min to match the period size.
+ * - With MMAP_INTERLEAVED access, samples are converted directly from/into the hardware ring buffer
+ *   between snd_pcm_mmap_begin() and snd_pcm_mmap_commit(), avoiding the intermediate period buffer
+ *   and the read/write syscalls. RW_INTERLEAVED access is used if the device lacks mmap support.
  */
 
 #if __has_include(<alsa/asoundlib.h>)
@@ -56,6 +61,21 @@ namespace Bse {
 
 static std::string hex_str (uint len, const uint8 *d);
 
+// Convert to 16bit with clipping, loops are kept free of FPU mode changes to allow auto-vectorization
+static inline void
+alsa_s16_from_float (int16 *__restrict__ d, const float *__restrict__ s, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    d[i] = irintf (CLAMP (s[i] * 32768.f, -32768.f, 32767.f));
+}
+
+static inline void
+alsa_float_from_s16 (float *__restrict__ d, const int16 *__restrict__ s, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+    d[i] = s[i] * (1.f / 32768.f);
+}
+
 static String
 chars2string (const char *s)
 {
@@ -269,9 +289,36 @@ class AlsaPcmDriver : public PcmDriver {
   uint          n_channels_ = 0;
   uint          n_periods_ = 0;
   uint          period_size_ = 0;       // count in frames
+  bool          read_mmap_ = false;
+  bool          write_mmap_ = false;
   int16        *period_buffer_ = nullptr;
   uint          read_write_count_ = 0;
   String        alsadev_;
+  bool          linked_ = false;
+  // direct input monitoring and round-trip measurement
+  enum { PROBE_IDLE, PROBE_ARMED, PROBE_WAITING };
+  float         monitor_level_ = 0;
+  bool          monitor_fresh_ = false; // monitor_buffer_ holds the input of the current period
+  std::vector<float> monitor_buffer_;
+  std::vector<float> mix_buffer_;
+  uint64        read_frames_ = 0;       // frames captured since the last (re-)start
+  uint64        write_frames_ = 0;      // frames written since the last (re-)start, excluding the silence prefill
+  uint64        probe_frame_ = 0;
+  std::atomic<int>    probe_state_ { PROBE_IDLE };
+  std::atomic<int64>  roundtrip_frames_ { -1 };
+  // adaptive buffer size and telemetry
+  uint          latency_ms_ = 0;
+  uint          min_periods_ = 0;
+  uint          max_periods_ = 0;
+  uint          want_periods_ = 0;      // overrides the period count derived from latency_ms
+  uint64        last_io_stamp_ = 0;
+  uint64        xruns_at_adjustment_ = 0;
+  uint64        periods_since_adjustment_ = 0;
+  std::atomic<uint64> xruns_ { 0 };
+  std::atomic<uint64> adjustments_ { 0 };
+  std::atomic<uint>   stat_periods_ { 0 };
+  std::array<std::atomic<uint64>, PcmDriverStats::HISTOGRAM_BUCKETS> jitter_ {};
+  std::array<std::atomic<uint64>, PcmDriverStats::HISTOGRAM_BUCKETS> lateness_ {};
 public:
   explicit      AlsaPcmDriver (const String &devid) : PcmDriver (devid) {}
   static PcmDriverP
@@ -318,6 +365,9 @@ public:
       }
     delete[] period_buffer_;
     period_buffer_ = nullptr;
+    monitor_buffer_.clear();
+    mix_buffer_.clear();
+    linked_ = false;
     flags_ &= ~size_t (Flags::OPENED | Flags::READABLE | Flags::WRITABLE);
     alsadev_ = "";
   }
@@ -341,6 +391,7 @@ public:
     flags_ |= Flags::READABLE * require_readable;
     flags_ |= Flags::WRITABLE * require_writable;
     n_channels_ = config.n_channels;
+    want_periods_ = 0;
     // try open
     snd_lib_error_set_handler (silent_error_handler);
     if (!aerror && require_readable)
@@ -353,16 +404,17 @@ public:
     Error error = !aerror ? Error::NONE : bse_error_from_errno (-aerror, Error::FILE_OPEN_FAILED);
     uint rh_freq = config.mix_freq, rh_n_periods = 2, rh_period_size = period_size;
     if (!aerror && read_handle_)
-      error = alsa_device_setup (read_handle_, config.latency_ms, &rh_freq, &rh_n_periods, &rh_period_size);
+      error = alsa_device_setup (read_handle_, config.latency_ms, &rh_freq, &rh_n_periods, &rh_period_size, &read_mmap_);
     uint wh_freq = config.mix_freq, wh_n_periods = 2, wh_period_size = period_size;
     if (!aerror && write_handle_)
-      error = alsa_device_setup (write_handle_, config.latency_ms, &wh_freq, &wh_n_periods, &wh_period_size);
+      error = alsa_device_setup (write_handle_, config.latency_ms, &wh_freq, &wh_n_periods, &wh_period_size, &write_mmap_);
     // check duplex
     if (error == 0 && read_handle_ && write_handle_)
       {
         const bool linked = snd_pcm_link (read_handle_, write_handle_) == 0;
         if (rh_freq != wh_freq || rh_n_periods != wh_n_periods || rh_period_size != wh_period_size || !linked)
           error = Error::DEVICES_MISMATCH;
+        linked_ = linked;
         ADEBUG ("PCM: %s: %s: %f==%f && %d*%d==%d*%d && linked==%d", alsadev_,
                 error != 0 ? "MISMATCH" : "LINKED", rh_freq, wh_freq, rh_n_periods, rh_period_size, wh_n_periods, wh_period_size, linked);
       }
@@ -377,6 +429,20 @@ public:
       {
         period_buffer_ = new int16[period_size_ * n_channels_];
         flags_ |= Flags::OPENED;
+        // bounds for adaptive period counts, the period size is fixed by the engine block length
+        latency_ms_ = config.latency_ms;
+        min_periods_ = n_periods_;
+        max_periods_ = n_periods_;
+        if (config.max_latency_ms > config.latency_ms)
+          max_periods_ = CLAMP (mix_freq_ * config.max_latency_ms / 1000 / period_size_ + 1, n_periods_, 1024);
+        stat_periods_ = n_periods_;
+        ADEBUG ("PCM: %s: adaptive n_periods: %u..%u", alsadev_, min_periods_, max_periods_);
+        // direct monitoring needs both streams running in lock step
+        monitor_level_ = linked_ ? config.monitor_level : 0;
+        monitor_buffer_.assign (period_size_ * n_channels_, 0.f);
+        mix_buffer_.assign (period_size_ * n_channels_, 0.f);
+        roundtrip_frames_ = -1;
+        ADEBUG ("PCM: %s: input monitoring: %f", alsadev_, monitor_level_);
       }
     else
       {
@@ -393,7 +459,7 @@ public:
     return error;
   }
   Error
-  alsa_device_setup (snd_pcm_t *phandle, uint latency_ms, uint *mix_freq, uint *n_periodsp, uint *period_sizep)
+  alsa_device_setup (snd_pcm_t *phandle, uint latency_ms, uint *mix_freq, uint *n_periodsp, uint *period_sizep, bool *mmapp)
   {
     // turn on blocking behaviour since we may end up in read() with an unfilled buffer
     if (snd_pcm_nonblock (phandle, 0) < 0)
@@ -404,8 +470,10 @@ public:
       return_error ("snd_pcm_hw_params_any", FILE_OPEN_FAILED);
     if (snd_pcm_hw_params_set_channels (phandle, hparams, n_channels_) < 0)
       return_error ("snd_pcm_hw_params_set_channels", DEVICE_CHANNELS);
-    if (snd_pcm_hw_params_set_access (phandle, hparams, SND_PCM_ACCESS_RW_INTERLEAVED) < 0)
+    *mmapp = snd_pcm_hw_params_set_access (phandle, hparams, SND_PCM_ACCESS_MMAP_INTERLEAVED) == 0;
+    if (!*mmapp && snd_pcm_hw_params_set_access (phandle, hparams, SND_PCM_ACCESS_RW_INTERLEAVED) < 0)
       return_error ("snd_pcm_hw_params_set_access", DEVICE_FORMAT);
+    ADEBUG ("PCM: %s: access: %s", alsadev_, *mmapp ? "MMAP_INTERLEAVED" : "RW_INTERLEAVED");
     if (snd_pcm_hw_params_set_format (phandle, hparams, SND_PCM_FORMAT_S16_LE) < 0)
       return_error ("snd_pcm_hw_params_set_format", DEVICE_FORMAT);
     // sample_rate
@@ -429,7 +497,7 @@ public:
     ADEBUG ("PCM: %s: period_size: %d (dir=%+d, min=%d max=%d)", alsadev_,
             period_size, dir, period_min, period_max);
     // fragment count
-    const uint want_nperiods = latency_ms == 0 ? 2 : CLAMP (latency_frames / period_size, 2, 1023) + 1;
+    const uint want_nperiods = want_periods_ ? want_periods_ : latency_ms == 0 ? 2 : CLAMP (latency_frames / period_size, 2, 1023) + 1;
     uint nperiods = want_nperiods;
     if (snd_pcm_hw_params_set_periods_near (phandle, hparams, &nperiods, nullptr) < 0)
       return_error ("snd_pcm_hw_params_set_periods", DEVICE_LATENCY);
@@ -502,16 +570,121 @@ public:
           {
             int n;
             do
-              n = snd_pcm_writei (write_handle_, zeros, period_size_);
+              n = write_mmap_ ? snd_pcm_mmap_writei (write_handle_, zeros, period_size_) :
+                  snd_pcm_writei (write_handle_, zeros, period_size_);
             while (n == -EAGAIN); // retry on signals
             // printerr ("%s: written=%d, left: %d / %d\n", __func__, n, snd_pcm_avail (write_handle_), n_periods_ * period_size_);
           }
       }
+    // start linked streams together, so capture and playback positions stay in lock step
+    if (linked_ && snd_pcm_state (write_handle_) == SND_PCM_STATE_PREPARED)
+      snd_pcm_start (write_handle_);
+    read_frames_ = 0;
+    write_frames_ = 0;
+    monitor_fresh_ = false;
+    int waiting = PROBE_WAITING;
+    probe_state_.compare_exchange_strong (waiting, PROBE_ARMED); // positions were reset, probe again
     snd_lib_error_set_handler (NULL);
   }
+  void
+  resize_buffer (uint n_periods)
+  {
+    snd_lib_error_set_handler (silent_error_handler);
+    if (read_handle_ && write_handle_)
+      snd_pcm_unlink (read_handle_);
+    want_periods_ = n_periods;
+    Error error = Error::NONE;
+    for (snd_pcm_t *phandle : { read_handle_, write_handle_ })
+      if (phandle && error == 0)
+        {
+          snd_pcm_drop (phandle);
+          snd_pcm_hw_free (phandle);
+          uint freq = mix_freq_, psize = period_size_;
+          bool *mmapp = phandle == read_handle_ ? &read_mmap_ : &write_mmap_;
+          error = alsa_device_setup (phandle, latency_ms_, &freq, &n_periods, &psize, mmapp);
+          if (error == 0 && (freq != mix_freq_ || psize != period_size_))
+            error = Error::DEVICES_MISMATCH;
+        }
+    if (read_handle_ && write_handle_)
+      snd_pcm_link (read_handle_, write_handle_);
+    snd_lib_error_set_handler (NULL);
+    if (error != 0)
+      info ("ALSA: %s: failed to resize buffer to %u periods: %s", alsadev_, want_periods_, bse_error_blurb (error));
+    else
+      n_periods_ = n_periods;
+    ADEBUG ("PCM: %s: n_periods=%u (xruns=%u)", alsadev_, n_periods_, uint64 (xruns_));
+    adjustments_ += 1;
+    stat_periods_ = n_periods_;
+    pcm_retrigger();
+  }
+  // grow the buffer after xruns, shrink it again after a long stretch without xruns
+  void
+  adapt_periods ()
+  {
+    const uint64 periods_per_second = mix_freq_ / period_size_;
+    if (max_periods_ <= min_periods_ || periods_since_adjustment_ < periods_per_second)
+      return;
+    const uint64 xruns = xruns_;
+    uint n_periods = n_periods_;
+    if (xruns > xruns_at_adjustment_)
+      n_periods = MIN (n_periods_ + 1, max_periods_);
+    else if (periods_since_adjustment_ >= 60 * periods_per_second)
+      n_periods = MAX (n_periods_ - 1, min_periods_);
+    else
+      return;
+    xruns_at_adjustment_ = xruns;
+    periods_since_adjustment_ = 0;
+    if (n_periods != n_periods_)
+      resize_buffer (n_periods);
+  }
+  virtual PcmDriverStats
+  pcm_stats () const override
+  {
+    PcmDriverStats stats;
+    stats.xruns = xruns_;
+    stats.adjustments = adjustments_;
+    stats.n_periods = stat_periods_;
+    stats.period_size = period_size_;
+    for (size_t i = 0; i < stats.jitter.size(); i++)
+      {
+        stats.jitter[i] = jitter_[i];
+        stats.lateness[i] = lateness_[i];
+      }
+    stats.roundtrip_frames = roundtrip_frames_;
+    return stats;
+  }
+  virtual bool
+  pcm_probe_roundtrip () override
+  {
+    return_unless (linked_, false);
+    roundtrip_frames_ = -1;
+    int idle = PROBE_IDLE;
+    probe_state_.compare_exchange_strong (idle, PROBE_ARMED);
+    return true;
+  }
+  // look for the probe impulse in the captured period `values`
+  void
+  probe_detect (const float *values)
+  {
+    for (size_t i = 0; i < period_size_ * n_channels_; i++)
+      if (fabsf (values[i]) > 0.25)
+        {
+          roundtrip_frames_ = read_frames_ + i / n_channels_ - probe_frame_;
+          probe_state_ = PROBE_IDLE;
+          info ("ALSA: %s: measured round-trip latency: %d frames (%.2fms)", alsadev_,
+                int64 (roundtrip_frames_), int64 (roundtrip_frames_) * 1000.0 / mix_freq_);
+          return;
+        }
+    if (read_frames_ > probe_frame_ + (n_periods_ + 1) * period_size_ + mix_freq_)
+      {
+        probe_state_ = PROBE_IDLE;
+        info ("ALSA: %s: round-trip probe timed out, is the output looped back into the input?", alsadev_);
+      }
+  }
   virtual bool
   pcm_check_io (long *timeoutp) override
   {
+    adapt_periods();
     if (0)
       {
         snd_pcm_state_t ws = SND_PCM_STATE_DISCONNECTED, rs = SND_PCM_STATE_DISCONNECTED;
@@ -535,6 +708,8 @@ public:
       }
     // quick check for data availability
     int n_frames_avail = snd_pcm_avail_update (read_handle_ ? read_handle_ : write_handle_);
+    if (n_frames_avail < 0)
+      xruns_ += 1;
     if (n_frames_avail < 0 ||   // error condition, probably an underrun (-EPIPE)
         (n_frames_avail == 0 && // check RUNNING state
          snd_pcm_state (read_handle_ ? read_handle_ : write_handle_) != SND_PCM_STATE_RUNNING))
@@ -548,7 +723,11 @@ public:
       }
     // check whether data can be processed
     if (n_frames_avail >= period_size_)
-      return true;      // need processing
+      {
+        const uint64 late_usecs = (n_frames_avail - period_size_) * uint64 (1000000) / mix_freq_;
+        lateness_[PcmDriverStats::histogram_bucket (late_usecs)] += 1;
+        return true;    // need processing
+      }
     // calculate timeout until processing is possible or needed
     const uint diff_frames = period_size_ - n_frames_avail;
     *timeoutp = diff_frames * 1000 / mix_freq_;
@@ -567,6 +746,32 @@ public:
     *rlatency = CLAMP (rdelay, 0, buffer_length);
     *wlatency = CLAMP (wdelay, 0, buffer_length);
   }
+  // convert up to `n_frames` from `src` into the hardware buffer or from it into `dest`
+  snd_pcm_sframes_t
+  mmap_transfer (snd_pcm_t *phandle, float *dest, const float *src, snd_pcm_uframes_t n_frames)
+  {
+    if (phandle == read_handle_ && snd_pcm_state (phandle) == SND_PCM_STATE_PREPARED)
+      snd_pcm_start (phandle);  // capture isn't started implicitly by mmap access
+    snd_pcm_sframes_t avail = snd_pcm_avail_update (phandle);
+    if (avail == 0)
+      {
+        const int aerror = snd_pcm_wait (phandle, 1000);
+        avail = aerror < 0 ? aerror : snd_pcm_avail_update (phandle);
+      }
+    if (avail <= 0)
+      return avail;
+    const snd_pcm_channel_area_t *areas = nullptr;
+    snd_pcm_uframes_t offset = 0, frames = MIN (n_frames, snd_pcm_uframes_t (avail));
+    const int aerror = snd_pcm_mmap_begin (phandle, &areas, &offset, &frames);
+    if (aerror < 0)
+      return aerror;
+    int16 *hwbuffer = (int16*) ((char*) areas[0].addr + (areas[0].first + offset * areas[0].step) / 8);
+    if (src)
+      alsa_s16_from_float (hwbuffer, src, frames * n_channels_);
+    else if (dest)
+      alsa_float_from_s16 (dest, hwbuffer, frames * n_channels_);
+    return snd_pcm_mmap_commit (phandle, offset, frames);
+  }
   virtual size_t
   pcm_read (size_t n, float *values) override
   {
@@ -576,12 +781,31 @@ public:
     const size_t n_values = n_left * n_channels_;
 
     read_write_count_ += 1;
-    do
+    while (read_mmap_ && n_left)
+      {
+        snd_pcm_sframes_t n_frames = mmap_transfer (read_handle_, dest, nullptr, n_left);
+        if (n_frames < 0) // errors during read, could be underrun (-EPIPE)
+          {
+            ADEBUG ("PCM: %s: mmap read error: %s", alsadev_, snd_strerror (n_frames));
+            xruns_ += 1;
+            snd_lib_error_set_handler (silent_error_handler);
+            snd_pcm_prepare (read_handle_);     // force retrigger
+            snd_lib_error_set_handler (NULL);
+            if (dest)
+              floatfill (dest, 0.f, n_left * n_channels_);
+            return n_values;
+          }
+        if (dest) // ignore dummy reads()
+          dest += n_frames * n_channels_;
+        n_left -= n_frames;
+      }
+    while (n_left)
       {
         ssize_t n_frames = snd_pcm_readi (read_handle_, period_buffer_, n_left);
         if (n_frames < 0) // errors during read, could be underrun (-EPIPE)
           {
             ADEBUG ("PCM: %s: read() error: %s", alsadev_, snd_strerror (n_frames));
+            xruns_ += 1;
             snd_lib_error_set_handler (silent_error_handler);
             snd_pcm_prepare (read_handle_);     // force retrigger
             snd_lib_error_set_handler (NULL);
@@ -596,24 +820,80 @@ public:
           }
         n_left -= n_frames;
       }
-    while (n_left);
-
+    if (values && probe_state_ == PROBE_WAITING)
+      probe_detect (values);
+    read_frames_ += period_size_;
+    if (values && monitor_level_ > 0)
+      {
+        if (values != monitor_buffer_.data())
+          floatcopy (monitor_buffer_.data(), values, n_values);
+        monitor_fresh_ = true;
+      }
     return n_values;
   }
   virtual void
   pcm_write (size_t n, const float *values) override
   {
     assert_return (n == period_size_ * n_channels_);
-    if (read_handle_ && read_write_count_ < 1)
+    if (read_handle_ && read_write_count_ < 1 && (monitor_level_ > 0 || probe_state_ != PROBE_IDLE))
+      pcm_read (n, monitor_buffer_.data());     // input is needed in this period, even without PCM input modules
+    else if (read_handle_ && read_write_count_ < 1)
       {
         snd_lib_error_set_handler (silent_error_handler); // silence ALSA about -EPIPE
         snd_pcm_forward (read_handle_, period_size_);
         snd_lib_error_set_handler (NULL);
         read_write_count_ += 1;
+        read_frames_ += period_size_;
       }
     read_write_count_ -= 1;
+    const uint64 now = timestamp_benchmark();
+    if (last_io_stamp_)
+      {
+        const int64 period_nsecs = period_size_ * int64 (1000000000) / mix_freq_;
+        const int64 jitter_nsecs = std::abs (int64 (now - last_io_stamp_) - period_nsecs);
+        jitter_[PcmDriverStats::histogram_bucket (jitter_nsecs / 1000)] += 1;
+      }
+    last_io_stamp_ = now;
+    periods_since_adjustment_ += 1;
     const float *floats = values;
+    if (monitor_fresh_)
+      {
+        // direct monitoring, captured input reaches the output in the same period
+        float *mix = mix_buffer_.data();
+        const float *input = monitor_buffer_.data();
+        const float level = monitor_level_;
+        for (size_t i = 0; i < n; i++)
+          mix[i] = values[i] + level * input[i];
+        floats = mix;
+        monitor_fresh_ = false;
+      }
+    if (probe_state_ == PROBE_ARMED)
+      {
+        // replace this period with a single impulse, detected again by probe_detect()
+        floatfill (mix_buffer_.data(), 0.f, n);
+        for (size_t c = 0; c < n_channels_; c++)
+          mix_buffer_[c] = 0.9;
+        floats = mix_buffer_.data();
+        probe_frame_ = write_frames_;
+        probe_state_ = PROBE_WAITING;
+      }
+    write_frames_ += period_size_;
     size_t n_left = period_size_;       // in frames
+    while (write_mmap_ && n_left)
+      {
+        const snd_pcm_sframes_t n = mmap_transfer (write_handle_, nullptr, floats, n_left);
+        if (n < 0)                      // errors during write, could be overrun (-EPIPE)
+          {
+            ADEBUG ("PCM: %s: mmap write error: %s", alsadev_, snd_strerror (n));
+            xruns_ += 1;
+            snd_lib_error_set_handler (silent_error_handler);
+            snd_pcm_prepare (write_handle_);    // force retrigger
+            snd_lib_error_set_handler (NULL);
+            return;
+          }
+        floats += n * n_channels_;
+        n_left -= n;
+      }
     while (n_left)
       {
         gsl_conv_from_float_clip (GSL_WAVE_FORMAT_SIGNED_16, G_BYTE_ORDER, floats, period_buffer_, n_left * n_channels_);
@@ -623,6 +903,7 @@ public:
         if (n < 0)                      // errors during write, could be overrun (-EPIPE)
           {
             ADEBUG ("PCM: %s: write() error: %s", alsadev_, snd_strerror (n));
+            xruns_ += 1;
             snd_lib_error_set_handler (silent_error_handler);
             snd_pcm_prepare (write_handle_);    // force retrigger
             snd_lib_error_set_handler (NULL);
@@ -1298,8 +1579,12 @@ public:
     if (r < 0 && r != -EAGAIN) // -ENOSPC - sequencer FIFO overran
       ADEBUG ("SeqMIDI: %s: snd_seq_event_input: %s", devid_, snd_strerror (r));
     if (BSE_UNLIKELY (mdebug_))
-      for (size_t i = old_size; i < estream.size(); i++)
-        MDEBUG ("%s", (estream.begin() + i)->to_string());
+      {
+        auto it = estream.begin();
+        std::advance (it, old_size);
+        for (; it != estream.end(); ++it)
+          MDEBUG ("%s", it->to_string());
+      }
     if (must_sort)              // guard against devices with out-of-order events
       estream.ensure_order();
     return estream.size() - old_size;
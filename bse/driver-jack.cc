@@ -1,11 +1,13 @@
 // This Source Code Form is licensed MPL-2.0: http://mozilla.org/MPL/2.0
 #include "driver.hh"
 #include "bseengine.hh"
+#include "bseenginemaster.hh"
 #include "internal.hh"
 #include "gsldatautils.hh"
 #include "bseblockutils.hh"
 
 #include <unistd.h>
+#include <condition_variable>
 
 #define JDEBUG(...)     Bse::debug ("jack", __VA_ARGS__)
 
@@ -71,6 +73,13 @@ This avoids latency and buffering. However this may pose stricter RT
 requirements onto BEAST. So whether it runs as dropout-free as the current
 version would remain to be seen. A not so realtime version would buffer
 M complete blocks of N samples, still avoiding partially filled buffers.
+
+The synchronous variant is implemented as a secondary device per JACK
+device, selected via a ":sync" suffix on the device id, e.g. "jack=system:sync".
+It requires the JACK period to be an integer multiple of the engine block
+size and falls back to writing zeros (counted as xrun) if the engine misses
+a deadline of 75% of the JACK period. Server.pcm_stats() reports the
+resulting latency next to the latency of the buffered variant.
 ------------------------------------------------------------------------*/
 
 /**
@@ -444,6 +453,13 @@ list_jack_drivers (Driver::EntryVec &entries)
             entry.notice = "Note: JACK adds latency compared to direct hardware access";
           entry.priority = Driver::JACK;
           entries.push_back (entry);
+          Driver::Entry sentry = entry;
+          sentry.devid = devid + ":sync";
+          sentry.device_name += " (Synchronous)";
+          sentry.device_info = "Routing via the JACK Audio Connection Kit, rendering within the JACK process callback";
+          sentry.notice = "Note: Requires a JACK period that is a multiple of the engine block size";
+          sentry.priority = Driver::JACK + Driver::WSUB;
+          entries.push_back (sentry);
         }
     }
 }
@@ -478,6 +494,52 @@ class JackPcmDriver : public PcmDriver {
   uint64                        device_write_counter_ = 0;
   int                           device_open_counter_ = 0;
 
+  // synchronous mode, the JACK thread waits for the engine to render into the port buffers
+  const String                  jackdev_;
+  const bool                    sync_mode_ = false;
+  std::mutex                    sync_mutex_;
+  std::condition_variable       sync_cond_;
+  std::vector<const float*>     sync_inputs_;   // JACK port buffers of the current cycle
+  std::vector<float*>           sync_outputs_;
+  uint                          sync_frames_ = 0;
+  uint                          sync_pos_ = 0;  // frames rendered by the engine
+  uint64                        sync_cycles_ = 0;
+  uint64                        sync_wait_total_ = 0;
+  uint64                        sync_wait_max_ = 0;
+  uint                          sync_buffered_frames_ = 0;      // ringbuffer size the buffered mode would use
+
+  int
+  process_sync (jack_nframes_t n_frames, const float **in_values, float **out_values)
+  {
+    if (!atomic_active_ || n_frames % block_length_)
+      {
+        for (uint ch = 0; ch < n_channels_; ch++)
+          Block::fill (n_frames, out_values[ch], 0.0);
+        return 0;
+      }
+    const uint64 start = timestamp_benchmark();
+    std::unique_lock<std::mutex> lock (sync_mutex_);
+    std::copy (in_values, in_values + n_channels_, sync_inputs_.begin());
+    std::copy (out_values, out_values + n_channels_, sync_outputs_.begin());
+    sync_frames_ = n_frames;
+    sync_pos_ = 0;
+    MasterThread::wakeup();
+    // leave a quarter of the period for JACK to deliver the port buffers and run other clients
+    const auto deadline = std::chrono::microseconds (uint64 (n_frames) * 750000 / mix_freq_);
+    if (!sync_cond_.wait_for (lock, deadline, [this] { return sync_pos_ >= sync_frames_; }))
+      {
+        atomic_xruns_++;
+        for (uint ch = 0; ch < n_channels_; ch++)
+          Block::fill (n_frames - sync_pos_, out_values[ch] + sync_pos_, 0.0);
+      }
+    sync_frames_ = 0;   // port buffers become invalid after returning
+    sync_pos_ = 0;
+    const uint64 elapsed = timestamp_benchmark() - start;
+    sync_cycles_ += 1;
+    sync_wait_total_ += elapsed;
+    sync_wait_max_ = std::max (sync_wait_max_, elapsed);
+    return 0;
+  }
   int
   process_callback (jack_nframes_t n_frames)
   {
@@ -493,6 +555,8 @@ class JackPcmDriver : public PcmDriver {
         out_values[ch] = (float *) jack_port_get_buffer (output_ports_[ch], n_frames);
       }
 
+    if (sync_mode_)
+      return process_sync (n_frames, in_values, out_values);
     if (!atomic_active_)
       {
         for (auto values : out_values)
@@ -570,8 +634,45 @@ class JackPcmDriver : public PcmDriver {
   {
     is_down_ = true;
   }
+  uint
+  ringbuffer_frames (const PcmDriverConfig &config) const
+  {
+    // keep at least two jack callback sizes for dropout free audio
+    uint min_buffer_frames = jack_get_buffer_size (jack_client_) * 2;
+
+    // keep an extra engine buffer size (this compensates also for cases where the
+    // engine buffer size is not a 2^N value, which would otherwise cause the
+    // buffer never to be fully filled with 2 periods of data)
+    min_buffer_frames += config.block_length;
+
+    // honor the user defined latency specification
+    //
+    // the user defined latency is only used to adjust our local buffering
+    // -> it doesn't take into account latencies outside beast, such as the buffering
+    //    jack does, or latencies added by other clients)
+    uint user_buffer_frames = config.latency_ms * config.mix_freq / 1000;
+    return std::max (min_buffer_frames, user_buffer_frames);
+  }
+  jack_nframes_t
+  port_latency (const vector<jack_port_t*> &ports, jack_latency_callback_mode_t mode) const
+  {
+    jack_nframes_t latency = 0;
+    for (auto port : ports)
+      {
+        jack_latency_range_t lrange;
+        jack_port_get_latency_range (port, mode, &lrange);
+
+        latency = std::max (latency, lrange.max);
+      }
+    return latency;
+  }
 public:
-  explicit      JackPcmDriver (const String &devid) : PcmDriver (devid) {}
+  explicit
+  JackPcmDriver (const String &devid) :
+    PcmDriver (devid),
+    jackdev_ (string_endswith (devid, ":sync") ? devid.substr (0, devid.size() - 5) : devid),
+    sync_mode_ (jackdev_ != devid)
+  {}
   static PcmDriverP
   create (const String &devid)
   {
@@ -599,6 +700,9 @@ public:
     assert_return (opened());
     disconnect_jack (jack_client_);
     jack_client_ = nullptr;
+    if (sync_mode_ && sync_cycles_)
+      JDEBUG ("%s: synchronous cycles=%u: average callback wait=%.3fms max=%.3fms xruns=%d", devid_, sync_cycles_,
+              sync_wait_total_ / 1000000.0 / sync_cycles_, sync_wait_max_ / 1000000.0, int (atomic_xruns_));
   }
   virtual Error
   open (IODir iodir, const PcmDriverConfig &config) override
@@ -642,25 +746,24 @@ public:
           error = Bse::Error::FILE_OPEN_FAILED;
       }
 
+    /* synchronous mode renders directly into the JACK port buffers */
+    if (error == 0 && sync_mode_)
+      {
+        sync_buffered_frames_ = ringbuffer_frames (config);
+        const uint jack_frames = jack_get_buffer_size (jack_client_);
+        if (jack_frames % block_length_)
+          {
+            JDEBUG ("%s: JACK period %u is not a multiple of the block length %u", devid_, jack_frames, block_length_);
+            error = Bse::Error::DEVICE_LATENCY;
+          }
+        sync_inputs_.resize (n_channels_);
+        sync_outputs_.resize (n_channels_);
+        buffer_frames_ = 0;
+      }
     /* initialize ring buffers */
-    if (error == 0)
+    if (error == 0 && !sync_mode_)
       {
-        // keep at least two jack callback sizes for dropout free audio
-        uint min_buffer_frames = jack_get_buffer_size (jack_client_) * 2;
-
-        // keep an extra engine buffer size (this compensates also for cases where the
-        // engine buffer size is not a 2^N value, which would otherwise cause the
-        // buffer never to be fully filled with 2 periods of data)
-        min_buffer_frames += config.block_length;
-
-        // honor the user defined latency specification
-        //
-        // the user defined latency is only used to adjust our local buffering
-        // -> it doesn't take into account latencies outside beast, such as the buffering
-        //    jack does, or latencies added by other clients)
-        uint user_buffer_frames = config.latency_ms * config.mix_freq / 1000;
-        uint buffer_frames = std::max (min_buffer_frames, user_buffer_frames);
-
+        const uint buffer_frames = ringbuffer_frames (config);
         input_ringbuffer_.resize (buffer_frames, n_channels_);
         output_ringbuffer_.resize (buffer_frames, n_channels_);
         buffer_frames_  = output_ringbuffer_.get_writable_frames();
@@ -710,7 +813,7 @@ public:
         std::map<std::string, DeviceDetails> devices = query_jack_devices (jack_client_);
         std::map<std::string, DeviceDetails>::const_iterator di;
 
-        di = devices.find (devid_);
+        di = devices.find (jackdev_);
         if (di != devices.end())
           {
             const DeviceDetails &details = di->second;
@@ -772,6 +875,16 @@ public:
     /* enable processing in callback (if not already active) */
     atomic_active_ = 1;
 
+    if (sync_mode_)
+      {
+        std::lock_guard<std::mutex> locker (sync_mutex_);
+        if (sync_pos_ + block_length_ <= sync_frames_)
+          return true;    /* JACK thread waits for the next block */
+        /* woken up by MasterThread::wakeup() from the next JACK cycle */
+        *timeoutp = std::max<int> (jack_get_buffer_size (jack_client_) * 1000 / mix_freq_, 1);
+        return false;
+      }
+
     /* report jack driver xruns */
     if (atomic_xruns_ != printed_xruns_)
       {
@@ -805,23 +918,8 @@ public:
   {
     assert_return (jack_client_ != NULL);
 
-    jack_nframes_t jack_rlatency = 0;
-    for (auto port : input_ports_)
-      {
-        jack_latency_range_t in_lrange;
-        jack_port_get_latency_range (port, JackCaptureLatency, &in_lrange);
-
-        jack_rlatency = std::max (jack_rlatency, in_lrange.max);
-      }
-
-    jack_nframes_t jack_wlatency = 0;
-    for (auto port : output_ports_)
-      {
-        jack_latency_range_t out_lrange;
-        jack_port_get_latency_range (port, JackPlaybackLatency, &out_lrange);
-
-        jack_wlatency = std::max (jack_wlatency, out_lrange.max);
-      }
+    const jack_nframes_t jack_rlatency = port_latency (input_ports_, JackCaptureLatency);
+    const jack_nframes_t jack_wlatency = port_latency (output_ports_, JackPlaybackLatency);
 
     uint total_latency = buffer_frames_ + jack_rlatency + jack_wlatency;
     JDEBUG ("%s: jack_rlatency=%.3f ms jack_wlatency=%.3f ms ringbuffer=%.3f ms total_latency=%.3f ms",
@@ -837,6 +935,19 @@ public:
     *rlatency = jack_rlatency;
     *wlatency = jack_wlatency + buffer_frames_;
   }
+  virtual PcmDriverStats
+  pcm_stats () const override
+  {
+    PcmDriverStats stats;
+    return_unless (jack_client_ != nullptr, stats);
+    stats.xruns = atomic_xruns_;
+    stats.period_size = jack_get_buffer_size (jack_client_);
+    const jack_nframes_t jack_latency = port_latency (input_ports_, JackCaptureLatency) +
+                                        port_latency (output_ports_, JackPlaybackLatency);
+    stats.latency_frames = jack_latency + buffer_frames_;
+    stats.buffered_latency_frames = jack_latency + (sync_mode_ ? sync_buffered_frames_ : buffer_frames_);
+    return stats;
+  }
   virtual size_t
   pcm_read (size_t n, float *values) override
   {
@@ -845,6 +956,16 @@ public:
 
     device_read_counter_++;  // read must always gets called before write (see jack_device_write)
 
+    if (sync_mode_)
+      {
+        std::lock_guard<std::mutex> locker (sync_mutex_);
+        const bool valid = sync_pos_ + block_length_ <= sync_frames_;
+        for (uint ch = 0; ch < n_channels_; ch++)
+          for (uint i = 0; i < block_length_; i++)
+            values[ch + i * n_channels_] = valid ? sync_inputs_[ch][sync_pos_ + i] : 0.0;
+        return block_length_ * n_channels_;
+      }
+
     float deinterleaved_frame_data[block_length_ * n_channels_];
     float *deinterleaved_frames[n_channels_];
     for (uint ch = 0; ch < n_channels_; ch++)
@@ -888,6 +1009,23 @@ public:
         assert_return (device_read_counter_ == device_write_counter_);
       }
 
+    if (sync_mode_)
+      {
+        std::lock_guard<std::mutex> locker (sync_mutex_);
+        if (sync_pos_ + block_length_ > sync_frames_)
+          return;       // JACK cycle timed out, block is late
+        for (uint ch = 0; ch < n_channels_; ch++)
+          {
+            float *channel_data = sync_outputs_[ch] + sync_pos_;
+            for (uint i = 0; i < block_length_; i++)
+              channel_data[i] = values[ch + i * n_channels_];
+          }
+        sync_pos_ += block_length_;
+        if (sync_pos_ >= sync_frames_)
+          sync_cond_.notify_one();
+        return;
+      }
+
     // deinterleave
     float deinterleaved_frame_data[block_length_ * n_channels_];
     const float *deinterleaved_frames[n_channels_];
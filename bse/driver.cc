@@ -4,6 +4,7 @@
 #include "bsesequencer.hh"
 #include "path.hh"
 #include "internal.hh"
+#include <time.h>
 
 #define DDEBUG(...)     Bse::debug ("driver", __VA_ARGS__)
 
@@ -136,6 +137,31 @@ PcmDriver::register_driver (const String &driverid,
   return RegisteredDriver<PcmDriverP>::register_driver (driverid, create, list);
 }
 
+/// Retrieve xrun and timing statistics of an opened driver, MT-Safe.
+PcmDriverStats
+PcmDriver::pcm_stats () const
+{
+  return PcmDriverStats();
+}
+
+/// Emit a test impulse and measure its round-trip through a loopback connection, MT-Safe.
+/// Returns false if the driver cannot measure, the result is reported via pcm_stats().
+bool
+PcmDriver::pcm_probe_roundtrip ()
+{
+  return false;
+}
+
+/// Histogram bucket for an interval of `usecs`, see PcmDriverStats::HISTOGRAM_BUCKETS.
+uint
+PcmDriverStats::histogram_bucket (uint64 usecs)
+{
+  uint bucket = 0;
+  for (uint64 bound = 250; usecs >= bound && bucket + 1 < HISTOGRAM_BUCKETS; bound <<= 1)
+    bucket++;
+  return bucket;
+}
+
 Driver::EntryVec
 PcmDriver::list_drivers ()
 {
@@ -304,6 +330,204 @@ public:
 
 static const String null_pcm_driverid = PcmDriver::register_driver ("null", NullPcmDriver::create, NullPcmDriver::list_drivers);
 
+// == SimClockPcmDriver ==
+/* Simulates a sound card that consumes one period per period duration from a buffer of n_periods,
+ * pacing the engine with clock_nanosleep(). Writes after a period's playback deadline count as xruns.
+ * Options are given as devid, e.g. "simclock=stall=5,every=100,report=/tmp/margins.txt" injects a
+ * 5ms busy loop every 100 periods and writes the deadline margin of every period into a report.
+ */
+class SimClockPcmDriver : public PcmDriver {
+  static constexpr size_t MAX_REPORT_PERIODS = 1024 * 1024;
+  uint          n_channels_ = 0;
+  uint          mix_freq_ = 0;
+  uint          block_size_ = 0;
+  uint          n_periods_ = 0;
+  uint64        period_nsecs_ = 0;
+  uint64        start_nsecs_ = 0;       // simulated hardware start
+  uint64        n_written_ = 0;         // periods written since start
+  uint64        n_total_ = 0;
+  uint64        last_write_ = 0;
+  uint          stall_msecs_ = 0;
+  uint          stall_every_ = 0;
+  String        report_file_;
+  std::vector<int32> margins_;          // deadline margin per period in µs, negative for xruns
+  std::atomic<uint64> xruns_ { 0 };
+  std::array<std::atomic<uint64>, PcmDriverStats::HISTOGRAM_BUCKETS> jitter_ {};
+  std::array<std::atomic<uint64>, PcmDriverStats::HISTOGRAM_BUCKETS> lateness_ {};
+  static uint64
+  now_nsecs ()
+  {
+    struct timespec ts;
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * uint64 (1000000000) + ts.tv_nsec;
+  }
+  uint64 wakeup_nsecs  () const { return start_nsecs_ + (n_written_ + 1) * period_nsecs_; }
+  uint64 deadline_nsecs () const { return start_nsecs_ + (n_written_ + n_periods_) * period_nsecs_; }
+public:
+  explicit      SimClockPcmDriver (const String &devid) : PcmDriver (devid) {}
+  static PcmDriverP
+  create (const String &devid)
+  {
+    auto pdriverp = std::make_shared<SimClockPcmDriver> (devid);
+    return pdriverp;
+  }
+  virtual float
+  pcm_frequency () const override
+  {
+    return mix_freq_;
+  }
+  virtual uint
+  block_length () const override
+  {
+    return block_size_;
+  }
+  virtual void
+  close () override
+  {
+    assert_return (opened());
+    int64 sum = 0, worst = margins_.empty() ? 0 : margins_[0];
+    for (auto m : margins_)
+      {
+        sum += m;
+        worst = std::min (worst, int64 (m));
+      }
+    const String summary = string_format ("SIMCLOCK-PCM: periods=%u period=%u n_periods=%u xruns=%u margin_avg=%dus margin_min=%dus",
+                                          n_total_, block_size_, n_periods_, uint64 (xruns_),
+                                          margins_.empty() ? 0 : sum / int64 (margins_.size()), worst);
+    DDEBUG ("%s", summary);
+    if (!report_file_.empty())
+      {
+        String report = "# " + summary + "\n# period margin_us\n";
+        for (size_t i = 0; i < margins_.size(); i++)
+          report += string_format ("%u %d\n", i, margins_[i]);
+        if (!Path::stringwrite (report_file_, report))
+          DDEBUG ("SIMCLOCK-PCM: %s: failed to write report: %s", report_file_, strerror (errno));
+      }
+    flags_ &= ~size_t (Flags::OPENED | Flags::READABLE | Flags::WRITABLE);
+  }
+  virtual Error
+  open (IODir iodir, const PcmDriverConfig &config) override
+  {
+    assert_return (!opened(), Error::INTERNAL);
+    for (const String &option : string_split (devid_, ","))
+      if (kvpair_key (option) == "stall")
+        stall_msecs_ = string_to_int (kvpair_value (option));
+      else if (kvpair_key (option) == "every")
+        stall_every_ = string_to_int (kvpair_value (option));
+      else if (kvpair_key (option) == "report")
+        report_file_ = kvpair_value (option);
+    const bool require_readable = iodir == READONLY || iodir == READWRITE;
+    const bool require_writable = iodir == WRITEONLY || iodir == READWRITE;
+    flags_ |= Flags::READABLE * require_readable;
+    flags_ |= Flags::WRITABLE * require_writable;
+    n_channels_ = config.n_channels;
+    mix_freq_ = config.mix_freq;
+    block_size_ = config.block_length;
+    // same buffer layout as the ALSA driver, 1 playing, 1 extra and 1 unfilled period at least
+    const uint latency_frames = mix_freq_ * config.latency_ms / 1000;
+    n_periods_ = config.latency_ms == 0 ? 2 : CLAMP (latency_frames / block_size_, 2, 1023) + 1;
+    period_nsecs_ = block_size_ * uint64 (1000000000) / mix_freq_;
+    start_nsecs_ = 0;
+    n_written_ = 0;
+    n_total_ = 0;
+    last_write_ = 0;
+    margins_.clear();
+    margins_.reserve (MAX_REPORT_PERIODS);     // 4MB, pcm_write() must not reallocate
+    flags_ |= Flags::OPENED;
+    DDEBUG ("SIMCLOCK-PCM: opening with freq=%f channels=%d period=%u n_periods=%u stall=%ums every=%u",
+            mix_freq_, n_channels_, block_size_, n_periods_, stall_msecs_, stall_every_);
+    return Error::NONE;
+  }
+  virtual bool
+  pcm_check_io (long *timeoutp) override
+  {
+    if (!start_nsecs_)
+      start_nsecs_ = now_nsecs();       // buffer starts out with n_periods of silence
+    // block until the simulated hardware has consumed the next period
+    const uint64 wakeup = wakeup_nsecs();
+    struct timespec ts = { time_t (wakeup / 1000000000), long (wakeup % 1000000000) };
+    while (clock_nanosleep (CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+      ;
+    const uint64 late_usecs = (now_nsecs() - wakeup) / 1000;
+    lateness_[PcmDriverStats::histogram_bucket (late_usecs)] += 1;
+    return true;
+  }
+  virtual void
+  pcm_latency (uint *rlatency, uint *wlatency) const override
+  {
+    *rlatency = block_size_;
+    *wlatency = n_periods_ * block_size_;
+  }
+  virtual size_t
+  pcm_read (size_t n, float *values) override
+  {
+    if (values)
+      floatfill (values, 0.0, n);
+    return n;
+  }
+  virtual void
+  pcm_write (size_t n, const float *values) override
+  {
+    n_total_ += 1;
+    if (stall_msecs_ && stall_every_ && n_total_ % stall_every_ == 0)
+      {
+        const uint64 busy_until = now_nsecs() + stall_msecs_ * uint64 (1000000);
+        while (now_nsecs() < busy_until)
+          ; // synthetic CPU stall
+      }
+    const uint64 now = now_nsecs();
+    if (last_write_)
+      {
+        const int64 jitter_nsecs = std::abs (int64 (now - last_write_) - int64 (period_nsecs_));
+        jitter_[PcmDriverStats::histogram_bucket (jitter_nsecs / 1000)] += 1;
+      }
+    last_write_ = now;
+    if (!start_nsecs_)
+      start_nsecs_ = now;
+    const int64 margin_usecs = (int64 (deadline_nsecs()) - int64 (now)) / 1000;
+    if (margins_.size() < margins_.capacity())
+      margins_.push_back (margin_usecs);
+    if (margin_usecs < 0)
+      {
+        // underrun, the simulated hardware restarts with a silence filled buffer
+        xruns_ += 1;
+        start_nsecs_ = now;
+        n_written_ = 0;
+      }
+    else
+      n_written_ += 1;
+  }
+  virtual PcmDriverStats
+  pcm_stats () const override
+  {
+    PcmDriverStats stats;
+    stats.xruns = xruns_;
+    stats.n_periods = n_periods_;
+    stats.period_size = block_size_;
+    for (size_t i = 0; i < stats.jitter.size(); i++)
+      {
+        stats.jitter[i] = jitter_[i];
+        stats.lateness[i] = lateness_[i];
+      }
+    return stats;
+  }
+  static void
+  list_drivers (Driver::EntryVec &entries)
+  {
+    Driver::Entry entry;
+    entry.devid = ""; // "simclock"
+    entry.device_name = "Simulated Clock PCM Driver";
+    entry.device_info = _("Discard all PCM output at the pace of a sound card and report deadline margins");
+    entry.notice = "Note: Intended for headless latency and jitter benchmarks";
+    entry.readonly = false;
+    entry.writeonly = false;
+    entry.priority = Driver::PSEUDO;
+    entries.push_back (entry);
+  }
+};
+
+static const String simclock_pcm_driverid = PcmDriver::register_driver ("simclock", SimClockPcmDriver::create, SimClockPcmDriver::list_drivers);
+
 // == NullMidiDriver ==
 class NullMidiDriver : public MidiDriver {
 public:
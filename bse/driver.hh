@@ -4,6 +4,7 @@
 
 #include <bse/midievent.hh>
 #include <functional>
+#include <array>
 
 namespace Bse {
 
@@ -65,7 +66,23 @@ struct PcmDriverConfig {
   uint n_channels = 0;
   uint mix_freq = 0;
   uint latency_ms = 0;
+  uint max_latency_ms = 0;      ///< Allow the driver to grow its buffer up to this latency after xruns.
   uint block_length = 0;
+  float monitor_level = 0;      ///< Gain for mixing captured input directly into the output of the same period.
+};
+
+struct PcmDriverStats {
+  static constexpr uint HISTOGRAM_BUCKETS = 8;  ///< Bucket n counts values below 2^n * 250µs, the last bucket all others.
+  uint64 xruns = 0;
+  uint64 adjustments = 0;       ///< Number of buffer size changes due to xruns or stable operation.
+  uint   n_periods = 0;
+  uint   period_size = 0;
+  std::array<uint64,HISTOGRAM_BUCKETS> jitter {};       ///< Deviation of the IO interval from the period duration.
+  std::array<uint64,HISTOGRAM_BUCKETS> lateness {};     ///< Delay of the IO after a period became available.
+  int64  roundtrip_frames = -1; ///< Measured input to output latency, -1 if unknown.
+  int64  latency_frames = -1;   ///< Reported input to output latency of the device configuration, -1 if unknown.
+  int64  buffered_latency_frames = -1;  ///< Latency_frames the device would have with driver side buffering, -1 if unknown.
+  static uint histogram_bucket (uint64 usecs);
 };
 
 class PcmDriver : public Driver {
@@ -81,6 +98,8 @@ public:
   virtual uint       block_length    () const = 0;
   virtual size_t     pcm_read        (size_t n, float *values) = 0;
   virtual void       pcm_write       (size_t n, const float *values) = 0;
+  virtual PcmDriverStats pcm_stats   () const;
+  virtual bool       pcm_probe_roundtrip ();
   static EntryVec    list_drivers    ();
   static String      register_driver (const String &driverid,
                                       const std::function<PcmDriverP (const String&)> &create,
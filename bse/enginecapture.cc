@@ -0,0 +1,289 @@
+// Licensed GNU LGPL v2.1 or later: http://www.gnu.org/licenses/lgpl.html
+#include "enginecapture.hh"
+#include "bseengine.hh"
+#include "path.hh"
+#include "internal.hh"
+#include <condition_variable>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define CDEBUG(...)     Bse::debug ("capture", __VA_ARGS__)
+
+namespace Bse {
+namespace EngineCapture {
+
+static_assert (sizeof (Record) == 40);
+static_assert (sizeof (Header) == 40);
+
+#define CAPTURE_FLUSH_MS        (50)    // interval for writing pending records
+#define CAPTURE_BUFFER_RECORDS  (65536) // records per buffer, 1.3 seconds of 50 records per millisecond
+
+std::atomic<bool> capture_active { false };
+static __thread Origin tls_origin = Origin::API;
+
+struct Capture {
+  int                     fd = -1;
+  Header                  header;
+  // double buffer, record() fills buffers[filling] while the capture thread writes out the other one
+  Record                 *buffers[2] = { nullptr, nullptr };
+  size_t                  filling = 0;  // protected by capture_spinlock
+  size_t                  n_filled = 0; // protected by capture_spinlock
+  uint64                  n_dropped = 0; // protected by capture_spinlock
+  std::mutex              mutex;        // protects quit, cond
+  std::condition_variable cond;
+  bool                    quit = false;
+  std::thread             thread;
+  bool                    broken = false;
+};
+static Spinlock capture_spinlock;       // protects capture and the Capture fill state
+static Capture *capture = nullptr;      // owned by UserThread
+
+// called by the capture thread only, so the buffer handed out here is written before the next swap
+static void
+capture_flush (Capture &cap)
+{
+  capture_spinlock.lock();
+  const Record *records = cap.buffers[cap.filling];
+  const size_t n_records = cap.n_filled;
+  cap.filling = !cap.filling;
+  cap.n_filled = 0;
+  cap.header.n_dropped = cap.n_dropped;
+  capture_spinlock.unlock();
+  const size_t length = n_records * sizeof (records[0]);
+  if (length && !cap.broken)
+    {
+      const ssize_t l = write (cap.fd, records, length);
+      if (l != ssize_t (length))
+        {
+          cap.broken = true;
+          CDEBUG ("failed to write capture: %s", strerror (errno));
+        }
+      else
+        cap.header.n_records += n_records;
+    }
+}
+
+static void
+capture_thread (Capture *cap)
+{
+  this_thread_set_name ("EngineCapture");
+  std::unique_lock<std::mutex> lock (cap->mutex);
+  for (;;)
+    {
+      const bool quit = cap->quit;
+      lock.unlock();
+      capture_flush (*cap);
+      lock.lock();
+      if (quit)
+        break;
+      cap->cond.wait_for (lock, std::chrono::milliseconds (CAPTURE_FLUSH_MS));
+    }
+}
+
+/// Start recording engine blocks, transactions, parameter changes and MIDI input into `filename`.
+bool
+start (const String &filename)
+{
+  return_unless (!capture, false);
+  const int fd = open (filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY | O_CLOEXEC, 0644);
+  if (fd < 0)
+    {
+      CDEBUG ("%s: failed to open: %s", filename, strerror (errno));
+      return false;
+    }
+  Capture *cap = new Capture();
+  cap->fd = fd;
+  cap->header.sample_rate = bse_engine_sample_freq();
+  cap->header.block_size = bse_engine_block_size();
+  cap->header.start_stamp = Bse::TickStamp::current();
+  cap->buffers[0] = new Record[CAPTURE_BUFFER_RECORDS];
+  cap->buffers[1] = new Record[CAPTURE_BUFFER_RECORDS];
+  if (write (fd, &cap->header, sizeof (cap->header)) != sizeof (cap->header))
+    {
+      CDEBUG ("%s: failed to write: %s", filename, strerror (errno));
+      ::close (fd);
+      delete[] cap->buffers[0];
+      delete[] cap->buffers[1];
+      delete cap;
+      return false;
+    }
+  cap->thread = std::thread (capture_thread, cap);
+  capture_spinlock.lock();
+  capture = cap;
+  capture_spinlock.unlock();
+  capture_active = true;
+  CDEBUG ("%s: capturing from stamp %u", filename, cap->header.start_stamp);
+  return true;
+}
+
+/// Stop a capture started with start() and complete the capture file.
+void
+stop ()
+{
+  return_unless (capture);
+  capture_active = false;
+  Capture *cap = capture;
+  capture_spinlock.lock();
+  capture = nullptr;            // no record() calls may access cap after this
+  capture_spinlock.unlock();
+  cap->mutex.lock();
+  cap->quit = true;
+  cap->cond.notify_all();
+  cap->mutex.unlock();
+  cap->thread.join();
+  capture_flush (*cap);         // records queued after the last flush
+  if (!cap->broken && (lseek (cap->fd, 0, SEEK_SET) != 0 ||
+                       write (cap->fd, &cap->header, sizeof (cap->header)) != sizeof (cap->header)))
+    cap->broken = true;
+  ::close (cap->fd);
+  if (cap->broken)
+    info ("EngineCapture: failed to write capture file: %s", strerror (errno));
+  if (cap->header.n_dropped)
+    info ("EngineCapture: %u records dropped, capture buffer exhausted", cap->header.n_dropped);
+  CDEBUG ("stopped after %u records", cap->header.n_records);
+  delete[] cap->buffers[0];
+  delete[] cap->buffers[1];
+  delete cap;
+}
+
+/// Queue `rec` for the capture file, `rec.stamp` is an absolute tick stamp, MT-Safe.
+/// Records are dropped and counted in Header.n_dropped if the capture thread falls behind, this never allocates.
+void
+record (Record rec)
+{
+  capture_spinlock.lock();
+  Capture *cap = capture;
+  if (cap && cap->n_filled < CAPTURE_BUFFER_RECORDS)
+    {
+      rec.stamp = rec.stamp >= cap->header.start_stamp ? rec.stamp - cap->header.start_stamp : 0;
+      cap->buffers[cap->filling][cap->n_filled++] = rec;
+    }
+  else if (cap)
+    cap->n_dropped++;
+  capture_spinlock.unlock();
+}
+
+/// Retrieve the Origin of records issued by the current thread.
+Origin
+origin ()
+{
+  return tls_origin;
+}
+
+PlaybackScope::PlaybackScope () :
+  saved_ (tls_origin)
+{
+  tls_origin = Origin::PLAYBACK;
+}
+
+PlaybackScope::~PlaybackScope ()
+{
+  tls_origin = saved_;
+}
+
+/// Read the `header` and all `records` from a capture file.
+bool
+read (const String &filename, Header &header, std::vector<Record> &records)
+{
+  const String data = Path::stringread (filename);
+  const Header defaults;
+  return_unless (data.size() >= sizeof (Header), false);
+  memcpy (&header, data.data(), sizeof (Header));
+  return_unless (memcmp (header.magic, defaults.magic, sizeof (header.magic)) == 0, false);
+  const size_t n_records = (data.size() - sizeof (Header)) / sizeof (Record);
+  records.resize (n_records);
+  memcpy (records.data(), data.data() + sizeof (Header), n_records * sizeof (Record));
+  return true;
+}
+
+} // EngineCapture
+} // Bse
+
+#include "testing.hh"
+
+namespace { // Anon
+using namespace Bse;
+
+BSE_INTEGRITY_TEST (bse_engine_capture_records);
+static void
+bse_engine_capture_records ()
+{
+  const String filename = Path::join (Path::cache_home(), string_format ("bse-capture-test-%u.dat", getpid()));
+  Path::mkdirs (Path::dirname (filename));
+  TASSERT (EngineCapture::active() == false);
+  TASSERT (EngineCapture::start (filename));
+  TASSERT (EngineCapture::active() == true);
+  const uint64 start = Bse::TickStamp::current();
+  for (uint i = 0; i < 1000; i++)
+    {
+      EngineCapture::Record rec;
+      rec.kind = EngineCapture::Kind::BLOCK;
+      rec.id32 = 128;
+      rec.stamp = start + i * 128;
+      rec.value = i;
+      EngineCapture::record (rec);
+    }
+  EngineCapture::stop();
+  TASSERT (EngineCapture::active() == false);
+  EngineCapture::Header header;
+  std::vector<EngineCapture::Record> records;
+  TASSERT (EngineCapture::read (filename, header, records));
+  unlink (filename.c_str());
+  TCMP (header.n_records, ==, 1000);
+  TCMP (records.size(), ==, 1000);
+  TASSERT (records[999].kind == EngineCapture::Kind::BLOCK);
+  TCMP (records[999].stamp, ==, 999 * 128 + start - header.start_stamp);
+  TCMP (records[999].value, ==, 999);
+  TCMP (header.n_dropped, ==, 0);
+}
+
+BSE_INTEGRITY_TEST (bse_engine_capture_overflow);
+static void
+bse_engine_capture_overflow ()
+{
+  const String filename = Path::join (Path::cache_home(), string_format ("bse-capture-overflow-%u.dat", getpid()));
+  Path::mkdirs (Path::dirname (filename));
+  TASSERT (EngineCapture::start (filename));
+  // holding the capture thread mutex allows at most one flush, so queueing 3 buffers worth must drop records
+  EngineCapture::Capture *cap = EngineCapture::capture;
+  TASSERT (cap != nullptr);
+  const size_t n_queued = 3 * CAPTURE_BUFFER_RECORDS;
+  cap->mutex.lock();
+  const uint64 start = Bse::TickStamp::current();
+  for (size_t i = 0; i < n_queued; i++)
+    {
+      EngineCapture::Record rec;
+      rec.kind = EngineCapture::Kind::BLOCK;
+      rec.stamp = start + i;
+      EngineCapture::record (rec);
+    }
+  cap->mutex.unlock();
+  EngineCapture::stop();
+  EngineCapture::Header header;
+  std::vector<EngineCapture::Record> records;
+  TASSERT (EngineCapture::read (filename, header, records));
+  unlink (filename.c_str());
+  TCMP (header.n_records, ==, records.size());
+  TCMP (header.n_records + header.n_dropped, ==, n_queued);
+  TCMP (header.n_records, >=, CAPTURE_BUFFER_RECORDS);
+  TCMP (header.n_dropped, >=, CAPTURE_BUFFER_RECORDS);
+}
+
+BSE_INTEGRITY_TEST (bse_engine_capture_origin);
+static void
+bse_engine_capture_origin ()
+{
+  TASSERT (EngineCapture::origin() == EngineCapture::Origin::API);
+  {
+    EngineCapture::PlaybackScope outer;
+    TASSERT (EngineCapture::origin() == EngineCapture::Origin::PLAYBACK);
+    {
+      EngineCapture::PlaybackScope inner;
+    }
+    TASSERT (EngineCapture::origin() == EngineCapture::Origin::PLAYBACK);
+  }
+  TASSERT (EngineCapture::origin() == EngineCapture::Origin::API);
+  std::thread ([] () { TASSERT (EngineCapture::origin() == EngineCapture::Origin::API); }).join();
+}
+
+} // Anon
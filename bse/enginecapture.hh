@@ -0,0 +1,75 @@
+// Licensed GNU LGPL v2.1 or later: http://www.gnu.org/licenses/lgpl.html
+#ifndef __BSE_ENGINE_CAPTURE_HH__
+#define __BSE_ENGINE_CAPTURE_HH__
+
+#include <bse/bcore.hh>
+
+namespace Bse {
+
+/// Recording of the engine workload into a compact binary file for offline replay, see `bsetool replay`.
+namespace EngineCapture {
+
+/// Kinds of capture records.
+enum class Kind : uint8 {
+  BLOCK = 1,    ///< Processed engine block, `id32` holds n_values, `value` the processing time in nanoseconds.
+  TRANS,        ///< Committed transaction, `id16` holds the job count, `key` a bit mask of the job types, `channel` the Origin.
+  PARAM,        ///< Processor::set_param(), `id32` holds the parameter id, `key` the processor URI hash, `id16` its order of instantiation, `channel` the Origin.
+  MIDI,         ///< MIDI input event, `id16` holds the event type, `id32` control or program, `value` and `value2` the data.
+};
+
+/// Origin of TRANS and PARAM records.
+enum class Origin : uint8 {
+  API = 0,      ///< Issued by API calls, a replay needs to reissue these.
+  PLAYBACK,     ///< Issued by the sequencer, MIDI receivers or project loading, playback recreates these.
+};
+
+/// Fixed size capture record, stored in host byte order.
+struct Record {
+  Kind   kind = Kind (0);
+  uint8  channel = 0;
+  uint16 id16 = 0;
+  uint32 id32 = 0;
+  uint64 stamp = 0;     ///< Tick stamp relative to the start of the capture.
+  uint64 key = 0;
+  double value = 0;
+  double value2 = 0;
+};
+
+/// Information stored at the start of a capture file.
+struct Header {
+  char   magic[8] = { 'B', 'S', 'E', 'C', 'A', 'P', 'T', '2' };
+  uint32 sample_rate = 0;
+  uint32 block_size = 0;
+  uint64 start_stamp = 0;       ///< Absolute tick stamp of the capture start.
+  uint64 n_records = 0;         ///< Number of records written, updated when the capture is stopped.
+  uint64 n_dropped = 0;         ///< Number of records lost because the capture thread fell behind.
+};
+
+extern std::atomic<bool> capture_active;
+
+bool    start   (const String &filename);
+void    stop    ();
+void    record  (Record rec);
+bool    read    (const String &filename, Header &header, std::vector<Record> &records);
+Origin  origin  ();
+
+/// Mark TRANS and PARAM records of the current thread as Origin::PLAYBACK while in scope.
+class PlaybackScope {
+  const Origin saved_;
+public:
+  explicit PlaybackScope  ();
+  /*dtor*/  ~PlaybackScope ();
+  BSE_CLASS_NON_COPYABLE (PlaybackScope);
+};
+
+/// Check if a capture is in progress, records should only be assembled if this returns true.
+inline bool
+active ()
+{
+  return BSE_UNLIKELY (capture_active.load (std::memory_order_relaxed));
+}
+
+} // EngineCapture
+} // Bse
+
+#endif // __BSE_ENGINE_CAPTURE_HH__
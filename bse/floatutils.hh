@@ -4,6 +4,9 @@
 
 #include <bse/memory.hh>
 #include <cmath>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 
 namespace Bse {
 
@@ -41,6 +44,20 @@ floatadd (float *__restrict dst, const float *__restrict a, const float *__restr
     dst[i] = a[i] + b[i];
 }
 
+/// Add `n` values from `src` to `dst`, uses SSE for 16-byte aligned buffers.
+extern inline void
+floataccumulate (float *__restrict dst, const float *__restrict src, size_t n)
+{
+  size_t i = 0;
+#ifdef __SSE__
+  if (BSE_ISLIKELY (0 == ((size_t (dst) | size_t (src)) & 15)))
+    for (; i + 4 <= n; i += 4)
+      _mm_store_ps (dst + i, _mm_add_ps (_mm_load_ps (dst + i), _mm_load_ps (src + i)));
+#endif
+  for (; i < n; i++)
+    dst[i] += src[i];
+}
+
 /// For `n` values, multiply `src` and `factors` pairwise and store the result in `dst`.
 extern inline void
 floatmul (float *__restrict dst, const float *__restrict src, const float *__restrict factors, size_t n)
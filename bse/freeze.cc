@@ -0,0 +1,478 @@
+// Licensed GNU LGPL v2.1 or later: http://www.gnu.org/licenses/lgpl.html
+#include "freeze.hh"
+#include "randomhash.hh"
+#include "path.hh"
+#include "bseglobals.hh"
+#include "enginecapture.hh"
+#include "internal.hh"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define FDEBUG(...)     Bse::debug ("freeze", __VA_ARGS__)
+
+namespace Bse {
+namespace AudioSignal {
+
+// == FreezeCache ==
+FreezeCache::FreezeCache (const String &key, uint n_channels, int64_t loop_frames) :
+  key_ (key), n_channels_ (n_channels), loop_frames_ (loop_frames)
+{}
+
+FreezeCache::~FreezeCache ()
+{
+  if (frames_)
+    munmap (frames_, map_length_);
+  frames_ = nullptr;
+  map_length_ = 0;
+}
+
+bool
+FreezeCache::map_file (const String &filename)
+{
+  assert_return (frames_ == nullptr, false);
+  const size_t length = n_channels_ * n_frames() * sizeof (float);
+  const int fd = open (filename.c_str(), O_RDONLY | O_NOCTTY | O_CLOEXEC);
+  return_unless (fd >= 0, false);
+  void *maddr = MAP_FAILED;
+  struct stat st;
+  if (fstat (fd, &st) == 0 && size_t (st.st_size) == length)
+    maddr = mmap (nullptr, length, PROT_READ, MAP_SHARED | MAP_POPULATE, fd, 0);
+  close (fd);
+  return_unless (maddr != MAP_FAILED, false);
+  frames_ = (float*) maddr;
+  map_length_ = length;
+  return true;
+}
+
+/// Copy `n` frames of `channel` starting at playback position `pos` into `dest`, MT-Safe.
+/// Negative positions yield silence, positions beyond the first iteration loop over the second.
+void
+FreezeCache::read (uint channel, int64_t pos, float *dest, uint n) const
+{
+  const float *src = frames_ + std::min (channel, n_channels_ - 1) * n_frames();
+  uint i = 0;
+  while (i < n && pos + i < 0)
+    dest[i++] = 0;
+  while (i < n)
+    {
+      int64_t p = pos + i;
+      if (p >= 2 * loop_frames_)
+        p = loop_frames_ + (p - loop_frames_) % loop_frames_;
+      const uint l = std::min (int64_t (n - i), n_frames() - p);
+      floatcopy (dest + i, src + p, l);
+      i += l;
+    }
+}
+
+static void
+sha3_update (SHA3_256 &sha3, const void *data, size_t length)
+{
+  sha3.update ((const uint8_t*) data, length);
+}
+
+/// Calculate a SHA3 key from all Chain processors, their parameters and the clip input.
+String
+FreezeCache::make_key (Chain &chain, const MidiLib::ClipEventVectorP &cevp, double bpm, int64_t loop_frames)
+{
+  SHA3_256 sha3;
+  const uint32 sample_rate = chain.sample_rate();
+  sha3_update (sha3, &sample_rate, sizeof (sample_rate));
+  sha3_update (sha3, &bpm, sizeof (bpm));
+  sha3_update (sha3, &loop_frames, sizeof (loop_frames));
+  for (const ProcessorP &proc : chain.list_processors_mt())
+    {
+      ProcessorInfo info;
+      proc->query_info (info);
+      const String uri = info.uri.string() + "\n" + info.version.string();
+      sha3_update (sha3, uri.c_str(), uri.size() + 1);
+      for (const ParamInfoP &pinfo : proc->list_params())
+        {
+          const uint32 id = uint32 (pinfo->id);
+          const double value = Processor::param_peek_mt (proc, pinfo->id);
+          sha3_update (sha3, &id, sizeof (id));
+          sha3_update (sha3, &value, sizeof (value));
+        }
+    }
+  if (cevp)
+    for (const PartNote &note : *cevp)
+      {
+        const int32 ivalues[] = { note.channel, note.tick, note.duration, note.key, note.fine_tune };
+        sha3_update (sha3, ivalues, sizeof (ivalues));
+        sha3_update (sha3, &note.velocity, sizeof (note.velocity));
+      }
+  uint8_t digest[32];
+  sha3.digest (digest);
+  String key;
+  for (size_t i = 0; i < sizeof (digest); i++)
+    key += string_format ("%02x", digest[i]);
+  return key;
+}
+
+/// Location of the float file for `key`, the file contains non-interleaved channels.
+String
+FreezeCache::cache_filename (const String &key)
+{
+  return Path::join (Path::cache_home(), "beast", "freeze", key + ".f32");
+}
+
+/// Render `chain` offline with the clip events `cevp` and return its memory mapped output.
+/// A previous rendering is reused if the chain state and clip still match its key.
+/// Processors of `chain` are not modified, the rendering uses clones in a private Engine.
+/// The rendering is aborted and yields `nullptr` once `cancel` is set, it is checked per block.
+FreezeCacheP
+FreezeCache::render (Chain &chain, const MidiLib::ClipEventVectorP &cevp, double bpm, const std::atomic<bool> *cancel)
+{
+  constexpr OBusId OUT1 = OBusId (1);
+  EngineCapture::PlaybackScope playback;        // clone parameters are recreated with the rendering
+  AudioTiming timing { bpm, 0 };
+  Engine engine (chain.sample_rate(), timing, [] () {});
+  auto midiin = std::dynamic_pointer_cast<MidiLib::MidiInputIface> (Processor::registry_create (engine, "Bse.MidiLib.MidiInput"));
+  auto ochain = std::dynamic_pointer_cast<Chain> (Processor::registry_create (engine, "Bse.AudioSignal.Chain"));
+  assert_return (midiin && ochain, nullptr);
+  midiin->set_param (MidiLib::MidiInputIface::BPM, bpm);
+  MidiLib::ClipEventVectorP cev = cevp;
+  midiin->swap_event_vector (cev);
+  const int64_t loop_frames = midiin->loop_frames();
+  const uint n_channels = chain.n_ochannels (OUT1);
+  return_unless (loop_frames > 0 && n_channels > 0, nullptr);
+  const String key = make_key (chain, cevp, bpm, loop_frames);
+  FreezeCacheP cache = FreezeCacheP (new FreezeCache (key, n_channels, loop_frames));
+  const String filename = cache_filename (key);
+  if (cache->map_file (filename))
+    {
+      FDEBUG ("reusing %s", filename);
+      return cache;
+    }
+  // clone chain processors
+  ochain->set_event_source (midiin);
+  for (const ProcessorP &proc : chain.list_processors_mt())
+    {
+      ProcessorInfo info;
+      proc->query_info (info);
+      ProcessorP clone = Processor::registry_create (engine, info.uri);
+      if (!clone)
+        {
+          FDEBUG ("failed to clone processor: %s", info.uri);
+          return nullptr;
+        }
+      for (const ParamInfoP &pinfo : proc->list_params())
+        clone->set_param (pinfo->id, Processor::param_peek_mt (proc, pinfo->id));
+      ochain->insert (clone);
+    }
+  // render into temporary file
+  const int64_t total = cache->n_frames();
+  const size_t length = n_channels * total * sizeof (float);
+  Path::mkdirs (Path::dirname (filename));
+  const String tmpname = filename + string_format (".%u.tmp", getpid());
+  const int fd = open (tmpname.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_NOCTTY | O_CLOEXEC, 0600);
+  return_unless (fd >= 0, nullptr);
+  void *maddr = MAP_FAILED;
+  if (ftruncate (fd, length) == 0)
+    maddr = mmap (nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close (fd);
+  if (maddr == MAP_FAILED)
+    {
+      FDEBUG ("%s: failed to map: %s", tmpname, strerror (errno));
+      unlink (tmpname.c_str());
+      return nullptr;
+    }
+  float *wframes = (float*) maddr;
+  engine.add_root (ochain);
+  engine.make_schedule();
+  bool cancelled = false;
+  for (int64_t pos = std::numeric_limits<int64_t>::min(); pos < total; )
+    {
+      if (cancel && cancel->load())
+        {
+          cancelled = true;
+          break;
+        }
+      engine.render_block();
+      pos = int64_t (engine.frame_counter()) - midiin->playback_start();
+      const int64_t first = std::max (int64_t (0), -pos), last = std::min (int64_t (MAX_RENDER_BLOCK_SIZE), total - pos);
+      for (uint c = 0; c < n_channels; c++)
+        if (first < last)
+          floatcopy (wframes + c * total + pos + first, ochain->ofloats (OUT1, c) + first, last - first);
+    }
+  engine.del_root (ochain);
+  munmap (maddr, length);
+  if (cancelled)
+    {
+      FDEBUG ("%s: rendering cancelled", tmpname);
+      unlink (tmpname.c_str());
+      return nullptr;
+    }
+  if (rename (tmpname.c_str(), filename.c_str()) != 0 || !cache->map_file (filename))
+    {
+      FDEBUG ("%s: failed to store: %s", filename, strerror (errno));
+      unlink (tmpname.c_str());
+      return nullptr;
+    }
+  FDEBUG ("rendered %u frames into %s", total, filename);
+  return cache;
+}
+
+// == Freezer ==
+struct Freezer::Render {
+  std::thread       thread;
+  std::atomic<bool> cancel { false };
+  FreezeCacheP      cache;
+};
+
+Freezer::Freezer (ChainP chain, const Installer &installer) :
+  chain_ (chain), installer_ (installer)
+{}
+
+Freezer::~Freezer ()
+{
+  watch (false);
+  if (render_)
+    {
+      render_->cancel = true;
+      if (render_->thread.joinable())
+        render_->thread.join(); // render_done() is skipped once the Freezer is gone
+    }
+  render_ = nullptr;
+}
+
+/// Create a Freezer for `chain`, the Freezer needs to be owned by a std::shared_ptr.
+FreezerP
+Freezer::create (ChainP chain, const Installer &installer)
+{
+  assert_return (chain != nullptr, nullptr);
+  assert_return (installer != nullptr, nullptr);
+  return FreezerP (new Freezer (chain, installer));
+}
+
+/// Keep the Chain frozen with a rendering of `cevp` at `bpm`, the rendering happens in the background.
+/// The Chain is rendered live until the rendering is installed, a previous rendering is discarded.
+void
+Freezer::freeze (const MidiLib::ClipEventVectorP &cevp, double bpm)
+{
+  assert_return (this_thread_is_bse());
+  cevp_ = cevp;
+  bpm_ = bpm;
+  if (!enabled_)
+    {
+      enabled_ = true;
+      watch (true);
+    }
+  invalidate();
+}
+
+/// Stop keeping the Chain frozen, thaws the Chain and discards renderings in progress.
+void
+Freezer::unfreeze ()
+{
+  assert_return (this_thread_is_bse());
+  enabled_ = false;
+  stale_ = false;
+  if (render_)
+    render_->cancel = true;   // render_done() still needs to reap the thread
+  watch (false);
+  install (nullptr);
+}
+
+/// Thaw the Chain because its state changed and restart the rendering.
+void
+Freezer::invalidate ()
+{
+  assert_return (this_thread_is_bse());
+  return_unless (enabled_);
+  install (nullptr);
+  start_render();
+}
+
+void
+Freezer::start_render ()
+{
+  if (render_)
+    {
+      stale_ = true;            // coalesce, restart once the current rendering is done
+      return;
+    }
+  RenderP render = std::make_shared<Render>();
+  render_ = render;
+  std::weak_ptr<Freezer> weak = shared_from_this();
+  ChainP chain = chain_;
+  MidiLib::ClipEventVectorP cevp = cevp_;
+  const double bpm = bpm_;
+  render->thread = std::thread ([render, weak, chain, cevp, bpm] () {
+    this_thread_set_name ("Bse:Freezer");
+    render->cache = FreezeCache::render (*chain, cevp, bpm, &render->cancel);
+    exec_now ([render, weak] () {
+      FreezerP self = weak.lock();
+      if (self)
+        self->render_done (render);
+    });
+  });
+}
+
+void
+Freezer::render_done (RenderP render)
+{
+  if (render->thread.joinable())
+    render->thread.join();
+  return_unless (render == render_);
+  render_ = nullptr;
+  n_renders_++;
+  return_unless (enabled_);
+  watch (true);                 // pick up processors inserted meanwhile
+  if (stale_)
+    {
+      stale_ = false;
+      start_render();
+      return;
+    }
+  FreezeCacheP cache = render->cache;
+  if (!cache)
+    {
+      FDEBUG ("%s: nothing to render, thawing", chain_->debug_name());
+      unfreeze();
+      return;
+    }
+  // catch changes that happened before watch() covered new processors
+  if (cache->key() != FreezeCache::make_key (*chain_, cevp_, bpm_, cache->loop_frames()))
+    {
+      start_render();
+      return;
+    }
+  install (cache);
+}
+
+void
+Freezer::install (FreezeCacheP cache)
+{
+  FreezeCacheP previous = cache_;
+  cache_ = cache;
+  if (cache || previous)
+    installer_ (cache, previous);
+}
+
+// Watch Chain insertions, removals and parameter changes while frozen.
+void
+Freezer::watch (bool enable)
+{
+  for (auto &con : connections_)
+    con.disconnect();
+  connections_.clear();
+  for (Notify &n : notifies_)
+    n.info->del_notify (n.proc, n.id);
+  notifies_.clear();
+  chainimpl_ = nullptr;
+  return_unless (enable);
+  std::weak_ptr<Freezer> weak = shared_from_this();
+  auto changed = [weak] () {
+    FreezerP self = weak.lock();
+    if (self)
+      self->invalidate();
+  };
+  chainimpl_ = chain_->access_processor(); // needed to receive "sub:" notifications
+  connections_.push_back (chainimpl_->on ("sub:insert", [changed] (const Aida::Event&) { changed(); }));
+  connections_.push_back (chainimpl_->on ("sub:remove", [changed] (const Aida::Event&) { changed(); }));
+  for (const ProcessorP &proc : chain_->list_processors_mt())
+    {
+      ProcessorImplP impl = proc->access_processor(); // needed to receive parameter notifications
+      for (const ParamInfoP &pinfo : proc->list_params())
+        notifies_.push_back ({ proc, impl, pinfo, pinfo->add_notify (proc, changed) });
+    }
+}
+
+} // AudioSignal
+} // Bse
+
+// == Testing ==
+#include "testing.hh"
+
+namespace { // Anon
+using namespace Bse;
+using namespace Bse::AudioSignal;
+
+BSE_INTEGRITY_TEST (bse_freezer_lifecycle);
+static void
+bse_freezer_lifecycle ()
+{
+  AudioTiming timing { 120, 0 };
+  Engine engine (48000, timing, [] () {});
+  ChainP chain = std::dynamic_pointer_cast<Chain> (Processor::registry_create (engine, "Bse.AudioSignal.Chain"));
+  ProcessorP proc = Processor::registry_create (engine, "Bse.DebugDsp.DbgParameterizer");
+  TASSERT (chain && proc);
+  chain->insert (proc);
+  ParamId pid = ParamId (0);
+  for (const ParamInfoP &pinfo : proc->list_params())
+    if (pinfo->get_minmax().second >= Processor::param_peek_mt (proc, pinfo->id) + 2)
+      {
+        pid = pinfo->id;        // parameter that can be increased twice
+        break;
+      }
+  TASSERT (pid != ParamId (0));
+  size_t n_installs = 0;
+  StringVector keys;
+  int64_t loop_frames = 0;
+  auto installer = [&] (FreezeCacheP cache, FreezeCacheP previous) {
+    n_installs++;
+    if (cache)
+      {
+        keys.push_back (cache->key());
+        loop_frames = cache->loop_frames();
+      }
+    chain->freeze (cache, 0); // the test Engine is not rendering
+  };
+  FreezerP freezer = Freezer::create (chain, installer);
+  // notifications are delivered in batches, wait out the coalescing window
+  auto deliver_notifies = [&] () {
+    for (int ms = engine.ipc_timeout(); ms > 0; ms = engine.ipc_timeout())
+      usleep (ms * 1000);
+    engine.ipc_dispatch();
+  };
+  // finished renderings are handed to render_done() through the main loop
+  auto await_renders = [&] () {
+    while (freezer->rendering())
+      g_main_context_iteration (bse_main_context, true);
+  };
+  // freeze renders in the background
+  freezer->freeze (nullptr, 120);
+  TASSERT (freezer->enabled() && freezer->rendering());
+  TASSERT (!freezer->frozen() && !chain->frozen());
+  await_renders();
+  TASSERT (freezer->frozen() && chain->frozen());
+  TCMP (n_installs, ==, 1);
+  // parameter edits thaw and re-render
+  proc->set_param (pid, Processor::param_peek_mt (proc, pid) + 1);
+  deliver_notifies();
+  TASSERT (!chain->frozen() && freezer->rendering());
+  await_renders();
+  TASSERT (freezer->frozen() && chain->frozen());
+  TCMP (keys.size(), ==, 2);
+  TCMP (keys[0], !=, keys[1]);
+  // insertions keep the chain frozen until invalidated by the Freezer
+  const uint64 n_renders = freezer->n_renders();
+  chain->insert (Processor::registry_create (engine, "Bse.DebugDsp.DbgParameterizer"));
+  TASSERT (chain->frozen());
+  deliver_notifies();
+  TASSERT (!chain->frozen() && freezer->rendering());
+  await_renders();
+  TASSERT (freezer->n_renders() > n_renders && freezer->frozen() && chain->frozen());
+  TCMP (keys.size(), ==, 3);
+  TCMP (keys[1], !=, keys[2]);
+  // unfreeze thaws and stops watching
+  freezer->unfreeze();
+  TASSERT (!freezer->enabled() && !freezer->frozen() && !chain->frozen());
+  proc->set_param (pid, Processor::param_peek_mt (proc, pid) + 1);
+  deliver_notifies();
+  TASSERT (!freezer->rendering() && !chain->frozen());
+  // destruction cancels and joins a rendering in progress
+  freezer->freeze (nullptr, 120);
+  TASSERT (freezer->rendering());
+  freezer = nullptr;
+  while (g_main_context_iteration (bse_main_context, false))
+    ;                           // the pending render_done() finds no Freezer
+  TCMP (n_installs, ==, 6);
+  keys.push_back (FreezeCache::make_key (*chain, nullptr, 120, loop_frames)); // in case it completed
+  for (const String &key : keys)
+    unlink (FreezeCache::cache_filename (key).c_str());
+}
+
+} // Anon
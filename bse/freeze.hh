@@ -0,0 +1,84 @@
+// Licensed GNU LGPL v2.1 or later: http://www.gnu.org/licenses/lgpl.html
+#ifndef __BSE_FREEZE_HH__
+#define __BSE_FREEZE_HH__
+
+#include <bse/combo.hh>
+#include <bse/midilib.hh>
+
+namespace Bse {
+
+namespace AudioSignal {
+
+// == FreezeCache ==
+/// Rendered output of a frozen Chain, memory mapped from a float file in the cache directory.
+/// The first `loop_frames` cover the first clip iteration, the second `loop_frames` cover
+/// a steady-state iteration that includes tails from the preceeding iteration.
+class FreezeCache {
+  const String  key_;
+  const uint    n_channels_ = 0;
+  const int64_t loop_frames_ = 0;
+  float        *frames_ = nullptr;
+  size_t        map_length_ = 0;
+  explicit      FreezeCache     (const String &key, uint n_channels, int64_t loop_frames);
+  bool          map_file        (const String &filename);
+  BSE_CLASS_NON_COPYABLE (FreezeCache);
+public:
+  /*dtor*/     ~FreezeCache     ();
+  String        key             () const        { return key_; }
+  uint          n_channels      () const        { return n_channels_; }
+  int64_t       n_frames        () const        { return 2 * loop_frames_; }
+  int64_t       loop_frames     () const        { return loop_frames_; }
+  void          read            (uint channel, int64_t pos, float *dest, uint n) const;
+  static String make_key        (Chain &chain, const MidiLib::ClipEventVectorP &cevp, double bpm, int64_t loop_frames);
+  static String cache_filename  (const String &key);
+  static FreezeCacheP render    (Chain &chain, const MidiLib::ClipEventVectorP &cevp, double bpm,
+                                 const std::atomic<bool> *cancel = nullptr);
+};
+
+// == Freezer ==
+/// Keeps a Chain frozen on behalf of the user thread.
+/// FreezeCache renderings happen in a background thread, once a rendering is done it is handed to
+/// the `installer` which needs to apply it to the Chain in the engine thread. Insertions, removals
+/// and parameter changes of the Chain processors thaw the Chain and restart the rendering.
+class Freezer : public std::enable_shared_from_this<Freezer> {
+public:
+  /// Apply `cache` (or thaw for `nullptr`) in the engine thread, `previous` must be released in the user thread.
+  using Installer = std::function<void (FreezeCacheP cache, FreezeCacheP previous)>;
+private:
+  struct Render;
+  using RenderP = std::shared_ptr<Render>;
+  struct Notify { ProcessorP proc; ProcessorImplP impl; ParamInfoP info; size_t id; };
+  const ChainP                            chain_;
+  const Installer                         installer_;
+  ProcessorImplP                          chainimpl_;
+  std::vector<Aida::IfaceEventConnection> connections_;
+  std::vector<Notify>                     notifies_;
+  MidiLib::ClipEventVectorP               cevp_;
+  double                                  bpm_ = 0;
+  FreezeCacheP                            cache_;       // installed rendering
+  RenderP                                 render_;      // rendering in progress
+  bool                                    enabled_ = false;
+  bool                                    stale_ = false; // restart render_ once done
+  uint64                                  n_renders_ = 0;
+  void          start_render    ();
+  void          render_done     (RenderP render);
+  void          watch           (bool enable);
+  void          install         (FreezeCacheP cache);
+  explicit      Freezer         (ChainP chain, const Installer &installer);
+  BSE_CLASS_NON_COPYABLE (Freezer);
+public:
+  /*dtor*/     ~Freezer         ();
+  static FreezerP create (ChainP chain, const Installer &installer);
+  void          freeze          (const MidiLib::ClipEventVectorP &cevp, double bpm);
+  void          unfreeze        ();
+  void          invalidate      ();
+  bool          enabled         () const        { return enabled_; }   ///< Chain is requested to stay frozen.
+  bool          frozen          () const        { return cache_ != nullptr; } ///< A current rendering is installed.
+  bool          rendering       () const        { return render_ != nullptr; }
+  uint64        n_renders       () const        { return n_renders_; }
+};
+
+} // AudioSignal
+} // Bse
+
+#endif // __BSE_FREEZE_HH__
@@ -130,14 +130,14 @@ bse_wave_file_dump_header (gint           fd,
 
   assert_return (fd >= 0, EINVAL);
   assert_return (n_data_bytes < 4294967296LLU - 44, EINVAL);
-  assert_return (n_bits == 16 || n_bits == 8, EINVAL);
+  assert_return (n_bits == 32 || n_bits == 24 || n_bits == 16 || n_bits == 8, EINVAL);
   assert_return (n_channels >= 1, EINVAL);
 
   file_length = 0; /* 4 + 4; */				/* 'RIFF' header is left out*/
   file_length += 4 + 4 + 4 + 2 + 2 + 4 + 4 + 2 + 2;	/* 'fmt ' header */
   file_length += 4 + 4;					/* 'data' header */
   file_length += n_data_bytes;
-  byte_per_sample = (n_bits == 16 ? 2 : 1) * n_channels;
+  byte_per_sample = n_bits / 8 * n_channels;
   byte_per_second = byte_per_sample * sample_freq;
 
   errno = 0;
@@ -146,7 +146,7 @@ bse_wave_file_dump_header (gint           fd,
   write_bytes (fd, 4, "WAVE");		/* chunk_type */
   write_bytes (fd, 4, "fmt ");		/* sub_chunk */
   write_uint32_le (fd, 16);		/* sub chunk length */
-  write_uint16_le (fd, 1);		/* format (1=PCM) */
+  write_uint16_le (fd, n_bits == 32 ? 3 : 1);	/* format (1=PCM, 3=IEEE float) */
   write_uint16_le (fd, n_channels);
   write_uint32_le (fd, sample_freq);
   write_uint32_le (fd, byte_per_second);
@@ -1216,6 +1216,79 @@ gsl_biquad_filter_eval (GslBiquadFilter *f,
   f->yd2 = yd2;
 }
 
+/**
+ * @param n_lanes	number of filters
+ * @param filters	filters to evaluate
+ * @param n_values	number of values to filter per lane
+ * @param x		input signals, one per lane
+ * @param y		output signals, one per lane
+ *
+ * Evaluate several independent biquad filters at once, the same as
+ * calling gsl_biquad_filter_eval() for each of them. Filter states are
+ * kept in structure-of-arrays form, so each sample step computes four
+ * filters with SIMD instructions.
+ */
+void
+gsl_biquad_filter_eval_lanes (guint             n_lanes,
+                              GslBiquadFilter **filters,
+                              guint             n_values,
+                              const gfloat    **x,
+                              gfloat          **y)
+{
+  enum { LANES = 4 };
+  assert_return (filters != NULL && x != NULL && y != NULL);
+
+  for (guint l0 = 0; l0 < n_lanes; l0 += LANES)
+    {
+      const guint n = MIN (LANES, n_lanes - l0);
+      alignas (32) gdouble xc0[LANES], xc1[LANES], xc2[LANES], yc1[LANES], yc2[LANES];
+      alignas (32) gdouble xd1[LANES], xd2[LANES], yd1[LANES], yd2[LANES];
+      const gfloat *xl[LANES];
+      for (guint l = 0; l < LANES; l++)
+        {
+          /* unused lanes compute a copy of the first lane and are discarded */
+          const GslBiquadFilter *f = filters[l0 + (l < n ? l : 0)];
+          xc0[l] = f->xc0;
+          xc1[l] = f->xc1;
+          xc2[l] = f->xc2;
+          yc1[l] = f->yc1;
+          yc2[l] = f->yc2;
+          xd1[l] = f->xd1;
+          xd2[l] = f->xd2;
+          yd1[l] = f->yd1;
+          yd2[l] = f->yd2;
+          xl[l] = x[l0 + (l < n ? l : 0)];
+        }
+      for (guint i = 0; i < n_values; i++)
+        {
+          for (guint l = 0; l < LANES; l++)
+            {
+              gdouble k0, k1, k2;
+              k2 = xd2[l] * xc2[l];
+              k1 = xd1[l] * xc1[l];
+              xd2[l] = xd1[l];
+              xd1[l] = xl[l][i];
+              k2 -= yd2[l] * yc2[l];
+              k1 -= yd1[l] * yc1[l];
+              yd2[l] = yd1[l];
+              k0 = xd1[l] * xc0[l];
+              yd1[l] = k2 + k1;
+              yd1[l] += k0;
+            }
+          for (guint l = 0; l < n; l++)
+            y[l0 + l][i] = yd1[l];
+        }
+      for (guint l = 0; l < n; l++)
+        {
+          GslBiquadFilter *f = filters[l0 + l];
+          f->xd1 = xd1[l];
+          f->xd2 = xd2[l];
+          f->yd1 = yd1[l];
+          f->yd2 = yd2[l];
+        }
+    }
+}
+
 #if 0
 void
 gsl_biquad_lphp_reso (GslBiquadFilter   *c,
@@ -208,6 +208,11 @@ void	gsl_biquad_filter_eval		(GslBiquadFilter	*f,
 					 guint			 n_values,
 					 const gfloat		*x,
 					 gfloat			*y);
+void	gsl_biquad_filter_eval_lanes	(guint			 n_lanes,
+					 GslBiquadFilter	**filters,
+					 guint			 n_values,
+					 const gfloat		**x,
+					 gfloat			**y);
 
 
 /* --- filter scanning -- */
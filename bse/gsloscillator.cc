@@ -87,16 +87,14 @@ init_osc_process_tables()
   return true;
 }
 
-static inline void
-osc_process (GslOscData   *osc,
-	     guint         n_values,
-	     guint	   mode,
-	     const gfloat *ifreq,
-	     const gfloat *imod,
-	     const gfloat *isync,
-	     const gfloat *ipwm,
-	     gfloat       *mono_out,
-	     gfloat       *sync_out)
+static inline guint
+osc_mode (GslOscData   *osc,
+          guint         mode,
+          const gfloat *ifreq,
+          const gfloat *imod,
+          const gfloat *isync,
+          const gfloat *ipwm,
+          gfloat       *sync_out)
 {
   mode |= isync ? OSC_FLAG_ISYNC : 0;
   mode |= sync_out ? OSC_FLAG_OSYNC : 0;
@@ -109,7 +107,13 @@ osc_process (GslOscData   *osc,
     mode |= OSC_FLAG_EXP_MOD;
   else if (imod)
     mode |= OSC_FLAG_LINEAR_MOD;
+  return mode;
+}
 
+static inline void
+osc_update_mode (GslOscData *osc,
+                 guint       mode)
+{
   if (UNLIKELY (mode != osc->last_mode))
     {
       guint change_mask = osc->last_mode >= OSC_FLAG_INVAL ? OSC_FLAG_INVAL : osc->last_mode ^ mode;
@@ -135,6 +139,21 @@ osc_process (GslOscData   *osc,
 	}
       osc->last_mode = mode;
     }
+}
+
+static inline void
+osc_process (GslOscData   *osc,
+	     guint         n_values,
+	     guint	   mode,
+	     const gfloat *ifreq,
+	     const gfloat *imod,
+	     const gfloat *isync,
+	     const gfloat *ipwm,
+	     gfloat       *mono_out,
+	     gfloat       *sync_out)
+{
+  mode = osc_mode (osc, mode, ifreq, imod, isync, ipwm, sync_out);
+  osc_update_mode (osc, mode);
 
   /* invoke generated function variant */
   if (mode & OSC_FLAG_PULSE_OSC)
@@ -188,6 +207,154 @@ gsl_osc_process_pulse (GslOscData   *osc,
 	       mono_out, sync_out);
 }
 
+/* frequency tracking of oscillator_process_variants<OSC_FLAG_FREQ>() for a lane */
+static void
+osc_lane_change_freq (GslOscData *osc,
+                      gdouble     freq_level,
+                      guint32    *cur_pos,
+                      guint32    *pos_inc)
+{
+  GslOscWave *wave = &osc->wave;
+  const gdouble fine_tune = bse_cent_tune_fast (osc->config.fine_tune);
+  const gdouble transposed_freq = osc->config.transpose_factor * freq_level;
+  if (UNLIKELY (transposed_freq <= wave->min_freq || transposed_freq > wave->max_freq))
+    {
+      const gdouble fcpos = *cur_pos * wave->ifrac_to_float;
+      const gfloat *orig_values = wave->values;
+      gsl_osc_table_lookup (osc->config.table, transposed_freq, wave);
+      if (orig_values != wave->values)	/* catch non-changes */
+        {
+          *cur_pos = fcpos / wave->ifrac_to_float;
+          *pos_inc = bse_dtoi (transposed_freq * fine_tune * wave->freq_to_step);
+        }
+    }
+  else
+    *pos_inc = bse_dtoi (transposed_freq * fine_tune * wave->freq_to_step);
+}
+
+/* table read out and linear interpolation for up to LANES oscillators per sample step */
+static void
+osc_process_lane_group (guint          n_lanes,
+                        GslOscData   **oscs,
+                        guint          n_values,
+                        const gfloat **ifreq,
+                        gfloat       **mono_out)
+{
+  enum { LANES = 4 };
+  alignas (16) guint32 cur_pos[LANES], pos_inc[LANES], n_frac_bits[LANES], frac_bitmask[LANES];
+  alignas (16) gfloat ifrac_to_float[LANES], v[LANES];
+  const gfloat *values[LANES];
+  gdouble last_freq_level[LANES];
+  guint l;
+
+  for (l = 0; l < LANES; l++)
+    {
+      /* unused lanes compute a standing copy of the first lane and are discarded */
+      GslOscData *osc = oscs[l < n_lanes ? l : 0];
+      const GslOscWave *wave = &osc->wave;
+      const gdouble fine_tune = bse_cent_tune_fast (osc->config.fine_tune);
+      cur_pos[l] = osc->cur_pos;
+      pos_inc[l] = l < n_lanes ? bse_dtoi (osc->last_freq_level * osc->config.transpose_factor * fine_tune * wave->freq_to_step) : 0;
+      n_frac_bits[l] = wave->n_frac_bits;
+      frac_bitmask[l] = wave->frac_bitmask;
+      ifrac_to_float[l] = wave->ifrac_to_float;
+      values[l] = wave->values;
+      last_freq_level[l] = osc->last_freq_level;
+    }
+  for (guint i = 0; i < n_values; i++)
+    {
+      for (l = 0; l < n_lanes; l++)
+        if (ifreq[l])
+          {
+            const gdouble freq_level = BSE_SIGNAL_TO_FREQ (ifreq[l][i]);
+            if (UNLIKELY (BSE_SIGNAL_FREQ_CHANGED (last_freq_level[l], freq_level)))
+              {
+                GslOscData *osc = oscs[l];
+                osc_lane_change_freq (osc, freq_level, &cur_pos[l], &pos_inc[l]);
+                n_frac_bits[l] = osc->wave.n_frac_bits;
+                frac_bitmask[l] = osc->wave.frac_bitmask;
+                ifrac_to_float[l] = osc->wave.ifrac_to_float;
+                values[l] = osc->wave.values;
+                last_freq_level[l] = freq_level;
+              }
+          }
+      for (l = 0; l < LANES; l++)
+        {
+          const guint32 tpos = cur_pos[l] >> n_frac_bits[l];
+          const guint32 ifrac = cur_pos[l] & frac_bitmask[l];
+          const gfloat ffrac = ifrac * ifrac_to_float[l];
+          gfloat a = values[l][tpos], b = values[l][tpos + 1];
+          a *= 1.0 - ffrac;
+          b *= ffrac;
+          v[l] = a + b;
+          cur_pos[l] += pos_inc[l];
+        }
+      for (l = 0; l < n_lanes; l++)
+        mono_out[l][i] = v[l];
+    }
+  for (l = 0; l < n_lanes; l++)
+    {
+      GslOscData *osc = oscs[l];
+      osc->cur_pos = cur_pos[l];
+      osc->last_pos = cur_pos[l];
+      osc->last_freq_level = last_freq_level[l];
+    }
+}
+
+/**
+ * @param n_lanes	number of oscillators
+ * @param oscs		oscillators to process
+ * @param n_values	number of values to generate per lane
+ * @param ifreq		frequency signals, one per lane, NULL entries use the configured frequency
+ * @param mono_out	output signals, one per lane
+ *
+ * Process several oscillators without modulation, sync or pulse width
+ * inputs at once, the same as calling gsl_osc_process() for each of them.
+ * Oscillator positions are kept in structure-of-arrays form, so each
+ * sample step interpolates the wave tables of four oscillators with SIMD
+ * instructions. Oscillators with self modulation are processed individually.
+ */
+void
+gsl_osc_process_lanes (guint          n_lanes,
+                       GslOscData   **oscs,
+                       guint          n_values,
+                       const gfloat **ifreq,
+                       gfloat       **mono_out)
+{
+  enum { LANES = 4 };
+  GslOscData *goscs[LANES];
+  const gfloat *gfreq[LANES];
+  gfloat *gout[LANES];
+  guint n = 0;
+
+  assert_return (oscs != NULL && ifreq != NULL && mono_out != NULL);
+  assert_return (n_values > 0);
+
+  for (guint l = 0; l < n_lanes; l++)
+    {
+      GslOscData *osc = oscs[l];
+      if (osc->last_mode & OSC_FLAG_PULSE_OSC)
+        osc->last_mode = OSC_FLAG_INVAL;
+      const guint mode = osc_mode (osc, 0, ifreq[l], NULL, NULL, NULL, NULL);
+      if (mode & ~OSC_FLAG_FREQ)
+        {
+          osc_process (osc, n_values, 0, ifreq[l], NULL, NULL, NULL, mono_out[l], NULL);
+          continue;
+        }
+      osc_update_mode (osc, mode);
+      goscs[n] = osc;
+      gfreq[n] = ifreq[l];
+      gout[n] = mono_out[l];
+      if (++n == LANES)
+        {
+          osc_process_lane_group (n, goscs, n_values, gfreq, gout);
+          n = 0;
+        }
+    }
+  if (n)
+    osc_process_lane_group (n, goscs, n_values, gfreq, gout);
+}
+
 void
 gsl_osc_config (GslOscData   *osc,
 		GslOscConfig *config)
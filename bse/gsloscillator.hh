@@ -54,6 +54,11 @@ void	gsl_osc_process_pulse	(GslOscData	*osc,
 				 const gfloat	*ipwm,
 				 gfloat		*mono_out,
 				 gfloat		*sync_out);
+void	gsl_osc_process_lanes	(guint		 n_lanes,
+				 GslOscData	**oscs,
+				 guint		 n_values,
+				 const gfloat	**ifreq,
+				 gfloat		**mono_out);
 
 
 
@@ -160,9 +160,150 @@ make_pitch_bend (uint16 chnl, float val)
 }
 
 // == EventStream ==
-EventStream::EventStream ()
+struct alignas (FastMemory::cache_line_size) EventStream::Chunk {
+  Chunk  *next = nullptr;
+  Chunk  *prev = nullptr;
+  uint32  length = 0;
+  Event*       events ()       { return reinterpret_cast<Event*> (this + 1); }
+  const Event* events () const { return reinterpret_cast<const Event*> (this + 1); }
+  static Chunk*
+  create (Chunk *prev)
+  {
+    static_assert (sizeof (Chunk) % alignof (Event) == 0);
+    void *mem = fast_mem_alloc (sizeof (Chunk) + CHUNK_EVENTS * sizeof (Event));
+    Chunk *chunk = new (mem) Chunk();
+    chunk->prev = prev;
+    if (prev)
+      prev->next = chunk;
+    return chunk;
+  }
+  static void
+  destroy (Chunk *chunk)
+  {
+    chunk->~Chunk();
+    fast_mem_free (chunk);
+  }
+};
+
+EventStream::const_iterator&
+EventStream::const_iterator::operator++ ()
+{
+  ++event_;
+  if (BSE_UNLIKELY (event_ == chunk_->events() + chunk_->length) &&
+      chunk_->next && chunk_->next->length)
+    {
+      chunk_ = chunk_->next;
+      event_ = chunk_->events();
+    }
+  return *this;
+}
+
+/// Create an EventStream with room for at least `n_reserved` events.
+EventStream::EventStream (size_t n_reserved)
+{
+  reserve (n_reserved);
+}
+
+EventStream::~EventStream ()
+{
+  while (head_)
+    {
+      Chunk *chunk = head_;
+      head_ = chunk->next;
+      Chunk::destroy (chunk);
+    }
+  tail_ = nullptr;
+  if (scratch_)
+    fast_mem_free (scratch_);
+  scratch_ = nullptr;
+  scratch_size_ = 0;
+}
+
+EventStream::const_iterator
+EventStream::begin () const noexcept
+{
+  return head_ ? const_iterator (head_, head_->events()) : const_iterator();
+}
+
+EventStream::const_iterator
+EventStream::end () const noexcept
+{
+  return tail_ ? const_iterator (tail_, tail_->events() + tail_->length) : const_iterator();
+}
+
+/// Number of events that can be stored without allocating.
+size_t
+EventStream::capacity () const noexcept
+{
+  size_t n = 0;
+  for (const Chunk *chunk = head_; chunk; chunk = chunk->next)
+    n += CHUNK_EVENTS;
+  return n;
+}
+
+/// Remove all events, retains all allocated chunks for reuse.
+void
+EventStream::clear () noexcept
+{
+  for (Chunk *chunk = head_; chunk && chunk->length; chunk = chunk->next)
+    chunk->length = 0;
+  tail_ = head_;
+  size_ = 0;
+}
+
+/// Preallocate chunks for at least `n_events`, should be called outside of render().
+void
+EventStream::reserve (size_t n_events)
+{
+  Chunk *last = tail_;
+  while (last && last->next)
+    last = last->next;
+  for (size_t n = capacity(); n < n_events; n += CHUNK_EVENTS)
+    {
+      last = Chunk::create (last);
+      if (!head_)
+        head_ = tail_ = last;
+    }
+  reserve_scratch (capacity());
+}
+
+// Provide room for sorting `n_events`, only allocates if the stream outgrew its reservation.
+void
+EventStream::reserve_scratch (size_t n_events)
 {
-  events_.reserve (16);
+  if (BSE_ISLIKELY (n_events <= scratch_size_))
+    return;
+  n_events = (n_events + CHUNK_EVENTS - 1) / CHUNK_EVENTS * CHUNK_EVENTS;
+  if (scratch_)
+    fast_mem_free (scratch_);
+  scratch_ = reinterpret_cast<Event*> (fast_mem_alloc (n_events * sizeof (Event)));
+  scratch_size_ = n_events;
+}
+
+// Chain the next chunk, only allocates once all preallocated chunks are used up.
+void
+EventStream::grow ()
+{
+  if (!tail_)
+    {
+      head_ = tail_ = Chunk::create (nullptr);
+      return;
+    }
+  if (!tail_->next)
+    {
+      EDEBUG ("EventStream: %p: overflow, chaining chunk beyond %u events", this, size_);
+      Chunk::create (tail_);
+    }
+  tail_ = tail_->next;
+}
+
+Event*
+EventStream::alloc_event ()
+{
+  if (BSE_UNLIKELY (!tail_ || tail_->length >= CHUNK_EVENTS))
+    grow();
+  size_++;
+  return tail_->events() + tail_->length++;
 }
 
 /// Append an Event with conscutive `frame` time stamp.
@@ -178,26 +319,90 @@ EventStream::append (int8_t frame, const Event &event)
 bool
 EventStream::append_unsorted (int8_t frame, const Event &event)
 {
-  const int64_t last_event_stamp = !events_.empty() ? events_.back().frame : -128;
-  events_.push_back (event);
-  events_.back().frame = frame;
+  const int64_t last_event_stamp = last_frame();
+  Event *ev = alloc_event();
+  *ev = event;
+  ev->frame = frame;
   return frame < last_event_stamp;
 }
 
 /// Fix event order after append_unsorted() returned `true`.
+/// Uses a stable counting sort over the 256 possible frame offsets, which is linear
+/// in the number of events and works on a scratch buffer retained with the chunks.
 void
 EventStream::ensure_order ()
 {
-  std::stable_sort (events_.begin(), events_.end(), [] (const Event &a, const Event &b) -> bool {
-    return a.frame < b.frame;
-  });
+  return_unless (size_ > 1);
+  reserve_scratch (size_);
+  uint32 offsets[256] = { 0, };
+  for (Chunk *chunk = head_; chunk && chunk->length; chunk = chunk->next)
+    for (uint32 i = 0; i < chunk->length; i++)
+      offsets[uint8 (chunk->events()[i].frame + 128)]++;
+  uint32 start = 0;
+  for (size_t f = 0; f < 256; f++)
+    {
+      const uint32 count = offsets[f];
+      offsets[f] = start;
+      start += count;
+    }
+  for (Chunk *chunk = head_; chunk && chunk->length; chunk = chunk->next)
+    for (uint32 i = 0; i < chunk->length; i++)
+      {
+        const Event &ev = chunk->events()[i];
+        memcpy ((void*) &scratch_[offsets[uint8 (ev.frame + 128)]++], &ev, sizeof (Event));
+      }
+  const Event *src = scratch_;
+  for (Chunk *chunk = head_; chunk && chunk->length; chunk = chunk->next)
+    {
+      memcpy ((void*) chunk->events(), src, chunk->length * sizeof (Event));
+      src += chunk->length;
+    }
+}
+
+/// Append the events of several sorted streams in frame order, without a full sort.
+/// Events with equal frames keep the order given by the `estreams` array.
+void
+EventStream::merge (const EventStream *const *estreams, size_t n_estreams)
+{
+  struct Cursor {
+    const_iterator it, end;
+    size_t nth;
+  };
+  // min-heap ordered by (frame, nth)
+  const auto cursor_greater = [] (const Cursor &a, const Cursor &b) {
+    return a.it->frame > b.it->frame || (a.it->frame == b.it->frame && a.nth > b.nth);
+  };
+  return_unless (n_estreams > 0);
+  BSE_DECLARE_VLA (Cursor, cursors, n_estreams);
+  size_t n_cursors = 0;
+  for (size_t i = 0; i < n_estreams; i++)
+    {
+      assert_return (estreams[i] != this);
+      if (estreams[i] && !estreams[i]->empty())
+        cursors[n_cursors++] = Cursor { estreams[i]->begin(), estreams[i]->end(), i };
+    }
+  std::make_heap (&cursors[0], &cursors[n_cursors], cursor_greater);
+  bool must_sort = false;
+  while (n_cursors)
+    {
+      std::pop_heap (&cursors[0], &cursors[n_cursors], cursor_greater);
+      Cursor &cursor = cursors[n_cursors - 1];
+      must_sort |= append_unsorted (cursor.it->frame, *cursor.it);
+      ++cursor.it;
+      if (cursor.it != cursor.end)
+        std::push_heap (&cursors[0], &cursors[n_cursors], cursor_greater);
+      else
+        n_cursors--;
+    }
+  if (must_sort)                // only if prior contents were not aligned with the merged events
+    ensure_order();
 }
 
 /// Fetch the latest event stamp, can be used to enforce order.
 int64_t
 EventStream::last_frame () const
 {
-  return !events_.empty() ? events_.back().frame : -128;
+  return tail_ && tail_->length ? tail_->events()[tail_->length - 1].frame : -128;
 }
 
 // == EventRange ==
@@ -207,3 +412,71 @@ EventRange::EventRange (const EventStream &estream) :
 
 } // AudioSignal
 } // Bse
+
+#include "testing.hh"
+
+namespace { // Anon
+using namespace Bse;
+using namespace Bse::AudioSignal;
+
+BSE_INTEGRITY_TEST (bse_event_stream_ordering);
+static void
+bse_event_stream_ordering()
+{
+  constexpr size_t DENSE_EVENTS_PER_BLOCK = 10000;      // dense MIDI controller automation
+  EventStream estream;
+  bool must_sort = false;
+  for (size_t i = 0; i < DENSE_EVENTS_PER_BLOCK; i++)
+    must_sort |= estream.append_unsorted (int (i * 128 / DENSE_EVENTS_PER_BLOCK) - 128 + (i % 7 == 3 ? -5 : 0),
+                                          make_control (1, i & 0x7f, 0.5));
+  TASSERT (must_sort);
+  TCMP (estream.size(), ==, DENSE_EVENTS_PER_BLOCK);
+  estream.ensure_order();
+  int64_t last = -128;
+  size_t n = 0;
+  for (const auto &ev : estream)
+    {
+      TCMP (ev.frame, >=, last);
+      last = ev.frame;
+      n++;
+    }
+  TCMP (n, ==, DENSE_EVENTS_PER_BLOCK);
+  const size_t capacity = estream.capacity();
+  estream.clear();
+  TASSERT (estream.empty() && estream.begin() == estream.end());
+  TCMP (estream.capacity(), ==, capacity);     // chunks are retained
+  // stable order for equal frames
+  for (int i = 0; i < 300; i++)
+    estream.append_unsorted (-(i % 3), make_control (1, i, 0.5));
+  estream.ensure_order();
+  last = -128;
+  uint last_param = 0;
+  for (const auto &ev : estream)
+    {
+      TASSERT (ev.frame > last || ev.param > last_param);
+      last = ev.frame;
+      last_param = ev.param;
+    }
+  estream.clear();
+  // k-way merge, ties resolved by producer order
+  EventStream e1, e2, e3 (0);
+  for (int i = 0; i < 700; i++)
+    e1.append (i / 6 - 120, make_control (1, 7, 0.5));
+  for (int i = 0; i < 300; i++)
+    e2.append (i / 3 - 100, make_control (2, 7, 0.5));
+  const EventStream *producers[] = { &e1, &e2, &e3 };
+  estream.merge (producers, 3);
+  TCMP (estream.size(), ==, 1000);
+  last = -128;
+  uint last_channel = 0;
+  for (const auto &ev : estream)
+    {
+      TCMP (ev.frame, >=, last);
+      if (ev.frame == last)
+        TCMP (ev.channel, >=, last_channel);
+      last = ev.frame;
+      last_channel = ev.channel;
+    }
+}
+
+} // Anon
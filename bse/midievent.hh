@@ -83,30 +83,68 @@ Event make_program    (uint16 chnl, uint prgrm);
 Event make_pitch_bend (uint16 chnl, float val);
 
 /// A stream of writable Event structures.
+/// Events are stored in a chain of cache line aligned chunks that are retained across clear(),
+/// so a stream that has seen a block's worth of events once can be refilled without allocations.
 class EventStream {
-  std::vector<Event> events_; // TODO: use O(1) allocator
+  struct Chunk;
+  Chunk   *head_ = nullptr;     // first chunk, preallocated
+  Chunk   *tail_ = nullptr;     // chunk receiving appends, chunks after tail_ are empty spares
+  size_t   size_ = 0;
+  Event   *scratch_ = nullptr;      // ensure_order() sort buffer, sized along with the chunks
+  size_t   scratch_size_ = 0;
+  Event*   alloc_event     ();
+  void     grow            ();
+  void     reserve_scratch (size_t n_events);
   friend class EventRange;
+  BSE_CLASS_NON_COPYABLE (EventStream);
 public:
-  explicit     EventStream     ();
-  void         append          (int8_t frame, const Event &event);
-  const Event* begin           () const noexcept { return &*events_.begin(); }
-  const Event* end             () const noexcept { return &*events_.end(); }
-  size_t       size            () const noexcept { return events_.size(); }
-  bool         empty           () const noexcept { return events_.empty(); }
-  void         clear           () noexcept       { events_.clear(); }
-  bool         append_unsorted (int8_t frame, const Event &event);
-  void         ensure_order    ();
-  int64_t      last_frame      () const BSE_PURE;
+  /// Number of events that fit into a single chunk.
+  static constexpr size_t CHUNK_EVENTS = 256;
+  /// Forward iterator over all events in a stream.
+  class const_iterator {
+    const Chunk *chunk_ = nullptr;
+    const Event *event_ = nullptr;
+    friend class EventStream;
+    explicit     const_iterator (const Chunk *chunk, const Event *event) : chunk_ (chunk), event_ (event) {}
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Event;
+    using difference_type = ptrdiff_t;
+    using pointer = const Event*;
+    using reference = const Event&;
+    /*ctor*/        const_iterator () = default;
+    const Event&    operator*      () const     { return *event_; }
+    const Event*    operator->     () const     { return event_; }
+    bool            operator==     (const const_iterator &o) const { return event_ == o.event_; }
+    bool            operator!=     (const const_iterator &o) const { return event_ != o.event_; }
+    const_iterator& operator++     ();
+    const_iterator  operator++     (int)        { const_iterator old = *this; ++*this; return old; }
+  };
+  explicit       EventStream     (size_t n_reserved = CHUNK_EVENTS);
+  /*dtor*/      ~EventStream     ();
+  void           append          (int8_t frame, const Event &event);
+  const_iterator begin           () const noexcept;
+  const_iterator end             () const noexcept;
+  size_t         size            () const noexcept { return size_; }
+  bool           empty           () const noexcept { return size_ == 0; }
+  size_t         capacity        () const noexcept;
+  void           clear           () noexcept;
+  void           reserve         (size_t n_events);
+  bool           append_unsorted (int8_t frame, const Event &event);
+  void           ensure_order    ();
+  void           merge           (const EventStream *const *estreams, size_t n_estreams);
+  int64_t        last_frame      () const BSE_PURE;
 };
 
 /// A readonly view and iterator into an EventStream.
 class EventRange {
   const EventStream &estream_;
 public:
-  const Event* begin          () const  { return &*estream_.begin(); }
-  const Event* end            () const  { return &*estream_.end(); }
-  size_t       events_pending () const  { return estream_.size(); }
-  explicit     EventRange     (const EventStream &estream);
+  using const_iterator = EventStream::const_iterator;
+  const_iterator begin          () const  { return estream_.begin(); }
+  const_iterator end            () const  { return estream_.end(); }
+  size_t         events_pending () const  { return estream_.size(); }
+  explicit       EventRange     (const EventStream &estream);
 };
 
 } // AudioSignal
@@ -38,7 +38,7 @@ class MidiInputImpl : public MidiInputIface {
   double block_tick_ = 0; // tick count at block boundary, (past) BPM dependent
   int64_t clip_tick_ = 0; // tick counter within clip start..end
   int64_t clip_end_ = 0;
-  const Event *midi_through = nullptr, *midi_through_end = nullptr;
+  EventRange::const_iterator midi_through, midi_through_end;
   bool loop_clip_ = true;
 public:
   MidiInputImpl()
@@ -62,6 +62,18 @@ public:
           clip_tick_ = clip_end_;
       }
   }
+  int64_t
+  playback_start () const override
+  {
+    return start_frame;
+  }
+  int64_t
+  loop_frames () const override
+  {
+    const double bpm = peek_param_mt (BPM);
+    return_unless (bpm >= MINBPM, 0);
+    return clip_end_ * sample_rate() / (PPQ * bpm / 60.0);
+  }
   void
   query_info (ProcessorInfo &info) const override
   {
@@ -99,8 +111,8 @@ public:
     bpm_ = 0;
     frame2tick_ = 0;
     tick2frame_ = 0;
-    midi_through = nullptr;
-    midi_through_end = nullptr;
+    midi_through = {};
+    midi_through_end = {};
     assert_return (sample_rate() >= MINRATE && sample_rate() <= MAXRATE);
   }
   void
@@ -197,7 +209,7 @@ public:
     assert_return (frame >= -128 && frame <= 127);
     EventStream &evout = get_event_output();
     // interleave with earlier MIDI through events
-    while (midi_through < midi_through_end && midi_through->frame <= frame)
+    while (midi_through != midi_through_end && midi_through->frame <= frame)
       {
         evout.append (midi_through->frame, *midi_through);
         midi_through++;
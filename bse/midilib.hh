@@ -14,7 +14,9 @@ using ClipEventVectorP = ClipImpl::OrderedEventsP;
 class MidiInputIface : public AudioSignal::Processor {
 public:
   constexpr static ParamId BPM = ParamId (1);
-  virtual void swap_event_vector (ClipEventVectorP &cev) = 0;
+  virtual void    swap_event_vector (ClipEventVectorP &cev) = 0;
+  virtual int64_t playback_start    () const = 0; ///< Engine frame that corresponds to clip tick 0.
+  virtual int64_t loop_frames       () const = 0; ///< Length of a clip iteration in frames.
 };
 
 using MidiInputIfaceP = std::shared_ptr<MidiInputIface>;
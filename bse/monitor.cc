@@ -201,7 +201,7 @@ static const BseModuleClass monitor_module_class = {
   NULL,                         // process_defer
   NULL,                         // reset
   NULL,                         // free
-  Bse::ModuleFlag::NORMAL,      // mflags
+  Bse::ModuleFlag::SHEDDABLE,   // mflags, meters may lag under DSP overload
 };
 
 #define MIN_DB_SPL      -140    // -140dB is beyond float mantissa precision
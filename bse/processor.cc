@@ -3,6 +3,9 @@
 #include "property.hh"
 #include "bseserver.hh"
 #include "combo.hh"
+#include "bseengine.hh"
+#include "enginecapture.hh"
+#include "randomhash.hh"
 #include "internal.hh"
 #include <shared_mutex>
 
@@ -376,6 +379,9 @@ struct ProcessorRegistryContext {
   Engine *engine = nullptr;
 };
 static __thread ProcessorRegistryContext *processor_ctor_registry_context = nullptr;
+static std::mutex processor_instances_mutex;
+static std::vector<Processor*> processor_instances;     // in order of instantiation
+static struct { std::atomic<uint64> delivered, coalesced, dropped; } notify_counters;
 
 /// Constructor for Processor
 Processor::Processor() :
@@ -389,6 +395,13 @@ Processor::Processor() :
 Processor::~Processor ()
 {
   remove_all_buses();
+  if (urihash_)
+    {
+      std::lock_guard<std::mutex> locker (processor_instances_mutex);
+      auto it = std::find (processor_instances.begin(), processor_instances.end(), this);
+      if (it != processor_instances.end())
+        processor_instances.erase (it);
+    }
 }
 
 /// Create the `Bse::ProcessorIface` for `this`.
@@ -546,6 +559,7 @@ Processor::add_param (Id32 id, const ParamInfo &infotmpl, double value)
     binary_lookup_insertion_pos (params_.begin(), params_.end(), PParam::cmp, param);
   assert_return (existing_parameter_position.second == false, {});
   params_.insert (existing_parameter_position.first, std::move (param));
+  EngineCapture::PlaybackScope playback;      // defaults are recreated by loading the project
   set_param (param.id, value); // forces dirty
   return param.id;
 }
@@ -710,7 +724,26 @@ Processor::set_param (Id32 paramid, const double value)
           v = CLAMP (mm.first + v, mm.first, mm.second);
         }
     }
-  const_cast<PParam*> (pparam)->assign (v);
+  if (EngineCapture::active())
+    {
+      EngineCapture::Record rec;
+      rec.kind = EngineCapture::Kind::PARAM;
+      rec.channel = uint8 (EngineCapture::origin());
+      rec.id16 = uri_nth_;
+      rec.id32 = paramid.id;
+      rec.key = urihash_;
+      rec.stamp = Bse::TickStamp::current();
+      rec.value = v;
+      EngineCapture::record (rec);
+    }
+  PParam *mparam = const_cast<PParam*> (pparam);
+  if (mparam->assign (v) && BSE_UNLIKELY (mparam->must_notify()))
+    {
+      if (mparam->mark_updated_mt())
+        enqueue_notify_mt (PARAMCHANGE);
+      else
+        notify_counters.coalesced++;    // notification for this parameter still pending
+    }
 }
 
 /// Retrieve supplemental information for parameters, usually to enhance the user interface.
@@ -899,7 +932,7 @@ Processor::prepare_event_input ()
   estreams_->has_event_input = true;
 }
 
-static const EventStream empty_event_stream; // dummy
+static const EventStream empty_event_stream (0); // dummy
 
 /// Access the current input EventRange during render(), needs prepare_event_input().
 EventRange
@@ -1212,11 +1245,12 @@ Processor::ensure_initialized()
     }
 }
 
-/// Reset all voices, buffers and other internal state
+/// Reset all voices, buffers and other internal state.
+/// Processors that already rendered ahead of the Engine (see Engine::AheadFrame) keep their state.
 void
 Processor::reset_state()
 {
-  if (done_frames_ != engine_.frame_counter())
+  if (done_frames_ < engine_.frame_counter())
     {
       if (estreams_)
         estreams_->estream.clear();
@@ -1225,6 +1259,17 @@ Processor::reset_state()
     }
 }
 
+// Reset a processor that rendered ahead of the Engine, so it continues at the Engine frame.
+void
+Processor::rewind_state()
+{
+  if (done_frames_ > engine_.frame_counter())
+    {
+      done_frames_ = 0;
+      reset_state();
+    }
+}
+
 /// Reset all state variables.
 void
 Processor::reset()
@@ -1265,10 +1310,38 @@ Processor::render_block ()
   return_unless (done_frames_ < engine_frame_counter);
   if (BSE_UNLIKELY (estreams_) && !BSE_ISLIKELY (estreams_->estream.empty()))
     estreams_->estream.clear();
-  render (MAX_RENDER_BLOCK_SIZE);
+  if (BSE_UNLIKELY (sheddable()) && bse_engine_dsp_degraded (DspPriority::SHEDDABLE))
+    {
+      // shed processors output silence, they must not feed audible signal paths
+      for (size_t b = 0; b < n_obuses(); b++)
+        for (size_t c = 0; c < n_ochannels (OBusId (1 + b)); c++)
+          assign_oblock (OBusId (1 + b), c, 0.0);
+    }
+  else
+    render (MAX_RENDER_BLOCK_SIZE);
   done_frames_ = engine_frame_counter;
 }
 
+/// Assign the class of work this processor performs, processors are DspPriority::ESSENTIAL by default.
+/// SHEDDABLE processors output silence and REDUCIBLE processors should check reduced_quality() under DSP overload.
+void
+Processor::set_priority (DspPriority priority)
+{
+  flags_ &= ~(SHEDDABLE | REDUCIBLE);
+  if (priority == DspPriority::SHEDDABLE)
+    flags_ |= SHEDDABLE;
+  else if (priority == DspPriority::REDUCIBLE)
+    flags_ |= REDUCIBLE;
+}
+
+/// Indicates that the engine exceeds its DSP budget and REDUCIBLE processors should lower
+/// their rendering quality, e.g. by reducing oversampling or unison voices.
+bool
+Processor::reduced_quality () const
+{
+  return (flags_ & REDUCIBLE) && bse_engine_dsp_degraded (DspPriority::REDUCIBLE);
+}
+
 /// Invoke Processor::configure() with `ipatch`/`opatch` applied to the current configuration.
 void
 Processor::reconfigure (IBusId ibusid, SpeakerArrangement ipatch, OBusId obusid, SpeakerArrangement opatch)
@@ -1312,19 +1385,58 @@ Processor::reconfigure (IBusId ibusid, SpeakerArrangement ipatch, OBusId obusid,
   configure (n_ibuses(), sai, n_obuses(), sao);
   delete[] sai;
   assign_iobufs();
+  rewind_state();       // the new configuration needs a reset, also if rendered ahead
   reset_state();
 }
 
 static Processor        *const notifies_tail = (Processor*) ptrdiff_t (-1);
 static std::atomic<Processor*> notifies_head { notifies_tail };
+static std::atomic<uint>       notifies_interval_us { 16 * 1000 };     // coalescing window, ~60Hz
+static uint64                  notifies_last_delivery = 0;             // BSE thread only
+
+/// Retrieve counters about notification delivery, MT-Safe.
+Processor::NotifyStats
+Processor::notify_stats ()
+{
+  NotifyStats stats;
+  stats.delivered = notify_counters.delivered;
+  stats.coalesced = notify_counters.coalesced;
+  stats.dropped = notify_counters.dropped;
+  return stats;
+}
+
+/// Set the minimum time between notification batches, notifications in between are coalesced.
+void
+Processor::notify_interval_ms (uint milliseconds)
+{
+  notifies_interval_us = milliseconds * 1000;
+}
+
+/// Retrieve the minimum time between notification batches.
+uint
+Processor::notify_interval_ms ()
+{
+  return notifies_interval_us / 1000;
+}
 
 void
 Processor::enqueue_notify_mt (uint32 pushmask)
 {
-  return_unless (!bproc_.expired());            // need a means to report notifications
+  if (bproc_.expired())                         // need a means to report notifications
+    {
+      notify_counters.dropped++;
+      if (pushmask & PARAMCHANGE)
+        for (PParam &pparam : params_)
+          pparam.clear_updated();               // nothing pending, so later changes are notified again
+      return;
+    }
   assert_return (notifies_head != nullptr);     // paranoid
   const uint32 prev = flags_.fetch_or (pushmask & NOTIFYMASK);
-  return_unless (prev != (prev | pushmask));    // nothing new
+  if (prev == (prev | pushmask))                // nothing new
+    {
+      notify_counters.coalesced++;
+      return;
+    }
   Processor *expected = nullptr;
   if (nqueue_next_.compare_exchange_strong (expected, notifies_tail))
     {
@@ -1338,10 +1450,13 @@ Processor::enqueue_notify_mt (uint32 pushmask)
     }
 }
 
+/// Deliver pending notifications in a batch, unless the last batch is more recent than the coalescing window.
 void
 Processor::call_notifies_e ()
 {
   assert_return (this_thread_is_bse());
+  return_unless (notifies_timeout_e() == 0);
+  notifies_last_delivery = timestamp_realtime();
   Processor *head = notifies_head.exchange (notifies_tail);
   while (head != notifies_tail)
     {
@@ -1352,26 +1467,50 @@ Processor::call_notifies_e ()
       const uint32 nflags = NOTIFYMASK & current->flags_.fetch_and (~NOTIFYMASK);
       assert_warn (procp != nullptr);
       Bse::ProcessorImplP bprocp = current->bproc_.lock();
-      if (bprocp)
+      if (!bprocp)
         {
-          if (nflags & BUSCONNECT)
-            bprocp->emit_event ("bus:connect");
-          if (nflags & BUSDISCONNECT)
-            bprocp->emit_event ("bus:disconnect");
-          if (nflags & INSERTION)
-            bprocp->emit_event ("sub:insert");
-          if (nflags & REMOVAL)
-            bprocp->emit_event ("sub:remove");
-          if (nflags & PARAMCHANGE)
-            bprocp->emit_event ("notify:paramchange"); // FIXME
+          notify_counters.dropped += __builtin_popcount (nflags);
+          continue;
         }
+      if (nflags & BUSCONNECT)
+        bprocp->emit_event ("bus:connect");
+      if (nflags & BUSDISCONNECT)
+        bprocp->emit_event ("bus:disconnect");
+      if (nflags & INSERTION)
+        bprocp->emit_event ("sub:insert");
+      if (nflags & REMOVAL)
+        bprocp->emit_event ("sub:remove");
+      notify_counters.delivered += __builtin_popcount (nflags & ~PARAMCHANGE);
+      if (nflags & PARAMCHANGE)
+        for (PParam &pparam : current->params_)
+          if (pparam.has_updated())
+            {
+              pparam.clear_updated();   // reset before callbacks, so new changes are queued again
+              if (pparam.must_notify() && pparam.info)
+                {
+                  pparam.info->call_notify();
+                  notify_counters.delivered++;
+                }
+              else
+                notify_counters.dropped++;
+            }
     }
 }
 
 bool
 Processor::has_notifies_e ()
 {
-  return notifies_head != notifies_tail;
+  return notifies_timeout_e() == 0;
+}
+
+/// Milliseconds until pending notifications are due, 0 if due, -1 without pending notifications.
+int
+Processor::notifies_timeout_e ()
+{
+  return_unless (notifies_head != notifies_tail, -1);
+  const uint64 due = notifies_last_delivery + notifies_interval_us;
+  const uint64 now = timestamp_realtime();
+  return now >= due ? 0 : (due - now + 999) / 1000;
 }
 
 // == RegistryEntry ==
@@ -1472,7 +1611,10 @@ Processor::registry_create (Engine &engine, const std::string &uuiduri)
       procp = entry->create (nullptr);
       processor_ctor_registry_context = saved;
       if (procp)
-        procp->ensure_initialized();
+        {
+          procp->ensure_initialized();
+          registry_add_instance (procp);
+        }
     }
   return procp;
 }
@@ -1487,10 +1629,40 @@ Processor::registry_create (Engine &engine, RegistryId regitry_id, const std::an
   ProcessorP procp = regitry_id.entry.create (&any);
   processor_ctor_registry_context = saved;
   if (procp)
-    procp->ensure_initialized();
+    {
+      procp->ensure_initialized();
+      registry_add_instance (procp);
+    }
   return procp;
 }
 
+// Keep track of processors per URI, so engine captures can identify processors across sessions
+void
+Processor::registry_add_instance (ProcessorP procp)
+{
+  ProcessorInfo pinfo;
+  procp->query_info (pinfo);
+  procp->urihash_ = fnv1a_consthash64 (pinfo.uri.c_str());
+  std::lock_guard<std::mutex> locker (processor_instances_mutex);
+  uint nth = 0;
+  for (Processor *proc : processor_instances)
+    if (proc->urihash_ == procp->urihash_)
+      nth = std::max (nth, proc->uri_nth_ + 1);
+  procp->uri_nth_ = nth;
+  processor_instances.push_back (procp.get());
+}
+
+/// Find the `nth` instantiated processor with a ProcessorInfo.uri of hash `urihash`, used to replay engine captures.
+ProcessorP
+Processor::registry_instance (uint64 urihash, uint nth)
+{
+  std::lock_guard<std::mutex> locker (processor_instances_mutex);
+  for (Processor *proc : processor_instances)
+    if (proc->urihash_ == urihash && proc->uri_nth_ == nth)
+      return proc->weak_from_this().lock();
+  return nullptr;
+}
+
 /// List the registry entries of all known Processor types.
 Processor::RegistryList
 Processor::registry_list()
@@ -1720,3 +1892,49 @@ ProcessorImpl::access_combo ()
 }
 
 } // Bse
+
+// == Testing ==
+#include "testing.hh"
+
+namespace { // Anon
+using namespace Bse;
+using namespace Bse::AudioSignal;
+
+BSE_INTEGRITY_TEST (bse_processor_notify_dropped);
+static void
+bse_processor_notify_dropped ()
+{
+  AudioTiming timing { 120, 0 };
+  Engine engine (48000, timing, [] () {});
+  ProcessorP proc = Processor::registry_create (engine, "Bse.DebugDsp.DbgParameterizer");
+  TASSERT (proc);
+  ParamId pid = ParamId (0);
+  for (const ParamInfoP &pinfo : proc->list_params())
+    if (pinfo->get_minmax().second >= Processor::param_peek_mt (proc, pinfo->id) + 3)
+      {
+        pid = pinfo->id;        // parameter that can be increased thrice
+        break;
+      }
+  TASSERT (pid != ParamId (0));
+  Processor::param_notifies_mt (proc, pid, true);
+  const uint saved_interval = Processor::notify_interval_ms();
+  Processor::notify_interval_ms (0);
+  // without a Bse::ProcessorImpl, notifications are dropped, repeatedly
+  Processor::NotifyStats stats = Processor::notify_stats();
+  proc->set_param (pid, Processor::param_peek_mt (proc, pid) + 1);
+  TCMP (Processor::notify_stats().dropped, ==, stats.dropped + 1);
+  proc->set_param (pid, Processor::param_peek_mt (proc, pid) + 1);
+  TCMP (Processor::notify_stats().dropped, ==, stats.dropped + 2);
+  TCMP (Processor::notify_stats().coalesced, ==, stats.coalesced);
+  // once a receiver exists, changes are queued and delivered instead of being coalesced forever
+  ProcessorImplP impl = proc->access_processor();
+  stats = Processor::notify_stats();
+  proc->set_param (pid, Processor::param_peek_mt (proc, pid) + 1);
+  TCMP (Processor::notify_stats().coalesced, ==, stats.coalesced);
+  TCMP (Processor::notify_stats().dropped, ==, stats.dropped);
+  engine.ipc_dispatch();
+  TCMP (Processor::notify_stats().delivered, >, stats.delivered);
+  Processor::notify_interval_ms (saved_interval);
+}
+
+} // Anon
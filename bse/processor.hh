@@ -12,6 +12,7 @@ namespace Bse {
 class ProcessorImpl;
 using ProcessorImplP = std::shared_ptr<ProcessorImpl>;
 class ComboImpl;
+enum class DspPriority;
 
 namespace AudioSignal {
 
@@ -206,11 +207,14 @@ protected:
   using MinMax = std::pair<double,double>;
 #endif
   enum { INITIALIZED   = 1 << 0,
+         LIVE_INPUT    = 1 << 1,
+         SHEDDABLE     = 1 << 2,
          PARAMCHANGE   = 1 << 3,
          BUSCONNECT    = 1 << 4,
          BUSDISCONNECT = 1 << 5,
          INSERTION     = 1 << 6,
-         REMOVAL       = 1 << 7, };
+         REMOVAL       = 1 << 7,
+         REDUCIBLE     = 1 << 8, };
   std::atomic<uint32>      flags_ = 0;
 private:
   uint32                   output_offset_ = 0;
@@ -233,6 +237,7 @@ private:
   const FloatBuffer& zero_buffer        ();
   void               render_block       ();
   void               reset_state        ();
+  void               rewind_state       ();
   void               enqueue_deps       ();
   /*copy*/           Processor          (const Processor&) = delete;
   virtual void       render             (uint n_frames) = 0;
@@ -245,6 +250,8 @@ protected:
   virtual void  configure         (uint n_ibuses, const SpeakerArrangement *ibuses,
                                    uint n_obuses, const SpeakerArrangement *obuses) = 0;
   void          enqueue_notify_mt (uint32 pushmask);
+  void          set_priority      (DspPriority priority);
+  bool          reduced_quality   () const;
   virtual ProcessorImplP processor_interface () const;
   // Parameters
   virtual void  adjust_param      (Id32 tag) {}
@@ -340,6 +347,8 @@ public:
   static uint64 timestamp         ();
   bool          has_event_input   ();
   bool          has_event_output  ();
+  bool          live_input        () const { return flags_ & LIVE_INPUT; } ///< Output depends on a live device.
+  bool          sheddable         () const { return flags_ & SHEDDABLE; }  ///< Rendering may be skipped under DSP overload.
   void          connect_event_input    (Processor &oproc);
   void          disconnect_event_input ();
   ProcessorImplP access_processor () const;
@@ -348,15 +357,29 @@ public:
   static ProcessorP    registry_create    (Engine &engine, const std::string &uuiduri);
   static ProcessorP    registry_create    (Engine &engine, RegistryId rid, const std::any &any);
   static RegistryId    registry_enroll    (MakeProcessor create, const char *bfile = __builtin_FILE(), int bline = __builtin_LINE());
+  static ProcessorP    registry_instance  (uint64 urihash, uint nth);
   // MT-Safe accessors
   static double param_peek_mt     (const ProcessorP proc, Id32 paramid);
   static void   param_notifies_mt (ProcessorP proc, Id32 paramid, bool need_notifies);
+  // Notification delivery
+  struct NotifyStats {
+    uint64 delivered = 0;       ///< Notifications passed on to ParamInfo callbacks and event handlers.
+    uint64 coalesced = 0;       ///< Notifications merged into an already pending notification.
+    uint64 dropped = 0;         ///< Notifications discarded for lack of a receiver.
+  };
+  static NotifyStats notify_stats       ();
+  static void        notify_interval_ms (uint milliseconds);
+  static uint        notify_interval_ms ();
 private:
   static bool   has_notifies_e    ();
+  static int    notifies_timeout_e ();
   static void   call_notifies_e   ();
   std::atomic<Processor*> nqueue_next_ { nullptr }; ///< No notifications queued while == nullptr
   ProcessorP              nqueue_guard_;            ///< Only used while nqueue_next_ != nullptr
   std::weak_ptr<Bse::ProcessorImpl> bproc_;
+  uint64                  urihash_ = 0;             ///< Hash of ProcessorInfo.uri, set by registry_create()
+  uint                    uri_nth_ = 0;             ///< Order of instantiation among processors with the same URI
+  static void   registry_add_instance (ProcessorP procp);
   static constexpr uint32 NOTIFYMASK = PARAMCHANGE | BUSCONNECT | BUSDISCONNECT | INSERTION | REMOVAL;
   static __thread uint64  tls_timestamp;
 };
@@ -377,24 +400,43 @@ class Engine {
   enum { RESCHEDULE = 1 << 0, WOKEN = 1 << 1, };
   uint               scheduler_depth_;
   std::vector<Processor*> schedule_;
+  std::vector<Processor*> *detached_ = nullptr;
   std::vector<ProcessorP> roots_;
   std::mutex              mutex_;
   std::function<void()>   wakeup_;
+  class Workers;
+  Workers                *workers_ = nullptr;
+  std::atomic<int>        render_tid_ { 0 };
+  class Anticipator;
+  Anticipator            *anticipator_ = nullptr;
+  static __thread uint64_t tls_frame_counter_;
 public:
+  using ParallelJob = void (*) (void *data, size_t nth);
+  using AheadJob = bool (*) (void *data);
+  class AheadFrame;
   const AudioTiming &timing;
   explicit      Engine           (uint32 samplerate, AudioTiming &atiming, std::function<void()> wakeup);
+  /*dtor*/     ~Engine           ();
   uint          sample_rate      () const BSE_CONST      { return sample_rate_; }
   double        nyquist          () const BSE_CONST      { return nyquist_; }
   double        inyquist         () const BSE_CONST      { return inyquist_; }
-  uint64_t      frame_counter    () const                { return frame_counter_; }
+  uint64_t      frame_counter    () const                { return BSE_UNLIKELY (tls_frame_counter_) ? tls_frame_counter_ : frame_counter_; }
   void          add_root         (ProcessorP rootproc);
   bool          del_root         (ProcessorP rootproc);
   bool          in_schedule      (Processor &proc);
   void          enqueue          (Processor &proc);
+  void          enqueue_detached (Processor &proc, std::vector<Processor*> &subschedule);
+  void          start_workers    (uint n_threads = 0);
+  void          parallel_for     (size_t n_jobs, ParallelJob job, void *data);
+  bool          independent      (Processor &owner, const std::vector<Processor*> &subschedule);
+  void          add_ahead_job    (AheadJob job, void *data);
+  void          del_ahead_job    (void *data);
+  void          suspend_ahead    ();
   void          reschedule       ();
   void          make_schedule    ();
   void          render_block     ();
   bool          ipc_pending      ();
+  int           ipc_timeout      ();
   void          ipc_dispatch     ();
   void          ipc_wakeup_mt    ();
 };
@@ -417,6 +459,13 @@ class Processor::FloatBuffer {
   float             *buffer = &fblock[0];
 };
 
+/// Scope guard to render ahead of time, frame_counter() yields `frame` in the current thread.
+class Engine::AheadFrame {
+public:
+  explicit AheadFrame (uint64_t frame)  { tls_frame_counter_ = frame; }
+  /*dtor*/ ~AheadFrame ()               { tls_frame_counter_ = 0; }
+};
+
 // == ProcessorManager ==
 /// Interface for management, connecting and processing of Processor instances.
 class ProcessorManager {
@@ -430,6 +479,8 @@ protected:
                                    { return iproc.connect_event_input (oproc); }
   static auto pm_reconfigure       (Processor &p, IBusId i, SpeakerArrangement ip, OBusId o, SpeakerArrangement op)
                                    { return p.reconfigure (i, ip, o, op); }
+  static auto pm_render_block      (Processor &p)       { return p.render_block(); }
+  static auto pm_rewind_state      (Processor &p)       { return p.rewind_state(); }
 };
 
 // == Inlined Internals ==
@@ -475,15 +526,20 @@ struct Processor::PParam {
   bool     has_updated     () const { return flags_ & 2; }
   void     mark_updated    ()       { flags_ |= 2; }
   void     clear_updated   ()       { flags_ &= ~uint32 (2); }
+  bool     mark_updated_mt ()       { return !(flags_.fetch_or (2) & 2); }
   void     must_notify_mt  (bool n) { if (n) flags_ |= 4; else flags_ &= ~uint32 (4); }
   bool     must_notify     () const { return flags_ & 4; }
-  void
+  bool
   assign (double f)
   {
     const double old = value_;
     value_ = f;
     if (BSE_ISLIKELY (old != value_))
-      mark_dirty();
+      {
+        mark_dirty();
+        return true;
+      }
+    return false;
   }
   static int // Helper to keep PParam structures sorted.
   cmp (const PParam &a, const PParam &b)
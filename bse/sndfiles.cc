@@ -1,7 +1,10 @@
 // Licensed GNU LGPL v2.1 or later: http://www.gnu.org/licenses/lgpl.html
 #include "sndfiles.hh"
 #include "bse/gsldatautils.hh"
+#include "bse/bseieee754.hh"
 #include "bse/internal.hh"
+#include "bse/path.hh"
+#include <FLAC/stream_encoder.h>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -11,6 +14,24 @@
 
 namespace Bse::Snd {
 
+// == Encoder ==
+Encoder::Encoder()
+{}
+
+Encoder::~Encoder()
+{}
+
+/// Guess the FileFormat from the extension of `fname`, defaults to FileFormat::WAV.
+FileFormat
+Encoder::format_from_filename (const std::string &fname)
+{
+  const std::string lname = string_tolower (fname);
+  if (string_endswith (lname, ".flac"))
+    return FileFormat::FLAC;
+  return FileFormat::WAV;
+}
+
+// == WavWriter ==
 WavWriter::WavWriter()
 {}
 
@@ -51,30 +72,61 @@ l32 (uint32 i)
   return std::string ((const char*) &i, sizeof (i));
 }
 
+static std::string
+l64 (uint64 i)
+{
+  i = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ? i : __builtin_bswap64 (i);
+  return std::string ((const char*) &i, sizeof (i));
+}
+
+/* The header reserves a 'JUNK' chunk after 'fmt ', which has the size of a 'ds64' chunk.
+ * Files that exceed 4GB are turned into RF64 by swapping both chunks in place, so the
+ * data offset never changes and files below 4GB keep 'fmt ' at offset 12 for loaders.
+ */
 int
-WavWriter::wheader (const uint n_data_bytes)
+WavWriter::wheader (const uint64 n_data_bytes)
 {
   const uint header_offset =
-    0 /* 4 + 4 */ +                     // 'RIFF' header is omitted
-    4 + 4 + 4 + 2 + 2 + 4 + 4 + 2 + 2 + // 'fmt ' header
+    4 +                                 // 'WAVE'
+    4 + 4 + 16 +                        // 'fmt ' chunk
+    4 + 4 + 28 +                        // 'JUNK' or 'ds64' chunk
     4 + 4;                              // 'data' header
-  const uint file_length = header_offset + n_data_bytes;
+  const uint64 riff_length = header_offset + n_data_bytes;
+  const bool rf64 = riff_length > 0xffffffff;
   const uint byte_per_sample = n_bits_ / 8 * n_channels_;
   const uint byte_per_second = byte_per_sample * sample_rate_;
+  std::string fmt;                      // 'fmt ' chunk
+  fmt += "fmt ";                        // sub_chunk
+  fmt += l32 (16);                      // sub_chunk_length
+  fmt += l16 (n_bits_ == 32 ? 3 : 1);   // format (1=PCM, 3=IEEE float)
+  fmt += l16 (n_channels_);             // n_channels
+  fmt += l32 (sample_rate_);            // sample_freq
+  fmt += l32 (byte_per_second);         // byte_per_second
+  fmt += l16 (byte_per_sample);         // byte_per_sample
+  fmt += l16 (n_bits_);                 // n_bits
   std::string s; // header data string
-  s += "RIFF";                          // main_chunk
-  s += l32 (file_length);               // length in bytes of subsequent data
+  s += rf64 ? "RF64" : "RIFF";          // main_chunk
+  s += l32 (rf64 ? 0xffffffff : riff_length);   // length in bytes of subsequent data
   s += "WAVE";                          // chunk_type
-  s += "fmt ";                          // sub_chunk
-  s += l32 (16);                        // sub_chunk_length
-  s += l16 (1);                         // format (1=PCM)
-  s += l16 (n_channels_);               // n_channels
-  s += l32 (sample_rate_);              // sample_freq
-  s += l32 (byte_per_second);           // byte_per_second
-  s += l16 (byte_per_sample);           // byte_per_sample
-  s += l16 (n_bits_);                   // n_bits
+  if (rf64)
+    {
+      s += "ds64";                      // 64 bit sizes
+      s += l32 (28);                    // sub_chunk_length
+      s += l64 (riff_length);           // riff_size
+      s += l64 (n_data_bytes);          // data_size
+      s += l64 (n_data_bytes / byte_per_sample);        // sample_count
+      s += l32 (0);                     // table_length
+      s += fmt;
+    }
+  else
+    {
+      s += fmt;
+      s += "JUNK";                      // placeholder for 'ds64'
+      s += l32 (28);                    // sub_chunk_length
+      s += std::string (28, '\0');
+    }
   s += "data";                          // 'data' chunk
-  s += l32 (n_data_bytes);              // n_data_bytes
+  s += l32 (rf64 ? 0xffffffff : n_data_bytes);  // n_data_bytes
   off_t foff;
   do
     foff = lseek (fd_, 0, SEEK_SET);
@@ -84,7 +136,10 @@ WavWriter::wheader (const uint n_data_bytes)
       SDEBUG ("%s: WavWriter::wheader(%d,%u): write failed: %s", __FILE__, fd_, s.size(), strerror (errno));
       return -errno;
     }
-  return 0;
+  do
+    foff = lseek (fd_, 0, SEEK_END);
+  while (foff < 0 && errno == EINTR);
+  return foff < 0 ? -errno : 0;
 }
 
 int // -errno
@@ -92,39 +147,60 @@ WavWriter::open (const std::string &fname, uint n_channels, uint n_bits, uint sa
 {
   assert_return (!isopen(), -EINVAL);
   assert_return (!fname.empty(), -EINVAL);
-  assert_return (n_bits == 16 || n_bits == 8, -EINVAL);
+  assert_return (n_bits == 32 || n_bits == 24 || n_bits == 16 || n_bits == 8, -EINVAL);
   assert_return (n_channels >= 1, -EINVAL);
   assert_return (sample_rate >= 1, -EINVAL);
   fd_ = ::open (fname.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0660);
   return_unless (fd_ >= 0, -errno);
+  filename_ = fname;
   sample_rate_ = sample_rate;
   n_channels_ = n_channels;
   n_bits_ = n_bits;
+  n_values_ = 0;
   return wheader (0);
 }
 
 int // -errno
-WavWriter::write (const float *floats, uint n)
+WavWriter::write (const float *floats, size_t n)
 {
-  uint8 *dst = new uint8[n * 2]; // enough for up to 16 bit
-  auto gformat = n_bits_ > 8 ? GSL_WAVE_FORMAT_SIGNED_16 : GSL_WAVE_FORMAT_SIGNED_8;
-  const uint nbytes = gsl_conv_from_float_clip (gformat, G_BYTE_ORDER, floats, dst, n);
+  const uint bw = n_bits_ / 8;
+  if (buffer_.size() < n * bw)
+    buffer_.resize (n * bw);
+  uint8 *dst = buffer_.data();
+  size_t nbytes;
+  if (n_bits_ == 32)
+    {
+      memcpy (dst, floats, n * bw);     // conversion only handles in-place floats
+      if (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+        for (uint32 *u = (uint32*) dst, *e = u + n; u < e; u++)
+          *u = __builtin_bswap32 (*u);
+      nbytes = n * bw;
+    }
+  else
+    {
+      const GslWaveFormatType gformat = n_bits_ == 24 ? GSL_WAVE_FORMAT_SIGNED_24 :
+                                        n_bits_ == 16 ? GSL_WAVE_FORMAT_SIGNED_16 : GSL_WAVE_FORMAT_UNSIGNED_8;
+      nbytes = gsl_conv_from_float_clip (gformat, G_LITTLE_ENDIAN, floats, dst, n);
+    }
   const ssize_t l = wdata (fd_, nbytes, dst);
-  delete[] dst;
-  n_bytes_ += l == nbytes ? nbytes : 0;
-  return l == nbytes ? 0 : -EIO;
+  n_bytes_ += l == ssize_t (nbytes) ? nbytes : 0;
+  n_values_ += l == ssize_t (nbytes) ? n : 0;
+  return l == ssize_t (nbytes) ? 0 : -EIO;
 }
 
-void
+int // -errno
 WavWriter::close ()
 {
+  int err = 0;
   if (isopen())
     {
-      wheader (n_bytes_);
-      ::close (fd_);
+      err = wheader (n_bytes_);
+      if (::close (fd_) < 0 && !err)
+        err = -errno;
       fd_ = -1;
       n_bytes_ = 0;
     }
+  return err;
 }
 
 bool
@@ -139,4 +215,154 @@ WavWriter::filename () const
   return filename_;
 }
 
+// == FlacWriter ==
+class FlacWriter : public Encoder {
+  std::string         filename_;
+  FLAC__StreamEncoder *encoder_ = nullptr;
+  std::vector<FLAC__int32> ibuffer_;    // may hold an incomplete frame between write() calls
+public:
+  explicit
+  FlacWriter()
+  {}
+  ~FlacWriter()
+  {
+    close();
+  }
+  int // -errno
+  open (const std::string &fname, uint n_channels, uint n_bits, uint sample_rate)
+  {
+    assert_return (!isopen(), -EINVAL);
+    assert_return (!fname.empty(), -EINVAL);
+    assert_return (n_bits == 24 || n_bits == 16 || n_bits == 8, -EINVAL);
+    assert_return (n_channels >= 1 && n_channels <= FLAC__MAX_CHANNELS, -EINVAL);
+    assert_return (sample_rate >= 1, -EINVAL);
+    encoder_ = FLAC__stream_encoder_new();
+    return_unless (encoder_ != nullptr, -ENOMEM);
+    FLAC__stream_encoder_set_channels (encoder_, n_channels);
+    FLAC__stream_encoder_set_bits_per_sample (encoder_, n_bits);
+    FLAC__stream_encoder_set_sample_rate (encoder_, sample_rate);
+    FLAC__stream_encoder_set_compression_level (encoder_, 5);
+    errno = 0;
+    const FLAC__StreamEncoderInitStatus status = FLAC__stream_encoder_init_file (encoder_, fname.c_str(), nullptr, nullptr);
+    if (status != FLAC__STREAM_ENCODER_INIT_STATUS_OK)
+      {
+        const int err = status == FLAC__STREAM_ENCODER_INIT_STATUS_ENCODER_ERROR || !errno ? EIO : errno;
+        SDEBUG ("%s: FlacWriter::open: %s", fname, FLAC__StreamEncoderInitStatusString[status]);
+        FLAC__stream_encoder_delete (encoder_);
+        encoder_ = nullptr;
+        return -err;
+      }
+    filename_ = fname;
+    sample_rate_ = sample_rate;
+    n_channels_ = n_channels;
+    n_bits_ = n_bits;
+    n_values_ = 0;
+    return 0;
+  }
+  int // -errno
+  write (const float *floats, size_t n) override
+  {
+    assert_return (isopen(), -EINVAL);
+    const float scale = (1 << (n_bits_ - 1)) - 1;
+    const size_t offset = ibuffer_.size();
+    ibuffer_.resize (offset + n);
+    for (size_t i = 0; i < n; i++)
+      ibuffer_[offset + i] = bse_ftoi (CLAMP (floats[i], -1.0f, 1.0f) * scale);
+    const size_t n_frames = ibuffer_.size() / n_channels_;
+    if (!FLAC__stream_encoder_process_interleaved (encoder_, ibuffer_.data(), n_frames))
+      {
+        SDEBUG ("%s: FlacWriter::write: %s", filename_,
+                FLAC__StreamEncoderStateString[FLAC__stream_encoder_get_state (encoder_)]);
+        return -EIO;
+      }
+    ibuffer_.erase (ibuffer_.begin(), ibuffer_.begin() + n_frames * n_channels_);
+    n_values_ += n;
+    return 0;
+  }
+  int // -errno
+  close () override
+  {
+    return_unless (isopen(), 0);
+    const bool ok = FLAC__stream_encoder_finish (encoder_);
+    FLAC__stream_encoder_delete (encoder_);
+    encoder_ = nullptr;
+    ibuffer_.clear();
+    return ok ? 0 : -EIO;
+  }
+  bool
+  isopen () const override
+  {
+    return encoder_ != nullptr;
+  }
+  std::string
+  filename () const override
+  {
+    return filename_;
+  }
+};
+
+/// Open `fname` for encoding with `n_bits` of 8, 16, 24 or 32 (float), FLAC stores float as 24 bit.
+EncoderP
+Encoder::create (FileFormat format, const std::string &fname, uint n_channels, uint n_bits, uint sample_rate, int *errorp)
+{
+  int dummy;
+  int &error = errorp ? *errorp : dummy;
+  if (format == FileFormat::FLAC)
+    {
+      auto flac = std::make_shared<FlacWriter>();
+      error = flac->open (fname, n_channels, MIN (n_bits, 24), sample_rate);
+      return error ? nullptr : flac;
+    }
+  auto wav = std::make_shared<WavWriter>();
+  error = wav->open (fname, n_channels, n_bits, sample_rate);
+  return error ? nullptr : wav;
+}
+
 } // Bse::Snd
+
+#include "testing.hh"
+
+namespace { // Anon
+using namespace Bse;
+
+BSE_INTEGRITY_TEST (bse_snd_encoder_formats);
+static void
+bse_snd_encoder_formats ()
+{
+  const String dir = Path::join (Path::cache_home(), "bse-tests");
+  Path::mkdirs (dir);
+  float floats[2 * 1000];
+  for (uint i = 0; i < 1000; i++)
+    floats[2 * i] = floats[2 * i + 1] = sin (i * 0.01) * 0.5;
+  // float WAV, 'fmt ' needs to stay at offset 12 for loaders, the data follows the reserved 'ds64' space
+  const String wavname = Path::join (dir, string_format ("snd-encoder-%u.wav", getpid()));
+  Snd::EncoderP wav = Snd::Encoder::create (Snd::Encoder::format_from_filename (wavname), wavname, 2, 32, 48000);
+  TASSERT (wav && wav->isopen());
+  TCMP (wav->write (floats, 999), ==, 0);
+  TCMP (wav->write (floats + 999, 1001), ==, 0);
+  TCMP (wav->close(), ==, 0);
+  TCMP (wav->n_values(), ==, 2000);
+  String data = Path::stringread (wavname);
+  unlink (wavname.c_str());
+  TCMP (data.size(), ==, 80 + 2000 * 4);
+  TCMP (data.substr (0, 4), ==, "RIFF");
+  TCMP (data.substr (12, 4), ==, "fmt ");
+  TCMP (data.substr (36, 4), ==, "JUNK");
+  TCMP (data.substr (72, 4), ==, "data");
+  TCMP (data[20], ==, 3);       // IEEE float
+  TASSERT (memcmp (&data[80], floats, sizeof (float)) == 0 || __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__);
+  // FLAC, frames may be split across write() calls
+  const String flacname = Path::join (dir, string_format ("snd-encoder-%u.flac", getpid()));
+  TASSERT (Snd::Encoder::format_from_filename (flacname) == Snd::FileFormat::FLAC);
+  Snd::EncoderP flac = Snd::Encoder::create (Snd::FileFormat::FLAC, flacname, 2, 32, 48000);
+  TASSERT (flac && flac->n_bits() == 24);
+  TCMP (flac->write (floats, 999), ==, 0);
+  TCMP (flac->write (floats + 999, 1001), ==, 0);
+  TCMP (flac->close(), ==, 0);
+  data = Path::stringread (flacname);
+  unlink (flacname.c_str());
+  TCMP (data.substr (0, 4), ==, "fLaC");
+  TCMP (data.size(), <, 2000 * 3);
+}
+
+} // Anon
@@ -9,22 +9,49 @@ namespace Bse {
 /// This namespace provides IO facilities for various sound file formats.
 namespace Snd {
 
-class WavWriter {
-  std::string filename_;
-  int         fd_ = -1;
-  uint        n_bytes_ = 0;
+/// Sound file formats supported by Encoder.
+enum class FileFormat {
+  WAV = 1,      ///< RIFF/WAVE with 8, 16, 24 bit integer or 32 bit float samples, RF64 beyond 4GB.
+  FLAC,         ///< Lossless FLAC compression with up to 24 bit samples.
+};
+
+class Encoder;
+using EncoderP = std::shared_ptr<Encoder>;
+
+/// Streaming sound file encoder for interleaved float samples, not RT-Safe, use from a writer thread.
+class Encoder {
+protected:
+  uint64      n_values_ = 0;
   uint        n_bits_ = 0;
   uint        n_channels_ = 0;
   uint        sample_rate_ = 0;
-  int         wheader   (uint n_data_bytes);
+  explicit    Encoder  ();
+public:
+  virtual    ~Encoder  ();
+  virtual int write    (const float *floats, size_t n) = 0;     ///< Encode `n` interleaved samples, returns -errno.
+  virtual int close    () = 0;                                  ///< Complete file headers and close, returns -errno.
+  virtual bool        isopen   () const = 0;
+  virtual std::string filename () const = 0;
+  uint64      n_values () const     { return n_values_; }
+  uint        n_bits   () const     { return n_bits_; }
+  static FileFormat format_from_filename (const std::string &fname);
+  static EncoderP   create (FileFormat format, const std::string &fname, uint n_channels, uint n_bits, uint sample_rate, int *errorp = nullptr);
+};
+
+class WavWriter : public Encoder {
+  std::string filename_;
+  int         fd_ = -1;
+  uint64      n_bytes_ = 0;
+  std::vector<uint8> buffer_;
+  int         wheader   (uint64 n_data_bytes);
 public:
   explicit    WavWriter ();
   explicit    WavWriter (const std::string &fname, uint n_channels, uint n_bits, uint sample_rate);
   int         open      (const std::string &fname, uint n_channels, uint n_bits, uint sample_rate);
-  int         write     (const float *floats, uint n);
-  void        close     ();
-  bool        isopen    () const;
-  std::string filename  () const;
+  int         write     (const float *floats, size_t n) override;
+  int         close     () override;
+  bool        isopen    () const override;
+  std::string filename  () const override;
   virtual    ~WavWriter ();
 };
 
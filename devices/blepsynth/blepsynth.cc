@@ -2,6 +2,7 @@
 #include "bse/processor.hh"
 #include "bse/signalmath.hh"
 #include "bse/bsenote.hh"
+#include "bse/bseengine.hh"
 #include "devices/blepsynth/bleposc.hh"
 #include "devices/blepsynth/laddervcf.hh"
 #include "devices/blepsynth/linearsmooth.hh"
@@ -112,6 +113,11 @@ public:
   {
     return state_ == State::DONE;
   }
+  float
+  level() const
+  {
+    return level_;
+  }
   void
   compute_slope_params (int len, float start_x, float end_x, State param_state)
   {
@@ -242,7 +248,8 @@ class BlepSynth : public AudioSignal::Processor {
     enum State {
       IDLE,
       ON,
-      RELEASE
+      RELEASE,
+      FADE      // stolen or retired, ramped out quickly before reuse
       // TODO: SUSTAIN / pedal
     };
     // TODO : enum class MonoType
@@ -254,6 +261,12 @@ class BlepSynth : public AudioSignal::Processor {
     int          channel_     = 0;
     double       freq_        = 0;
 
+    float        fade_gain_   = 1;
+    float        fade_step_   = 0;
+    int          next_channel_ = 0;     // note to start once the FADE ramp is done
+    int          next_note_   = -1;
+    int          next_velocity_ = 0;
+
     LinearSmooth cutoff_smooth_;
     double       last_cutoff_;
     double       last_key_track_;
@@ -280,6 +293,7 @@ class BlepSynth : public AudioSignal::Processor {
   initialize () override
   {
     set_max_voices (32);
+    set_priority (DspPriority::REDUCIBLE);     // unison voices are halved under DSP overload
 
     auto oscparams = [&] (int o) {
       start_param_group (string_format ("Oscillator %d", o + 1));
@@ -372,6 +386,36 @@ class BlepSynth : public AudioSignal::Processor {
 
     return voice;
   }
+  size_t
+  sounding_voices() const
+  {
+    size_t n = 0;
+    for (auto voice : active_voices_)
+      if (voice->state_ != Voice::FADE || voice->next_note_ >= 0)
+        n++;
+    return n;
+  }
+  Voice *
+  quietest_voice()
+  {
+    Voice *quietest = nullptr;
+    for (auto voice : active_voices_)
+      if (voice->state_ != Voice::FADE && (!quietest || voice->envelope_.level() < quietest->envelope_.level()))
+        quietest = voice;
+    return quietest;
+  }
+  void
+  fade_voice (Voice *voice, int next_channel = 0, int next_note = -1, int next_velocity = 0)
+  {
+    // 5ms linear ramp, so voices taken away under DSP overload don't click
+    voice->state_ = Voice::FADE;
+    voice->fade_gain_ = 1;
+    voice->fade_step_ = 1.0 / std::max (1.0, sample_rate() * 0.005);
+    voice->next_channel_ = next_channel;
+    voice->next_note_ = next_note;
+    voice->next_velocity_ = next_velocity;
+    bse_engine_budget_stolen (1);
+  }
   void
   free_unused_voices()
   {
@@ -430,53 +474,67 @@ class BlepSynth : public AudioSignal::Processor {
 
     int unison_voices = bse_ftoi (get_param (params.unison_voices));
     unison_voices = CLAMP (unison_voices, 1, 16);
+    if (reduced_quality())
+      unison_voices = (unison_voices + 1) / 2; // halve unison under DSP overload
     osc.set_unison (unison_voices, get_param (params.unison_detune), get_param (params.unison_stereo) * 0.01);
   }
   void
   note_on (int channel, int midi_note, int vel)
   {
-    Voice *voice = alloc_voice();
-    if (voice)
+    // the engine lowers the polyphony cap if the DSP budget is exceeded, steal the quietest voice then
+    const size_t voice_cap = bse_engine_voice_cap (voices_.size());
+    if (voice_cap < voices_.size() && sounding_voices() >= voice_cap)
       {
-        voice->freq_ = bse_note_to_freq (Bse::MusicalTuning::OD_12_TET, midi_note);
-        voice->state_ = Voice::ON;
-        voice->channel_ = channel;
-        voice->midi_note_ = midi_note;
-
-        // Volume Envelope
-        /* TODO: we need non-linear translation between percent and time/level */
-        voice->envelope_.set_delay (0);
-        voice->envelope_.set_attack (get_param (pid_attack_) * 0.001);   /* time in milliseconds */
-        voice->envelope_.set_hold (0);
-        voice->envelope_.set_decay (get_param (pid_decay_) * 0.001);     /* time in milliseconds */
-        voice->envelope_.set_sustain (get_param (pid_sustain_));         /* percent */
-        voice->envelope_.set_release (get_param (pid_release_) * 0.001); /* time in milliseconds */
-        voice->envelope_.start (sample_rate());
-
-        // Filter Envelope
-        voice->fil_envelope_.set_delay (0);
-        voice->fil_envelope_.set_attack (get_param (pid_fil_attack_) * 0.001);   /* time in milliseconds */
-        voice->fil_envelope_.set_hold (0);
-        voice->fil_envelope_.set_decay (get_param (pid_fil_decay_) * 0.001);     /* time in milliseconds */
-        voice->fil_envelope_.set_sustain (get_param (pid_fil_sustain_));         /* percent */
-        voice->fil_envelope_.set_release (get_param (pid_fil_release_) * 0.001); /* time in milliseconds */
-        voice->fil_envelope_.set_shape (Envelope::Shape::LINEAR);
-        voice->fil_envelope_.start (sample_rate());
-
-        init_osc (voice->osc1_, voice->freq_);
-        init_osc (voice->osc2_, voice->freq_);
-
-        voice->osc1_.reset();
-        voice->osc2_.reset();
-        voice->vcf_.reset();
-
-        voice->cutoff_smooth_.reset (sample_rate(), 0.020);
-        voice->last_cutoff_ = -5000; // force reset
-
-        voice->cut_mod_smooth_.reset (sample_rate(), 0.020);
-        voice->last_cut_mod_ = -5000; // force reset
-        voice->last_key_track_ = -5000;
+        Voice *quietest = quietest_voice();
+        if (quietest)   // the note starts once the stolen voice is faded out
+          fade_voice (quietest, channel, midi_note, vel);
+        return;         // all voices are fading already, drop the note
       }
+    Voice *voice = alloc_voice();
+    if (voice)
+      start_voice (voice, channel, midi_note, vel);
+  }
+  void
+  start_voice (Voice *voice, int channel, int midi_note, int vel)
+  {
+    voice->freq_ = bse_note_to_freq (Bse::MusicalTuning::OD_12_TET, midi_note);
+    voice->state_ = Voice::ON;
+    voice->channel_ = channel;
+    voice->midi_note_ = midi_note;
+
+    // Volume Envelope
+    /* TODO: we need non-linear translation between percent and time/level */
+    voice->envelope_.set_delay (0);
+    voice->envelope_.set_attack (get_param (pid_attack_) * 0.001);   /* time in milliseconds */
+    voice->envelope_.set_hold (0);
+    voice->envelope_.set_decay (get_param (pid_decay_) * 0.001);     /* time in milliseconds */
+    voice->envelope_.set_sustain (get_param (pid_sustain_));         /* percent */
+    voice->envelope_.set_release (get_param (pid_release_) * 0.001); /* time in milliseconds */
+    voice->envelope_.start (sample_rate());
+
+    // Filter Envelope
+    voice->fil_envelope_.set_delay (0);
+    voice->fil_envelope_.set_attack (get_param (pid_fil_attack_) * 0.001);   /* time in milliseconds */
+    voice->fil_envelope_.set_hold (0);
+    voice->fil_envelope_.set_decay (get_param (pid_fil_decay_) * 0.001);     /* time in milliseconds */
+    voice->fil_envelope_.set_sustain (get_param (pid_fil_sustain_));         /* percent */
+    voice->fil_envelope_.set_release (get_param (pid_fil_release_) * 0.001); /* time in milliseconds */
+    voice->fil_envelope_.set_shape (Envelope::Shape::LINEAR);
+    voice->fil_envelope_.start (sample_rate());
+
+    init_osc (voice->osc1_, voice->freq_);
+    init_osc (voice->osc2_, voice->freq_);
+
+    voice->osc1_.reset();
+    voice->osc2_.reset();
+    voice->vcf_.reset();
+
+    voice->cutoff_smooth_.reset (sample_rate(), 0.020);
+    voice->last_cutoff_ = -5000; // force reset
+
+    voice->cut_mod_smooth_.reset (sample_rate(), 0.020);
+    voice->last_cut_mod_ = -5000; // force reset
+    voice->last_key_track_ = -5000;
   }
   void
   note_off (int channel, int midi_note)
@@ -489,6 +547,8 @@ class BlepSynth : public AudioSignal::Processor {
             voice->envelope_.stop();
             voice->fil_envelope_.stop();
           }
+        else if (voice->state_ == Voice::FADE && voice->next_note_ == midi_note && voice->next_channel_ == channel)
+          voice->next_note_ = -1;   // released before the stolen voice was faded out
       }
   }
   void
@@ -529,9 +589,16 @@ class BlepSynth : public AudioSignal::Processor {
           for (auto voice : active_voices_)
             if (voice->state_ == Voice::ON && voice->channel_ == ev.channel)
               note_off (voice->channel_, voice->midi_note_);
+            else if (voice->state_ == Voice::FADE && voice->next_channel_ == ev.channel)
+              voice->next_note_ = -1;
           break;
         default: ;
         }
+    // the cap is lowered while voices are sounding, retire the excess gradually, one voice per block
+    const size_t voice_cap = bse_engine_voice_cap (voices_.size());
+    if (sounding_voices() > voice_cap)
+      if (Voice *quietest = quietest_voice())
+        fade_voice (quietest);
 
     assert_return (n_ochannels (stereout_) == 2);
     bool   need_free = false;
@@ -626,13 +693,24 @@ class BlepSynth : public AudioSignal::Processor {
         voice->vcf_.run_block (n_frames, cutoff, resonance, inputs, outputs, true, true, freq_in, nullptr, nullptr, nullptr);
 
         // apply volume envelope
-        for (uint i = 0; i < n_frames; i++)
-          {
-            float amp = 0.25 * voice->envelope_.get_next();
-            left_out[i] += mix_left_out[i] * amp;
-            right_out[i] += mix_right_out[i] * amp;
-          }
-        if (voice->envelope_.done())
+        if (voice->state_ == Voice::FADE)
+          for (uint i = 0; i < n_frames; i++)
+            {
+              float amp = 0.25 * voice->envelope_.get_next() * voice->fade_gain_;
+              voice->fade_gain_ = std::max (voice->fade_gain_ - voice->fade_step_, 0.f);
+              left_out[i] += mix_left_out[i] * amp;
+              right_out[i] += mix_right_out[i] * amp;
+            }
+        else
+          for (uint i = 0; i < n_frames; i++)
+            {
+              float amp = 0.25 * voice->envelope_.get_next();
+              left_out[i] += mix_left_out[i] * amp;
+              right_out[i] += mix_right_out[i] * amp;
+            }
+        if (voice->state_ == Voice::FADE && voice->next_note_ >= 0 && (voice->fade_gain_ <= 0 || voice->envelope_.done()))
+          start_voice (voice, voice->next_channel_, voice->next_note_, voice->next_velocity_);   // reuse the silent voice
+        else if (voice->envelope_.done() || (voice->state_ == Voice::FADE && voice->fade_gain_ <= 0))
           {
             voice->state_ = Voice::IDLE;
             need_free = true;
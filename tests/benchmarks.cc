@@ -2,6 +2,9 @@
 #include <bse/testing.hh>
 #include <bse/unicode.hh>
 #include <bse/memory.hh>
+#include <bse/midievent.hh>
+#include <bse/bsemidireceiver.hh>
+#include <thread>
 #include <cmath>
 
 static constexpr size_t RUNS = 1;
@@ -369,3 +372,143 @@ aligned_allocator_bench31_fast_mem_alloc()
 TEST_BENCH (aligned_allocator_bench31_fast_mem_alloc);
 
 } // Anon
+
+// == EventStream Benchmarks ==
+namespace { // Anon
+using namespace Bse;
+using namespace Bse::AudioSignal;
+
+static constexpr size_t DENSE_EVENTS_PER_BLOCK = 10000;  // dense MIDI controller automation
+
+static void
+event_stream_bench()
+{
+  constexpr size_t N_PRODUCERS = 8;
+  EventStream estream;
+  std::vector<std::unique_ptr<EventStream>> producers;
+  for (size_t j = 0; j < N_PRODUCERS; j++)
+    producers.push_back (std::make_unique<EventStream> (DENSE_EVENTS_PER_BLOCK / N_PRODUCERS));
+  const Event cc = make_control (1, 7, 0.5);
+  auto loop_append = [&] () {
+    estream.clear();
+    for (size_t i = 0; i < DENSE_EVENTS_PER_BLOCK; i++)
+      estream.append (int (i * 128 / DENSE_EVENTS_PER_BLOCK) - 128, cc);
+  };
+  Bse::Test::Timer timer (MAXTIME);
+  double bench_time = timer.benchmark (loop_append);
+  Bse::printerr ("  BENCH    EventStream::append:          %11.1f MEvents/s\n", DENSE_EVENTS_PER_BLOCK / bench_time / M);
+  TCMP (estream.size(), ==, DENSE_EVENTS_PER_BLOCK);
+  // every 7th event is displaced backwards, as with late producers
+  auto loop_unsorted = [&] () {
+    estream.clear();
+    for (size_t i = 0; i < DENSE_EVENTS_PER_BLOCK; i++)
+      estream.append_unsorted (int (i * 128 / DENSE_EVENTS_PER_BLOCK) - 128 + (i % 7 == 3 ? -5 : 0), cc);
+    estream.ensure_order();
+  };
+  bench_time = timer.benchmark (loop_unsorted);
+  Bse::printerr ("  BENCH    EventStream::ensure_order:    %11.1f MEvents/s\n", DENSE_EVENTS_PER_BLOCK / bench_time / M);
+  TCMP (estream.size(), ==, DENSE_EVENTS_PER_BLOCK);
+  // reversed input is the worst case for any comparison based fixup
+  auto loop_reversed = [&] () {
+    estream.clear();
+    for (size_t i = 0; i < DENSE_EVENTS_PER_BLOCK; i++)
+      estream.append_unsorted (127 - int (i * 128 / DENSE_EVENTS_PER_BLOCK), cc);
+    estream.ensure_order();
+  };
+  bench_time = timer.benchmark (loop_reversed);
+  Bse::printerr ("  BENCH    EventStream::ensure_order-rev:%11.1f MEvents/s\n", DENSE_EVENTS_PER_BLOCK / bench_time / M);
+  TCMP (estream.size(), ==, DENSE_EVENTS_PER_BLOCK);
+  for (size_t j = 0; j < N_PRODUCERS; j++)
+    for (size_t i = 0; i < DENSE_EVENTS_PER_BLOCK / N_PRODUCERS; i++)
+      producers[j]->append (int (i * N_PRODUCERS * 128 / DENSE_EVENTS_PER_BLOCK) - 128, cc);
+  const EventStream *pstreams[N_PRODUCERS];
+  for (size_t j = 0; j < N_PRODUCERS; j++)
+    pstreams[j] = producers[j].get();
+  auto loop_merge = [&] () {
+    estream.clear();
+    estream.merge (pstreams, N_PRODUCERS);
+  };
+  bench_time = timer.benchmark (loop_merge);
+  Bse::printerr ("  BENCH    EventStream::merge:           %11.1f MEvents/s\n", DENSE_EVENTS_PER_BLOCK / bench_time / M);
+  TCMP (estream.size(), ==, DENSE_EVENTS_PER_BLOCK);
+}
+TEST_BENCH (event_stream_bench);
+
+} // Anon
+
+// == MidiReceiver Tests ==
+namespace { // Anon
+
+static void
+midi_receiver_contention_bench()
+{
+  // concurrently playing songs feed separate receivers from separate threads
+  constexpr size_t N_SONGS = 8, N_EVENTS = 4096;
+  std::vector<BseMidiReceiver*> receivers;
+  for (size_t j = 0; j < N_SONGS; j++)
+    receivers.push_back (bse_midi_receiver_new ("benchmark"));
+  auto play_song = [] (BseMidiReceiver *receiver) {
+    for (size_t i = 0; i < N_EVENTS; i++)
+      {
+        const float value = (i & 0xff) / 255.0;
+        bse_midi_receiver_push_event (receiver, bse_midi_event_signal (1, i, Bse::MidiSignal::PITCH_BEND, value));
+        if (i % 64 == 63)
+          bse_midi_receiver_process_events (receiver, i);
+      }
+    bse_midi_receiver_process_events (receiver, N_EVENTS);
+  };
+  auto loop_serial = [&] () {
+    for (size_t j = 0; j < N_SONGS; j++)
+      play_song (receivers[j]);
+  };
+  auto loop_concurrent = [&] () {
+    std::vector<std::thread> threads;
+    for (size_t j = 0; j < N_SONGS; j++)
+      threads.push_back (std::thread (play_song, receivers[j]));
+    for (auto &thread : threads)
+      thread.join();
+  };
+  Bse::Test::Timer timer (MAXTIME);
+  double bench_time = timer.benchmark (loop_serial);
+  Bse::printerr ("  BENCH    MidiReceiver, %zu songs serial:    %11.1f MEvents/s\n", N_SONGS, N_SONGS * N_EVENTS / bench_time / M);
+  bench_time = timer.benchmark (loop_concurrent);
+  Bse::printerr ("  BENCH    MidiReceiver, %zu songs threaded:  %11.1f MEvents/s\n", N_SONGS, N_SONGS * N_EVENTS / bench_time / M);
+  for (BseMidiReceiver *receiver : receivers)
+    {
+      TASSERT (!bse_midi_receiver_voices_pending (receiver, 1));
+      bse_midi_receiver_unref (receiver);
+    }
+}
+TEST_BENCH (midi_receiver_contention_bench);
+
+static void
+midi_receiver_farm_sharing()
+{
+  // live MIDI input reaches all farm residents without per receiver event copies
+  constexpr size_t N_PROJECTS = 6, N_EVENTS = 100;
+  std::vector<BseMidiReceiver*> receivers;
+  for (size_t j = 0; j < N_PROJECTS; j++)
+    {
+      receivers.push_back (bse_midi_receiver_new ("farm-test"));
+      bse_midi_receiver_enter_farm (receivers.back());
+    }
+  const Bse::uint64 allocations = bse_midi_event_allocations();
+  for (size_t i = 0; i < N_EVENTS; i++)
+    {
+      BseMidiEvent *event = bse_midi_event_signal (1, i, Bse::MidiSignal::PITCH_BEND, 0.5);
+      bse_midi_receiver_farm_distribute_event (event);
+      bse_midi_free_event (event);
+    }
+  const double per_event = (bse_midi_event_allocations() - allocations) / double (N_EVENTS);
+  TCMP (per_event, ==, 1.0);    // one allocation by the input, none per resident
+  bse_midi_receiver_farm_process_events (N_EVENTS);
+  for (BseMidiReceiver *receiver : receivers)
+    {
+      TASSERT (!bse_midi_receiver_voices_pending (receiver, 1));
+      bse_midi_receiver_leave_farm (receiver);
+      bse_midi_receiver_unref (receiver);
+    }
+}
+TEST_ADD (midi_receiver_farm_sharing);
+
+} // Anon
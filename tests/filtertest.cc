@@ -788,3 +788,36 @@ generic_filter_tests (const char        *test_name,
     }
   TPASS ("%s", test_name);
 }
+
+static void
+test_biquad_lanes ()
+{
+  const uint n_lanes = 7, n_values = 128;
+  GslBiquadFilter single[n_lanes], lanes[n_lanes];
+  GslBiquadFilter *lane_filters[n_lanes];
+  std::vector<float> input (n_lanes * n_values), output1 (n_lanes * n_values), output2 (n_lanes * n_values);
+  const float *x[n_lanes];
+  float *y[n_lanes];
+  for (uint l = 0; l < n_lanes; l++)
+    {
+      GslBiquadConfig config;
+      gsl_biquad_config_init (&config, GslBiquadType (GSL_BIQUAD_RESONANT_LOWPASS + l % 2), GSL_BIQUAD_NORMALIZE_PASSBAND);
+      gsl_biquad_config_setup (&config, 0.05 + 0.1 * l, 3, 0);
+      gsl_biquad_filter_config (&single[l], &config, TRUE);
+      lanes[l] = single[l];
+      lane_filters[l] = &lanes[l];
+      for (uint i = 0; i < n_values; i++)
+        input[l * n_values + i] = g_random_double_range (-1, +1);
+      x[l] = &input[l * n_values];
+      y[l] = &output2[l * n_values];
+    }
+  for (uint j = 0; j < 3; j++)
+    {
+      for (uint l = 0; l < n_lanes; l++)
+        gsl_biquad_filter_eval (&single[l], n_values, x[l], &output1[l * n_values]);
+      gsl_biquad_filter_eval_lanes (n_lanes, lane_filters, n_values, x, y);
+      for (uint k = 0; k < n_lanes * n_values; k++)
+        TCMP (fabs (output1[k] - output2[k]), <, 1e-6);  // allow for FMA contraction differences
+    }
+}
+TEST_ADD (test_biquad_lanes);
@@ -6,6 +6,7 @@
 #include <bse/bsecxxplugin.hh> // for generated types
 #include "jsonipc/testjsonipc.cc" // test_jsonipc
 #include <bse/signalmath.hh>
+#include <bse/gsloscillator.hh>
 
 static void
 test_jsonipc_functions()
@@ -344,3 +345,47 @@ main (gint   argc,
   return 0;
 }
 #endif
+
+static void
+test_osc_lanes ()
+{
+  const uint n_lanes = 6, n_values = 128;
+  const float table_freqs[] = { 27.5, 110, 440, 1760, 7040 };
+  GslOscTable *table = gsl_osc_table_create (48000, GSL_OSC_WAVE_SAW_FALL, bse_window_blackman, G_N_ELEMENTS (table_freqs), table_freqs);
+  GslOscData single[n_lanes], lanes[n_lanes];
+  GslOscData *lane_oscs[n_lanes];
+  std::vector<float> freqs (n_lanes * n_values), output1 (n_lanes * n_values), output2 (n_lanes * n_values);
+  const float *ifreq[n_lanes];
+  float *mono_out[n_lanes];
+  for (uint l = 0; l < n_lanes; l++)
+    {
+      GslOscConfig config = { 0, };
+      config.table = table;
+      config.cfreq = 220 + 110 * l;
+      config.transpose_factor = 1.0;
+      config.fine_tune = int (l * 7) - 20;
+      config.self_fm_strength = l == 4 ? 0.1 : 0;       // processed individually
+      gsl_osc_reset (&single[l]);
+      gsl_osc_config (&single[l], &config);
+      gsl_osc_reset (&lanes[l]);
+      gsl_osc_config (&lanes[l], &config);
+      lane_oscs[l] = &lanes[l];
+      // odd lanes sweep across wave table boundaries, even lanes use the configured frequency
+      for (uint i = 0; i < n_values; i++)
+        freqs[l * n_values + i] = BSE_SIGNAL_FROM_FREQ (100.0 * (1 + l) * (1 + i / 32));
+      ifreq[l] = l & 1 ? &freqs[l * n_values] : NULL;
+      mono_out[l] = &output2[l * n_values];
+    }
+  for (uint j = 0; j < 3; j++)
+    {
+      for (uint l = 0; l < n_lanes; l++)
+        gsl_osc_process (&single[l], n_values, ifreq[l], NULL, NULL, &output1[l * n_values], NULL);
+      gsl_osc_process_lanes (n_lanes, lane_oscs, n_values, ifreq, mono_out);
+      for (uint k = 0; k < n_lanes * n_values; k++)
+        TCMP (fabs (output1[k] - output2[k]), <, 1e-6);  // allow for FMA contraction differences
+      for (uint l = 0; l < n_lanes; l++)
+        TCMP (single[l].cur_pos, ==, lanes[l].cur_pos);
+    }
+  gsl_osc_table_free (table);
+}
+TEST_ADD (test_osc_lanes);
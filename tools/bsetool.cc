@@ -1,6 +1,10 @@
 // Licensed GNU LGPL v2.1 or later: http://www.gnu.org/licenses/lgpl.html
 #include "bsetool.hh"
 #include <bse/bse.hh>
+#include <bse/bseengine.hh>
+#include <bse/bsemidireceiver.hh>
+#include <bse/enginecapture.hh>
+#include <bse/processor.hh>
 #include <sys/resource.h>
 #include <unistd.h>
 #include <stdio.h>
@@ -308,6 +312,167 @@ render2wav (const ArgParser &ap)
 static CommandRegistry render2wav_cmd (render2wav_options, render2wav, "render2wav", "Render audio from a .bse file into a WAV file");
 
 
+// == replay ==
+static ArgDescription replay_options[] = {
+  { "-o, --output",   "<capture-file>", "Capture file for the replayed workload, defaults to <capture-file>.replay", "" },
+  { "-d, --driver",   "<pcm-driver>",   "Render offline with 'null' or at the pace of a sound card with 'simclock'", "null" },
+  { "<capture-file>", "",               "Engine capture recorded with Server.start_engine_capture()", "" },
+  { "<bse-file>",     "",               "The BSE file that was played during the capture", "" },
+};
+
+struct BlockTimings {
+  size_t n_blocks = 0, n_late = 0;
+  double avg_usecs = 0, p99_usecs = 0, max_usecs = 0;
+};
+
+static BlockTimings
+block_timings (const std::vector<EngineCapture::Record> &records, double block_usecs)
+{
+  std::vector<double> usecs;
+  for (const auto &rec : records)
+    if (rec.kind == EngineCapture::Kind::BLOCK)
+      usecs.push_back (rec.value * 0.001);
+  BlockTimings bt;
+  return_unless (usecs.size(), bt);
+  std::sort (usecs.begin(), usecs.end());
+  bt.n_blocks = usecs.size();
+  for (double u : usecs)
+    {
+      bt.avg_usecs += u;
+      bt.n_late += u > block_usecs;
+    }
+  bt.avg_usecs /= usecs.size();
+  bt.p99_usecs = usecs[usecs.size() * 99 / 100];
+  bt.max_usecs = usecs.back();
+  return bt;
+}
+
+static String
+replay (const ArgParser &ap)
+{
+  const String capfile = ap["capture-file"];
+  const String bsefile = ap["bse-file"];
+  const String outfile = ap["output"].empty() ? capfile + ".replay" : ap["output"];
+  const String driver = ap["driver"];
+  if (kvpair_key (driver) != "null" && kvpair_key (driver) != "simclock")
+    return string_format ("invalid PCM driver for replay: %s", driver);
+  EngineCapture::Header header;
+  std::vector<EngineCapture::Record> records;
+  if (!EngineCapture::read (capfile, header, records))
+    return string_format ("%s: failed to read engine capture", capfile);
+  auto project = BSE_SERVER.create_project (bsefile);
+  project->auto_deactivate (0);
+  auto err = project->restore_from_file (bsefile);
+  if (err != 0)
+    return bse_error_blurb (err);
+  // render without a sound card, 'null' renders as fast as possible
+  BSE_SERVER.override_pcm_driver (driver);
+  err = project->play();
+  BSE_SERVER.override_pcm_driver ("");
+  if (err != 0)
+    return bse_error_blurb (err);
+  if (header.sample_rate != bse_engine_sample_freq() || header.block_size != bse_engine_block_size())
+    printerr ("%s: warning: captured with %u Hz and block size %u, replaying with %u Hz and block size %u\n", capfile,
+              header.sample_rate, header.block_size, bse_engine_sample_freq(), bse_engine_block_size());
+  if (header.n_dropped)
+    printerr ("%s: warning: %u records were dropped during the capture, the replayed workload is incomplete\n", capfile, header.n_dropped);
+  if (!EngineCapture::start (outfile))
+    return string_format ("%s: failed to start engine capture", outfile);
+  printq ("Replaying %u records from %s with %s...\n", records.size(), capfile, driver);
+  // inject records at their captured stamps relative to the replay start, the lookahead is generous
+  // enough for the null driver to render faster than realtime without catching up with the injection
+  const uint64 lookahead = bse_engine_sample_freq();
+  const uint64 base = Bse::TickStamp::current() + lookahead;
+  const uint64 end = base + (records.empty() ? 0 : records.back().stamp);
+  size_t n_midi = 0, n_trans = 0, n_params = 0, n_recreated = 0, n_unmatched = 0, n_late = 0;
+  for (size_t next = 0; next < records.size() || Bse::TickStamp::current() < end; )
+    {
+      const uint64 now = Bse::TickStamp::current();
+      for (; next < records.size() && base + records[next].stamp <= now + lookahead; next++)
+        {
+          const EngineCapture::Record &rec = records[next];
+          n_late += base + rec.stamp <= now;
+          if (rec.kind == EngineCapture::Kind::MIDI)
+            {
+              BseMidiEvent *event = bse_midi_alloc_event();
+              event->status = BseMidiEventType (rec.id16);
+              event->channel = rec.channel;
+              event->delta_time = base + rec.stamp;
+              switch (event->status)
+                {
+                case BSE_MIDI_NOTE_ON: case BSE_MIDI_NOTE_OFF: case BSE_MIDI_KEY_PRESSURE:
+                  event->data.note.frequency = rec.value;
+                  event->data.note.velocity = rec.value2;
+                  break;
+                case BSE_MIDI_CONTROL_CHANGE: case BSE_MIDI_X_CONTINUOUS_CHANGE:
+                  event->data.control.control = rec.id32;
+                  event->data.control.value = rec.value;
+                  break;
+                case BSE_MIDI_PROGRAM_CHANGE:   event->data.program = rec.id32;         break;
+                case BSE_MIDI_CHANNEL_PRESSURE: event->data.intensity = rec.value;      break;
+                case BSE_MIDI_PITCH_BEND:       event->data.pitch_bend = rec.value;     break;
+                default: ;
+                }
+              bse_midi_receiver_farm_distribute_event (event);
+              bse_midi_free_event (event);
+              bse_midi_receiver_farm_process_events (base + rec.stamp);
+              n_midi++;
+            }
+          else if ((rec.kind == EngineCapture::Kind::TRANS || rec.kind == EngineCapture::Kind::PARAM) &&
+                   EngineCapture::Origin (rec.channel) != EngineCapture::Origin::API)
+            n_recreated++;      // issued by the sequencer, MIDI receivers or project loading, playback recreates these
+          else if (rec.kind == EngineCapture::Kind::TRANS)
+            {
+              // job closures cannot be serialized, reproduce the job processing load with NOP jobs
+              BseTrans *trans = bse_trans_open();
+              for (size_t i = 0; i < rec.id16; i++)
+                bse_trans_add (trans, bse_job_nop());
+              bse_trans_commit_delayed (trans, base + rec.stamp);
+              n_trans++;
+            }
+          else if (rec.kind == EngineCapture::Kind::PARAM)
+            {
+              // processors are identified by URI and order of instantiation, which holds for a freshly loaded project
+              AudioSignal::ProcessorP proc = AudioSignal::Processor::registry_instance (rec.key, rec.id16);
+              if (!proc)
+                {
+                  n_unmatched++;
+                  continue;
+                }
+              const uint32 paramid = rec.id32;
+              const double value = rec.value;
+              BSE_SERVER.commit_job ([proc, paramid, value] () { proc->set_param (paramid, value); }, base + rec.stamp);
+              n_params++;
+            }
+        }
+      if (g_main_context_pending (bse_main_context))
+        g_main_context_iteration (bse_main_context, false);
+      else
+        usleep (1000);
+    }
+  EngineCapture::stop();
+  project->stop();
+  // compare block timings
+  EngineCapture::Header rheader;
+  std::vector<EngineCapture::Record> rrecords;
+  if (!EngineCapture::read (outfile, rheader, rrecords))
+    return string_format ("%s: failed to read engine capture", outfile);
+  const double block_usecs = header.block_size * 1000000.0 / MAX (1, header.sample_rate);
+  const BlockTimings captured = block_timings (records, block_usecs);
+  const BlockTimings replayed = block_timings (rrecords, block_usecs);
+  printout ("# injected: midi=%u transactions=%u params=%u (recreated by playback: %u, unmatched params: %u, late records: %u)\n",
+            n_midi, n_trans, n_params, n_recreated, n_unmatched, n_late);
+  printout ("%-10s %8s %8s %10s %10s %10s\n", "# timing", "blocks", "late", "avg[us]", "p99[us]", "max[us]");
+  printout ("%-10s %8u %8u %10.1f %10.1f %10.1f\n", "captured", captured.n_blocks, captured.n_late,
+            captured.avg_usecs, captured.p99_usecs, captured.max_usecs);
+  printout ("%-10s %8u %8u %10.1f %10.1f %10.1f\n", "replayed", replayed.n_blocks, replayed.n_late,
+            replayed.avg_usecs, replayed.p99_usecs, replayed.max_usecs);
+  return "";
+}
+
+static CommandRegistry replay_cmd (replay_options, replay, "replay", "Replay an engine capture and compare block timings");
+
+
 // == check-load ==
 static ArgDescription check_load_options[] = {
   { "<bse-file>",    "",          "The BSE file to load and check for validity", "" },